@@ -1,5 +1,6 @@
 #include "Beamline.h"
 
+#include <atomic>
 #include <sstream>
 #include <stack>
 #include <stdexcept>
@@ -12,7 +13,8 @@ namespace RAYX {
 
 namespace {
 std::string getUniqueUnnamedGroupName() {
-    static size_t counter = 0;
+    // beamlines may be imported on multiple threads concurrently, e.g. by rayx -j
+    static std::atomic<size_t> counter = 0;
     return std::format("<unnamed_group_{}>", counter++);
 }
 }  // unnamed namespace
@@ -262,13 +264,52 @@ MaterialTables Group::calcMinimalMaterialTables() const {
     auto elements = getElements();
     std::array<bool, 92> relevantMaterials{};
     relevantMaterials.fill(false);
-    for (const auto& elemPtr : elements) {
-        int material = static_cast<int>(elemPtr->getMaterial());  // assuming getMaterial() exists
+    const auto addMaterial = [&](const int material) {
         if (material >= 1 && material <= 92) { relevantMaterials[material - 1] = true; }
+    };
+    for (const auto& elemPtr : elements) {
+        addMaterial(static_cast<int>(elemPtr->getMaterial()));  // assuming getMaterial() exists
+
+        // coating materials are looked up alongside the substrate
+        const auto coating = elemPtr->getCoating();
+        if (coating.is<Coating::OneCoating>()) {
+            addMaterial(coating.get<Coating::OneCoating>().material);
+        } else if (coating.is<Coating::MultilayerCoating>()) {
+            const auto& mlCoating = coating.get<Coating::MultilayerCoating>();
+            for (int i = 0; i < mlCoating.numLayers; ++i) { addMaterial(mlCoating.material[i]); }
+        }
     }
     return loadMaterialTables(relevantMaterials);
 }
 
+std::optional<glm::dvec2> Group::calcEnergyRange() const {
+    std::optional<glm::dvec2> range;
+    const auto addRange = [&](const double a, const double b) {
+        const auto sourceRange = glm::dvec2(std::min(a, b), std::max(a, b));
+        range                  = range ? glm::dvec2(std::min(range->x, sourceRange.x), std::max(range->y, sourceRange.y)) : sourceRange;
+    };
+
+    for (const auto* source : getSources()) {
+        // these sources have no energy distribution
+        if (source->getType() == ElementType::DipoleSource || source->getType() == ElementType::RayListSource) continue;
+
+        std::visit(
+            [&]<typename T>(const T& distribution) {
+                if constexpr (std::is_same_v<T, HardEdge> || std::is_same_v<T, SeparateEnergies>) {
+                    addRange(distribution.m_centerEnergy - distribution.m_energySpread / 2.0,
+                             distribution.m_centerEnergy + distribution.m_energySpread / 2.0);
+                } else if constexpr (std::is_same_v<T, SoftEdge>) {
+                    addRange(distribution.m_centerEnergy - 3.0 * distribution.m_sigma, distribution.m_centerEnergy + 3.0 * distribution.m_sigma);
+                } else if constexpr (std::is_same_v<T, DatFile>) {
+                    for (const auto& line : distribution.m_Lines) { addRange(line.m_energy, line.m_energy); }
+                }
+            },
+            source->getEnergyDistribution());
+    }
+
+    return range;
+}
+
 void Group::accumulateLightSourcesWorldPositions(const Group& group, const glm::dvec4& parentPos, const glm::dmat4& parentOri,
                                                  std::vector<glm::dvec4>& positions) {
     glm::dvec4 currentPos = parentOri * group.getPosition() + parentPos;
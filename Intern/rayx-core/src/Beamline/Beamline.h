@@ -3,6 +3,7 @@
 #include <functional>
 #include <glm.hpp>
 #include <memory>
+#include <optional>
 #include <variant>
 #include <vector>
 
@@ -130,6 +131,16 @@ class RAYX_API Group : public BeamlineNode {
      */
     MaterialTables calcMinimalMaterialTables() const;
 
+    // TODO: this should not be part of the API
+    /**
+     * @brief Calculates the range of photon energies emitted by the sources in this Group.
+     *
+     * Sources without an energy distribution (DipoleSource, RayListSource) are ignored. Normal distributions are cut off at 3 sigma.
+     *
+     * @return dvec2(min, max) of the energy in eV, or std::nullopt if no source has an energy distribution.
+     */
+    std::optional<glm::dvec2> calcEnergyRange() const;
+
     // TODO: this should not be part of the API
     /**
      * @brief Recursively converts all DesignElement nodes into OpticalElements with full transforms.
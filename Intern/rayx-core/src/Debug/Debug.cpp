@@ -61,7 +61,14 @@ Exit::Exit(const std::string& filename, int line) : filename(filename), line(lin
     formatDebugMsg(filename, line, std::cerr);
 }
 
-Exit::~Exit() {
+namespace {
+thread_local std::string exitMessage;
+}  // unnamed namespace
+
+const std::string& getExitMessage() { return exitMessage; }
+
+Exit::~Exit() noexcept(false) {
+    exitMessage = message.str();
     std::cerr << "\n";
     formatDebugMsg(filename, line, std::cerr);
     std::cerr << "Terminating...\033[0m" << std::endl;  // color reset
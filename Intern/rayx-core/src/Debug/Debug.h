@@ -22,6 +22,7 @@
 #include <array>
 #include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -113,18 +114,24 @@ struct RAYX_API Warn {
 struct RAYX_API Exit {
     std::string filename;
     int line;
+    std::ostringstream message;
 
     Exit(const std::string& filename, int line);
 
-    ~Exit();
+    // error_fn may throw, to recover from the fatal error, e.g. to fail a single job of rayx --serve
+    ~Exit() noexcept(false);
 
     template <typename T>
     Exit& operator<<(T t) {
         std::cerr << t;
+        message << t;
         return *this;
     }
 };
 
+// the message of the last RAYX_EXIT on the calling thread. allows error_fn to pass it on
+RAYX_API const std::string& getExitMessage();
+
 // The implementation of RAYX_VERB
 struct RAYX_API Verb {
     Verb(std::string filename, int line);
@@ -144,7 +151,7 @@ struct RAYX_API IgnoreLog{template <typename T> IgnoreLog & operator<<(T){return
 ;
 
 // the function to be called after RAYX_EXIT happens.
-// normally exit(1), but in the test suite it's ADD_FAILURE.
+// normally exit(1), but in the test suite it's ADD_FAILURE. rayx --serve throws, to fail only the current job.
 extern void RAYX_API (*error_fn)();
 
 // Defines the actual RAYX logging macros using the structs defined above.
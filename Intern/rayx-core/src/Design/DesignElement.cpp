@@ -1,5 +1,6 @@
 #include "DesignElement.h"
 
+#include <atomic>
 #include <iostream>
 #include <memory>
 
@@ -10,7 +11,8 @@ namespace RAYX {
 
 namespace {
 std::string getUniqueUnnamedElementName() {
-    static size_t counter = 0;
+    // beamlines may be imported on multiple threads concurrently, e.g. by rayx -j
+    static std::atomic<size_t> counter = 0;
     return std::format("<unnamed_element_{}>", counter++);
 }
 }  // unnamed namespace
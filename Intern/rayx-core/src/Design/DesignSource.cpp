@@ -1,15 +1,18 @@
 #include "DesignSource.h"
 
+#include <atomic>
 #include <filesystem>
 #include <memory>
 
 #include "Debug/Debug.h"
+#include "Writer/RayListReader.h"
 
 namespace RAYX {
 
 namespace {
 std::string getUniqueUnnamedSourceName() {
-    static size_t counter = 0;
+    // beamlines may be imported on multiple threads concurrently, e.g. by rayx -j
+    static std::atomic<size_t> counter = 0;
     return std::format("<unnamed_source_{}>", counter++);
 }
 }  // unnamed namespace
@@ -295,4 +298,13 @@ void DesignSource::setRayList(std::shared_ptr<Rays>& rays) { m_elementParameters
 
 std::shared_ptr<Rays> DesignSource::getRayList() const { return m_elementParameters["rayList"].as_rayList(); }
 
+void DesignSource::setRayListFile(const std::filesystem::path& filepath) { m_elementParameters["rayListFile"] = filepath.string(); }
+
+std::filesystem::path DesignSource::getRayListFile() const { return m_elementParameters["rayListFile"].as_string(); }
+
+std::unique_ptr<RayListReader> DesignSource::createRayListReader() const {
+    if (m_elementParameters.hasKey("rayListFile")) return RAYX::createRayListReader(getRayListFile());
+    return RAYX::createRayListReader(getRayList());
+}
+
 }  // namespace RAYX
@@ -1,10 +1,14 @@
 #pragma once
 
+#include <filesystem>
+
 #include "Beamline/Node.h"
 #include "Value.h"
 
 namespace RAYX {
 
+class RayListReader;
+
 class RAYX_API DesignSource : public BeamlineNode {
   public:
     DesignSource();
@@ -144,6 +148,13 @@ class RAYX_API DesignSource : public BeamlineNode {
     void setRayList(Rays rays);
     void setRayList(std::shared_ptr<Rays>& rays);
     std::shared_ptr<Rays> getRayList() const;
+
+    /// the ray list is read from the file in slices while tracing, instead of being held in memory
+    void setRayListFile(const std::filesystem::path& filepath);
+    std::filesystem::path getRayListFile() const;
+
+    /// creates a reader of the ray list, either from the ray list file or from the ray list in memory
+    std::unique_ptr<RayListReader> createRayListReader() const;
 };
 
 }  // namespace RAYX
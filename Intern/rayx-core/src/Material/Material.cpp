@@ -6,6 +6,12 @@
 #include <strings.h>
 #endif
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <mutex>
+
 #include "Debug/Debug.h"
 #include "NffTable.h"
 #include "PalikTable.h"
@@ -54,6 +60,27 @@ bool materialFromString(const char* matname, Material* out) {
     return false;
 }
 
+namespace {
+
+/// loading a table parses a text file, so every table is loaded once per process and kept. beamlines may be imported and traced on different
+/// threads, so the tables are guarded
+template <typename Table>
+const Table& loadTableOnce(const Material material) {
+    static std::mutex mutex;
+    static std::map<Material, Table> tables;  // references to the tables stay valid, when other tables are inserted
+
+    std::lock_guard lock(mutex);
+    auto it = tables.find(material);
+    if (it == tables.end()) {
+        auto table = Table{};
+        if (!Table::load(getMaterialName(material), &table)) RAYX_EXIT << "could not load table of material " << getMaterialName(material) << "!";
+        it = tables.emplace(material, std::move(table)).first;
+    }
+    return it->second;
+}
+
+}  // unnamed namespace
+
 MaterialTables loadMaterialTables(std::array<bool, 92> relevantMaterials) {
     MaterialTables out;
 
@@ -64,11 +91,9 @@ MaterialTables loadMaterialTables(std::array<bool, 92> relevantMaterials) {
     for (size_t i = 0; i < mats.size(); i++) {
         out.indices.push_back(out.materials.size());
         if (relevantMaterials[i]) {
-            PalikTable t;
-
-            if (!PalikTable::load(getMaterialName(mats[i]), &t)) { RAYX_EXIT << "could not load PalikTable!"; }
+            const auto& t = loadTableOnce<PalikTable>(mats[i]);
 
-            for (auto x : t.m_Lines) {
+            for (const auto& x : t.m_Lines) {
                 out.materials.push_back(x.m_energy);
                 out.materials.push_back(x.m_n);
                 out.materials.push_back(x.m_k);
@@ -80,11 +105,9 @@ MaterialTables loadMaterialTables(std::array<bool, 92> relevantMaterials) {
     for (size_t i = 0; i < mats.size(); i++) {
         out.indices.push_back(out.materials.size());
         if (relevantMaterials[i]) {
-            NffTable t;
+            const auto& t = loadTableOnce<NffTable>(mats[i]);
 
-            if (!NffTable::load(getMaterialName(mats[i]), &t)) { RAYX_EXIT << "could not load NffTable!"; }
-
-            for (auto x : t.m_Lines) {
+            for (const auto& x : t.m_Lines) {
                 out.materials.push_back(x.m_energy);
                 out.materials.push_back(x.m_f1);
                 out.materials.push_back(x.m_f2);
@@ -106,4 +129,172 @@ MaterialTables loadMaterialTables(std::array<bool, 92> relevantMaterials) {
     return out;
 }
 
+namespace {
+
+// linear interpolation in log(energy) between the entries of a Palik or Nff table. `entryAt(i)` returns the energy and refractive index of
+// entry i. energies outside of the table are clamped to the first or last entry.
+template <typename EntryAt>
+complex::Complex interpolateEntries(const double energy, const int count, EntryAt entryAt) {
+    const auto [firstEnergy, firstIor] = entryAt(0);
+    if (count == 1 || energy <= firstEnergy) return firstIor;
+
+    const auto [lastEnergy, lastIor] = entryAt(count - 1);
+    if (energy >= lastEnergy) return lastIor;
+
+    int low  = 0;          // <= energy
+    int high = count - 1;  // > energy
+    while (high - low > 1) {
+        const int center = (low + high) / 2;
+        if (energy < entryAt(center).first) {
+            high = center;
+        } else {
+            low = center;
+        }
+    }
+
+    const auto [lowEnergy, lowIor]   = entryAt(low);
+    const auto [highEnergy, highIor] = entryAt(high);
+    if (highEnergy <= lowEnergy) return highIor;
+
+    const auto t = std::log(energy / lowEnergy) / std::log(highEnergy / lowEnergy);
+    return lowIor + (highIor - lowIor) * t;
+}
+
+// same as getRefractiveIndex, but interpolates between the entries instead of picking the next lower one.
+// the Palik table is extended by a factor of `palikMargin` in energy on both sides. this way, grid cells that overlap with the border of the
+// Palik table interpolate the Palik data, and not the Nff data outside of its range.
+complex::Complex interpolateRefractiveIndex(const double energy, const int material, const MaterialTables& materialTables,
+                                            const double palikMargin) {
+    const auto* indices = materialTables.indices.data();
+    const auto* table   = materialTables.materials.data();
+
+    const auto numPalikEntries = getPalikEntryCount(material, indices);
+    if (numPalikEntries > 0) {
+        const auto first = getPalikEntry(0, material, indices, table);
+        const auto last  = getPalikEntry(numPalikEntries - 1, material, indices, table);
+
+        if (first.m_energy / palikMargin <= energy && energy <= last.m_energy * palikMargin) {
+            return interpolateEntries(energy, numPalikEntries, [&](const int i) {
+                const auto entry = getPalikEntry(i, material, indices, table);
+                return std::make_pair(entry.m_energy, complex::Complex(entry.m_n, entry.m_k));
+            });
+        }
+    }
+
+    const auto massAndRho = getAtomicMassAndRho(material);
+    const auto mass       = massAndRho.x;
+    const auto rho        = massAndRho.y;
+
+    return interpolateEntries(energy, getNffEntryCount(material, indices), [&](const int i) {
+        // compute n, k from the Nff data. see getRefractiveIndex
+        const auto entry = getNffEntry(i, material, indices, table);
+        const auto e     = entry.m_energy;
+        const auto n     = 1 - (415.252 * rho * entry.m_f1) / (e * e * mass);
+        const auto k     = (415.252 * rho * entry.m_f2) / (e * e * mass);
+        return std::make_pair(e, complex::Complex(n, k));
+    });
+}
+
+bool isMaterialTabulated(const int material, const MaterialTables& materialTables) {
+    const auto* indices = materialTables.indices.data();
+    return getPalikEntryCount(material, indices) > 0 || getNffEntryCount(material, indices) > 0;
+}
+
+// calls f(energy) for the energy of every Palik and Nff entry of material. if `onlyUsedEntries` is set, Nff entries within the range of the Palik
+// table are skipped, because getRefractiveIndex never picks them
+template <typename F>
+void forEachEntryEnergy(const int material, const MaterialTables& materialTables, const bool onlyUsedEntries, F f) {
+    const auto* indices = materialTables.indices.data();
+    const auto* table   = materialTables.materials.data();
+
+    const auto numPalikEntries = getPalikEntryCount(material, indices);
+    for (int i = 0; i < numPalikEntries; ++i) { f(getPalikEntry(i, material, indices, table).m_energy); }
+
+    const auto palikEnergyMin = numPalikEntries ? getPalikEntry(0, material, indices, table).m_energy : 0.0;
+    const auto palikEnergyMax = numPalikEntries ? getPalikEntry(numPalikEntries - 1, material, indices, table).m_energy : -1.0;
+    for (int i = 0; i < getNffEntryCount(material, indices); ++i) {
+        const auto energy = getNffEntry(i, material, indices, table).m_energy;
+        if (!onlyUsedEntries || energy < palikEnergyMin || palikEnergyMax < energy) f(energy);
+    }
+}
+
+}  // unnamed namespace
+
+RefractiveIndexTable RefractiveIndexTableData::view() const {
+    return RefractiveIndexTable{
+        .samples          = samples.data(),
+        .rows             = rows.data(),
+        .numSamples       = numSamples,
+        .logEnergyMin     = logEnergyMin,
+        .invLogEnergyStep = invLogEnergyStep,
+    };
+}
+
+RefractiveIndexTableData createRefractiveIndexTable(const MaterialTables& materialTables, const RefractiveIndexTableConfig& config) {
+    if (config.numSamples < 2) RAYX_EXIT << "createRefractiveIndexTable: the number of samples must be at least 2, got " << config.numSamples;
+
+    // find the energy range covered by the material tables
+    auto energyMin = std::numeric_limits<double>::max();
+    auto energyMax = std::numeric_limits<double>::lowest();
+    for (int material = 1; material <= 92; ++material) {
+        forEachEntryEnergy(material, materialTables, false, [&](const double energy) {
+            energyMin = std::min(energyMin, energy);
+            energyMax = std::max(energyMax, energy);
+        });
+    }
+
+    // no materials loaded, nothing to tabulate
+    if (energyMin > energyMax) return {};
+
+    energyMin = config.energyMin.value_or(energyMin);
+    energyMax = config.energyMax.value_or(energyMax);
+    if (energyMin <= 0.0 || energyMax <= energyMin)
+        RAYX_EXIT << "createRefractiveIndexTable: invalid energy range [" << energyMin << ", " << energyMax << "]";
+
+    RefractiveIndexTableData out;
+    out.numSamples           = config.numSamples;
+    out.logEnergyMin         = std::log(energyMin);
+    const auto logEnergyStep = (std::log(energyMax) - out.logEnergyMin) / (config.numSamples - 1);
+    out.invLogEnergyStep     = 1.0 / logEnergyStep;
+    out.rows                 = std::vector<int>(92, -1);
+    const auto palikMargin   = std::exp(logEnergyStep);
+
+    for (int material = 1; material <= 92; ++material) {
+        if (!isMaterialTabulated(material, materialTables)) continue;
+
+        out.rows[material - 1] = static_cast<int>(out.samples.size());
+        for (int i = 0; i < config.numSamples; ++i) {
+            const auto energy = std::exp(out.logEnergyMin + i * logEnergyStep);
+            out.samples.push_back(interpolateRefractiveIndex(energy, material, materialTables, palikMargin));
+        }
+    }
+
+    return out;
+}
+
+double calcRefractiveIndexTableDeviation(const MaterialTables& materialTables, const RefractiveIndexTableData& table) {
+    if (table.numSamples < 2) return 0.0;
+
+    const auto* indices   = materialTables.indices.data();
+    const auto* materials = materialTables.materials.data();
+    const auto view       = table.view();
+    const auto energyMin  = std::exp(table.logEnergyMin);
+    const auto energyMax  = std::exp(table.logEnergyMin + (table.numSamples - 1) / table.invLogEnergyStep);
+
+    auto deviation = 0.0;
+    for (int material = 1; material <= 92; ++material) {
+        if (table.rows[material - 1] < 0) continue;
+
+        forEachEntryEnergy(material, materialTables, true, [&](const double energy) {
+            if (energy < energyMin || energyMax < energy) return;
+
+            const auto expected = getRefractiveIndex(energy, material, indices, materials);
+            const auto actual   = getRefractiveIndex(energy, material, indices, materials, view);
+            deviation           = std::max(deviation, complex::abs(actual - expected) / complex::abs(expected));
+        });
+    }
+
+    return deviation;
+}
+
 }  // namespace RAYX
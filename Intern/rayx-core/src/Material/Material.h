@@ -1,9 +1,11 @@
 #pragma once
 
 #include <array>
+#include <optional>
 #include <vector>
 
 #include "Core.h"
+#include "Shader/RefractiveIndex.h"
 
 namespace RAYX {
 
@@ -39,4 +41,33 @@ struct RAYX_API MaterialTables {
 // the tables will later be written to the mat and matIdx buffers of shader.comp
 MaterialTables RAYX_API loadMaterialTables(std::array<bool, 92> relevantMaterials);
 
+/// configures the resampling of the material tables onto a uniform grid in log(energy). See `RefractiveIndexTable`
+struct RAYX_API RefractiveIndexTableConfig {
+    bool enable    = false;           // if disabled, refractive indices are looked up by binary search in the Palik and Nff tables
+    int numSamples = 16384;           // number of grid points per material
+    std::optional<double> energyMin;  // lower bound of the grid. Default: the lowest energy found in the loaded material tables
+    std::optional<double> energyMax;  // upper bound of the grid. Default: the highest energy found in the loaded material tables
+    double tolerance = 1e-2;          // maximal relative deviation from the material tables, before a warning is issued
+};
+
+/// host side storage of a `RefractiveIndexTable`
+struct RAYX_API RefractiveIndexTableData {
+    std::vector<complex::Complex> samples;
+    std::vector<int> rows;
+    int numSamples          = 0;
+    double logEnergyMin     = 0.0;
+    double invLogEnergyStep = 0.0;
+
+    /// returns a view of this data, that can be passed to `getRefractiveIndex`
+    RefractiveIndexTable view() const;
+};
+
+// resamples the refractive indices of all materials in `materialTables` onto a uniform grid in log(energy).
+// between the entries of the Palik and Nff tables, the refractive index is interpolated linearly in log(energy).
+RefractiveIndexTableData RAYX_API createRefractiveIndexTable(const MaterialTables& materialTables, const RefractiveIndexTableConfig& config);
+
+// returns the maximal relative deviation |table - tables| / |tables| between the lookup in the resampled table and the lookup in the material
+// tables, evaluated at the energies of all Palik and Nff entries that are covered by the grid and used by the lookup in the material tables.
+double RAYX_API calcRefractiveIndexTableDeviation(const MaterialTables& materialTables, const RefractiveIndexTableData& table);
+
 }  // namespace RAYX
@@ -73,7 +73,10 @@ glm::dvec3 applySlopeError(glm::dvec3 normal, SlopeError error, int O_type, Rand
     // only calculate the random number if at least one slope error is not 0,
     // since the calculation is costly (sin, cos, log involved)
     if (slopeX != 0 || slopeZ != 0) {
-        double random_values[2] = {rand.randomDoubleNormalDistributed(0, slopeX), rand.randomDoubleNormalDistributed(0, slopeZ)};
+        double random_values[2];
+        rand.randomDoublesNormalDistributed(random_values);
+        random_values[0] *= slopeX;
+        random_values[1] *= slopeZ;
 
         /*double x = random_values[0] * slopeX; // to get normal distribution
         from std.-norm. multiply by sigma (=slopeX) -> mu + x * sigma but mu=0
@@ -6,6 +6,7 @@
 #include "Efficiency.h"
 #include "EventType.h"
 #include "LineDensity.h"
+#include "MultilayerTable.h"
 #include "Rand.h"
 #include "Ray.h"
 #include "Refrac.h"
@@ -141,17 +142,24 @@ void behaveGrating(detail::Ray& __restrict ray, const Behaviour::Grating& __rest
 
 RAYX_FN_ACC
 void behaveMirror(detail::Ray& __restrict ray, const CollisionPoint& __restrict col, const Coating& __restrict coating, const int material,
-                  const int* __restrict materialIndices, const double* __restrict materialTable) {
+                  const int* __restrict materialIndices, const double* __restrict materialTable,
+                  const RefractiveIndexTable& __restrict refractiveIndexTable, RefractiveIndexCache& __restrict refractiveIndexCache,
+                  const MultilayerTable& __restrict multilayerTable) {
     // calculate the new direction after the reflection
     const auto incident_vec = ray.direction;
     const auto reflect_vec  = glm::reflect(incident_vec, col.normal);
     ray.direction           = reflect_vec;
 
+    // the refractive indices are cached per ray, since the energy of the ray does not change between hits
+    const auto getIor = [&](const int m) {
+        return getRefractiveIndex(ray.energy, m, materialIndices, materialTable, refractiveIndexTable, refractiveIndexCache);
+    };
+
     if (coating.is<Coating::SubstrateOnly>()) {
         if (material != -2) {
             constexpr int vacuum_material = -1;
-            const auto vacuum_ior         = getRefractiveIndex(ray.energy, vacuum_material, materialIndices, materialTable);
-            const auto substrate_ior      = getRefractiveIndex(ray.energy, material, materialIndices, materialTable);
+            const auto vacuum_ior         = getIor(vacuum_material);
+            const auto substrate_ior      = getIor(material);
 
             const auto reflect_field = interceptReflect(ray.electric_field, incident_vec, reflect_vec, col.normal, vacuum_ior, substrate_ior);
 
@@ -162,9 +170,9 @@ void behaveMirror(detail::Ray& __restrict ray, const CollisionPoint& __restrict
         Coating::OneCoating oneCoating = coating.get<Coating::OneCoating>();
 
         constexpr int vacuum_material = -1;
-        const auto vacuum_ior         = getRefractiveIndex(ray.energy, vacuum_material, materialIndices, materialTable);
-        const auto coating_ior        = getRefractiveIndex(ray.energy, oneCoating.material, materialIndices, materialTable);
-        const auto substrate_ior      = getRefractiveIndex(ray.energy, material, materialIndices, materialTable);
+        const auto vacuum_ior         = getIor(vacuum_material);
+        const auto coating_ior        = getIor(oneCoating.material);
+        const auto substrate_ior      = getIor(material);
 
         const auto angle         = angleBetweenUnitVectors(-incident_vec, col.normal);
         const auto incidentAngle = complex::Complex(angle == 0.0 ? 1e-8 : angle, 0.0);
@@ -178,24 +186,15 @@ void behaveMirror(detail::Ray& __restrict ray, const CollisionPoint& __restrict
         ray.electric_field = polmat * ray.electric_field;
         ray.order          = 0;
     } else if (coating.is<Coating::MultilayerCoating>()) {
-        Coating::MultilayerCoating mlCoating = coating.get<Coating::MultilayerCoating>();
-        constexpr int vacuum_material        = -1;
-        const auto vacuum_ior                = getRefractiveIndex(ray.energy, vacuum_material, materialIndices, materialTable);
-        const auto substrate_ior             = getRefractiveIndex(ray.energy, material, materialIndices, materialTable);
-
-        const int n = mlCoating.numLayers;
-        complex::Complex iors[1002];
+        const auto& mlCoating = coating.get<Coating::MultilayerCoating>();
 
-        iors[0] = vacuum_ior;
-        for (int i = 0; i < n; ++i) { iors[i + 1] = getRefractiveIndex(ray.energy, mlCoating.material[i], materialIndices, materialTable); }
-        iors[n + 1] = substrate_ior;
-
-        const auto angle         = angleBetweenUnitVectors(-incident_vec, col.normal);
-        const auto incidentAngle = complex::Complex(angle == 0.0 ? 1e-8 : angle, 0.0);
-
-        const double wavelength = energyToWaveLength(ray.energy);
+        const auto angle = angleBetweenUnitVectors(-incident_vec, col.normal);
 
-        const auto amplitude = computeMultilayerReflectance(incidentAngle, wavelength, n, mlCoating.thickness, iors);
+        // use the precomputed amplitudes if available, otherwise run the recursion over all layers
+        const auto tabulatedAmplitude = lookupMultilayerReflectance(ray.energy, angle, multilayerTable);
+        const auto amplitude          = tabulatedAmplitude ? *tabulatedAmplitude
+                                                           : calcMultilayerReflectance(ray.energy, angle, mlCoating, material, materialIndices,
+                                                                                       materialTable, refractiveIndexTable, refractiveIndexCache);
 
         const auto polmat  = calcPolaririzationMatrix(incident_vec, reflect_vec, col.normal, amplitude);
         ray.electric_field = polmat * ray.electric_field;
@@ -207,9 +206,10 @@ void behaveMirror(detail::Ray& __restrict ray, const CollisionPoint& __restrict
 
 RAYX_FN_ACC
 void behaveFoil(detail::Ray& __restrict ray, const Behaviour::Foil& __restrict foil, const CollisionPoint& __restrict col, const int material,
-                const int* __restrict materialIndices, const double* __restrict materialTable) {
+                const int* __restrict materialIndices, const double* __restrict materialTable,
+                const RefractiveIndexTable& __restrict refractiveIndexTable, RefractiveIndexCache& __restrict refractiveIndexCache) {
     const auto indexVacuum   = complex::Complex(1., 0.);
-    const auto indexMaterial = getRefractiveIndex(ray.energy, material, materialIndices, materialTable);
+    const auto indexMaterial = getRefractiveIndex(ray.energy, material, materialIndices, materialTable, refractiveIndexTable, refractiveIndexCache);
 
     double angle = angleBetweenUnitVectors(-ray.direction, col.normal);  // in rad
 
@@ -235,10 +235,13 @@ RAYX_FN_ACC void behaveImagePlane(detail::Ray& __restrict ray) { ray.order = 0;
 
 RAYX_FN_ACC
 void behave(detail::Ray& __restrict ray, const CollisionPoint& __restrict col, const OpticalElement& __restrict element,
-            const int* __restrict materialIndices, const double* __restrict materialTable) {
+            const int* __restrict materialIndices, const double* __restrict materialTable,
+            const RefractiveIndexTable& __restrict refractiveIndexTable, RefractiveIndexCache& __restrict refractiveIndexCache,
+            const MultilayerTable& __restrict multilayerTable) {
     element.m_behaviour.visit([&]<typename T>(const T& behaviour) {
         if constexpr (std::is_same_v<T, Behaviour::Mirror>) {
-            behaveMirror(ray, col, element.m_coating, element.m_material, materialIndices, materialTable);
+            behaveMirror(ray, col, element.m_coating, element.m_material, materialIndices, materialTable, refractiveIndexTable, refractiveIndexCache,
+                         multilayerTable);
         } else if constexpr (std::is_same_v<T, Behaviour::Grating>) {
             behaveGrating(ray, behaviour, col);
         } else if constexpr (std::is_same_v<T, Behaviour::Slit>) {
@@ -250,7 +253,7 @@ void behave(detail::Ray& __restrict ray, const CollisionPoint& __restrict col, c
         } else if constexpr (std::is_same_v<T, Behaviour::ImagePlane>) {
             behaveImagePlane(ray);
         } else if constexpr (std::is_same_v<T, Behaviour::Foil>) {
-            behaveFoil(ray, behaviour, col, element.m_material, materialIndices, materialTable);
+            behaveFoil(ray, behaviour, col, element.m_material, materialIndices, materialTable, refractiveIndexTable, refractiveIndexCache);
         } else {
             _throw("invalid behaviour type in dynamicElements!");
         }
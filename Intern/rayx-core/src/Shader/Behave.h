@@ -3,6 +3,7 @@
 #include "Collision.h"
 #include "Core.h"
 #include "InvocationState.h"
+#include "MultilayerTable.h"
 #include "Ray.h"
 
 namespace RAYX {
@@ -22,11 +23,16 @@ RAYX_FN_ACC void behaveSlit(detail::Ray& __restrict ray, const Behaviour::Slit&
 RAYX_FN_ACC void behaveRZP(detail::Ray& __restrict ray, const Behaviour::RZP& __restrict rzp, const CollisionPoint& __restrict col);
 RAYX_FN_ACC void behaveGrating(detail::Ray& __restrict ray, const Behaviour::Grating& __restrict grating, const CollisionPoint& __restrict col);
 RAYX_FN_ACC void behaveMirror(detail::Ray& __restrict ray, const CollisionPoint& __restrict col, const Coating& __restrict coating, int material,
-                              const int* __restrict materialIndices, const double* __restrict materialTable);
+                              const int* __restrict materialIndices, const double* __restrict materialTable,
+                              const RefractiveIndexTable& __restrict refractiveIndexTable, RefractiveIndexCache& __restrict refractiveIndexCache,
+                              const MultilayerTable& __restrict multilayerTable);
 RAYX_FN_ACC void behaveFoil(detail::Ray& __restrict ray, const Behaviour::Foil& __restrict foil, const CollisionPoint& __restrict col, int material,
-                            const int* __restrict materialIndices, const double* __restrict materialTable);
+                            const int* __restrict materialIndices, const double* __restrict materialTable,
+                            const RefractiveIndexTable& __restrict refractiveIndexTable, RefractiveIndexCache& __restrict refractiveIndexCache);
 RAYX_FN_ACC void behaveImagePlane(detail::Ray& __restrict ray);
 RAYX_FN_ACC void behave(detail::Ray& __restrict ray, const CollisionPoint& __restrict col, const OpticalElement& __restrict element,
-                        const int* __restrict materialIndices, const double* __restrict materialTable);
+                        const int* __restrict materialIndices, const double* __restrict materialTable,
+                        const RefractiveIndexTable& __restrict refractiveIndexTable, RefractiveIndexCache& __restrict refractiveIndexCache,
+                        const MultilayerTable& __restrict multilayerTable);
 
 }  // namespace RAYX
@@ -4,6 +4,7 @@
 #include "Cubic.h"
 #include "CutoutFns.h"
 #include "InvocationState.h"
+#include "Polynomial.h"
 #include "Throw.h"
 #include "Utils.h"
 #include "Variant.h"
@@ -17,339 +18,125 @@ namespace RAYX {
 /**************************************************************
  *                    Quadric collision
  **************************************************************/
+// the quadric is given by p^T * A * p + 2 * a4^T * p + a44 = 0, with the symmetric matrix A built from the coefficients a11 to a33.
+// inserting the ray p = p0 + t * dir yields a * t^2 + 2 * b * t + c = 0, independent of the dominant direction of the ray.
 RAYX_FN_ACC
 OptCollisionPoint getQuadricCollision(const glm::dvec3& __restrict rayPosition, const glm::dvec3& __restrict rayDirection,
                                       const Surface::Quadric& __restrict q) {
-    CollisionPoint col;
-    col.hitpoint = glm::dvec3(0, 0, 0);
-    col.normal   = glm::dvec3(0, 0, 0);
-
-    int cs     = 1;
-    int d_sign = q.m_icurv;
-    if (glm::abs(rayDirection[1]) >= glm::abs(rayDirection[0]) && glm::abs(rayDirection[1]) >= glm::abs(rayDirection[2])) {
-        cs = 2;
-    } else if (glm::abs(rayDirection[2]) >= glm::abs(rayDirection[0]) && glm::abs(rayDirection[2]) >= glm::abs(rayDirection[1])) {
-        cs = 3;
-    }
+    const auto A  = glm::dmat3(q.m_a11, q.m_a12, q.m_a13, q.m_a12, q.m_a22, q.m_a23, q.m_a13, q.m_a23, q.m_a33);
+    const auto a4 = glm::dvec3(q.m_a14, q.m_a24, q.m_a34);
 
-    double x = 0;
-    double y = 0;
-    double z = 0;
-    double a = 0;
-    double b = 0;
-    double c = 0;
-
-    if (cs == 1) {
-        double aml = rayDirection[1] / rayDirection[0];
-        double anl = rayDirection[2] / rayDirection[0];
-        y          = rayPosition[1] - aml * rayPosition[0];
-        z          = rayPosition[2] - anl * rayPosition[0];
-        d_sign     = int(glm::sign(rayDirection[0]) * q.m_icurv);
-
-        a = q.m_a11 + 2 * q.m_a12 * aml + q.m_a22 * aml * aml + 2 * q.m_a13 * anl + 2 * q.m_a23 * aml * anl + q.m_a33 * anl * anl;
-        b = q.m_a14 + q.m_a24 * aml + q.m_a34 * anl + (q.m_a12 + q.m_a22 * aml + q.m_a23 * anl) * y + (q.m_a13 + q.m_a23 * aml + q.m_a33 * anl) * z;
-        c = q.m_a44 + q.m_a22 * y * y + 2 * q.m_a34 * z + q.m_a33 * z * z + 2 * y * (q.m_a24 + q.m_a23 * z);
-
-        double bbac = b * b - a * c;
-        if (bbac < 0) {
-            return std::nullopt;
-        } else {
-            if (glm::abs(a) > glm::abs(c) * 1e-10) {
-                x = (-b + d_sign * sqrt(bbac)) / a;
-            } else {
-                x = (-c / 2) / b;
-            }
-        }
-        y = y + aml * x;
-        z = z + anl * x;
-    } else if (cs == 2) {
-        double alm = rayDirection[0] / rayDirection[1];
-        double anm = rayDirection[2] / rayDirection[1];
-        x          = rayPosition[0] - alm * rayPosition[1];
-        z          = rayPosition[2] - anm * rayPosition[1];
-        d_sign     = int(glm::sign(rayDirection[1]) * q.m_icurv);
-
-        a = q.m_a22 + 2 * q.m_a12 * alm + q.m_a11 * alm * alm + 2 * q.m_a23 * anm + 2 * q.m_a13 * alm * anm + q.m_a33 * anm * anm;
-        b = q.m_a24 + q.m_a14 * alm + q.m_a34 * anm + (q.m_a12 + q.m_a11 * alm + q.m_a13 * anm) * x + (q.m_a23 + q.m_a13 * alm + q.m_a33 * anm) * z;
-        c = q.m_a44 + q.m_a11 * x * x + 2 * q.m_a34 * z + q.m_a33 * z * z + 2 * x * (q.m_a14 + q.m_a13 * z);
-
-        double bbac = b * b - a * c;
-        if (bbac < 0) {
-            return std::nullopt;
-        } else {
-            if (glm::abs(a) > glm::abs(c) * 1e-10) {
-                y = (-b + d_sign * sqrt(bbac)) / a;
-            } else {
-                y = (-c / 2) / b;
-            }
-        }
-        x = x + alm * y;
-        z = z + anm * y;
-    } else {
-        double aln = rayDirection[0] / rayDirection[2];
-        double amn = rayDirection[1] / rayDirection[2];
-        // firstParam = aln;
-        // secondParam = amn;
-        x      = rayPosition[0] - aln * rayPosition[2];
-        y      = rayPosition[1] - amn * rayPosition[2];
-        d_sign = int(glm::sign(rayDirection[2]) * q.m_icurv);
-
-        a = q.m_a33 + 2 * q.m_a13 * aln + q.m_a11 * aln * aln + 2 * q.m_a23 * amn + 2 * q.m_a12 * aln * amn + q.m_a22 * amn * amn;
-        b = q.m_a34 + q.m_a14 * aln + q.m_a24 * amn + (q.m_a13 + q.m_a11 * aln + q.m_a12 * amn) * x + (q.m_a23 + q.m_a12 * aln + q.m_a22 * amn) * y;
-        c = q.m_a44 + q.m_a11 * x * x + 2 * q.m_a24 * y + q.m_a22 * y * y + 2 * x * (q.m_a14 + q.m_a12 * y);
-
-        double bbac = b * b - a * c;
-        if (bbac < 0) {
-            return std::nullopt;
-        } else {
-            if (glm::abs(a) > glm::abs(c) * 1e-10) {  // pow(10, double(-10))) {
-                z = (-b + d_sign * sqrt(bbac)) / a;
-            } else {
-                z = (-c / 2) / b;
-            }
-        }
-        x = x + aln * z;
-        y = y + amn * z;
-        // rayPosition = glm::dvec3(a, b, c);
-    }
+    // parameterize the ray relative to its point closest to the origin of the element. this keeps c well conditioned for distant ray positions
+    const auto t0 = -glm::dot(rayPosition, rayDirection) / glm::dot(rayDirection, rayDirection);
+    const auto p0 = rayPosition + t0 * rayDirection;
 
-    // intersection point is in the negative direction (behind the position when the direction is followed forwards), set weight to 0
-    if ((x - rayPosition.x) / rayDirection.x < 0 || (y - rayPosition.y) / rayDirection.y < 0 || (z - rayPosition.z) / rayDirection.z < 0) {
-        return std::nullopt;
-    }
+    const auto Ap0 = A * p0;
+    const auto a   = glm::dot(rayDirection, A * rayDirection);
+    const auto b   = glm::dot(rayDirection, Ap0 + a4);
+    const auto c   = glm::dot(p0, Ap0 + 2.0 * a4) + q.m_a44;
 
-    col.hitpoint = glm::dvec3(x, y, z);
+    const auto bbac = b * b - a * c;
+    if (bbac < 0) return std::nullopt;
 
-    double fx  = 2 * q.m_a14 + 2 * q.m_a11 * x + 2 * q.m_a12 * y + 2 * q.m_a13 * z;
-    double fy  = 2 * q.m_a24 + 2 * q.m_a12 * x + 2 * q.m_a22 * y + 2 * q.m_a23 * z;
-    double fz  = 2 * q.m_a34 + 2 * q.m_a13 * x + 2 * q.m_a23 * y + 2 * q.m_a33 * z;
-    col.normal = normalize(glm::dvec3(fx, fy, fz));
-    return col;
+    // m_icurv selects the root. it is evaluated in the form that avoids cancellation of b and the square root
+    const auto s = q.m_icurv * sqrt(bbac);
+    const auto t = t0 + (glm::abs(a) <= glm::abs(c) * 1e-10 ? (-c / 2) / b : (b * q.m_icurv > 0 ? c / (-b - s) : (-b + s) / a));
+
+    // intersection point is in the negative direction (behind the position when the direction is followed forwards)
+    if (t < 0) return std::nullopt;
+
+    const auto hitpoint = rayPosition + t * rayDirection;
+
+    return CollisionPoint{
+        .hitpoint = hitpoint,
+        .normal   = normalize(2.0 * (A * hitpoint + a4)),
+    };
 }
 
 /**************************************************************
  *                    Cubic collision
  **************************************************************/
 /**
- * taken from RAY-UI Nov. 2023:
- *  new version of Th. Zeschke by Oct. 18, 2007
- *  corresponding exe-version is called ray_thomas1.exe (on VAX only)
- *
- *  calculates intersection of a straight line
- *  equation straight line:
- *  (x-x1)/al = (y-y1)/am = (z-z1)/an
- *  with a surface of 3. order
+ * the cubic surface was taken from RAY-UI (Th. Zeschke, Oct. 18, 2007). it extends the quadric by the terms
+ *  b12 * x^2 * y + b13 * x^2 * z + b21 * x * y^2 + b23 * y^2 * z + b31 * x * z^2 + b32 * y * z^2
+ * and is rotated by psi around the x axis.
  *
- *  method: the iterative Newtonmethod is used for zero point search
- *  result is X,Y,Z of intersection
+ * inserting the ray yields a cubic polynomial in the ray parameter t. its root is found by newton steps (evaluated in horner form), starting at
+ * the intersection with the quadric part of the surface. rays, for which newton does not converge, miss the surface.
  * Ray in in element koordinates.
  */
 RAYX_FN_ACC
 OptCollisionPoint getCubicCollision(const glm::dvec3& __restrict rayPosition, const glm::dvec3& __restrict rayDirection,
                                     const Surface::Cubic& __restrict cu) {
+    // Constants
+    const int MAX_NEWTON_ITERATIONS = 32;
+    const double TOLERANCE          = 1e-6;   // of the newton step
+    const double RESIDUAL_TOLERANCE = 1e-12;  // of the polynomial, relative to the magnitude of its terms
+
     // TODO: what is this and do we need it?
     // Ray r = rotateForCubic(rin, cu.m_psi, 1000);
 
-    int cs = 1;
-    if (glm::abs(rayDirection[1]) >= glm::abs(rayDirection[0]) && glm::abs(rayDirection[1]) >= glm::abs(rayDirection[2])) {
-        cs = 2;
-    } else if (glm::abs(rayDirection[2]) >= glm::abs(rayDirection[0]) && glm::abs(rayDirection[2]) >= glm::abs(rayDirection[1])) {
-        cs = 3;
+    const auto dir = cubicDirection(rayDirection, cu.m_psi);
+
+    // parameterize the ray relative to its point closest to the origin of the element
+    const auto rotatedPosition = cubicPosition(rayPosition, cu.m_psi);
+    const auto pos             = rotatedPosition - glm::dot(rotatedPosition, dir) / glm::dot(dir, dir) * dir;
+
+    const auto A    = glm::dmat3(cu.m_a11, cu.m_a12, cu.m_a13, cu.m_a12, cu.m_a22, cu.m_a23, cu.m_a13, cu.m_a23, cu.m_a33);
+    const auto a4   = glm::dvec3(cu.m_a14, cu.m_a24, cu.m_a34);
+    const auto Apos = A * pos;
+
+    // coefficients of (pos[i] + t * dir[i]) * (pos[j] + t * dir[j]) * (pos[k] + t * dir[k]), in ascending order of t
+    const auto cubicTerm = [&](const int i, const int j, const int k) {
+        return glm::dvec4(pos[i] * pos[j] * pos[k], pos[i] * pos[j] * dir[k] + pos[i] * dir[j] * pos[k] + dir[i] * pos[j] * pos[k],
+                          dir[i] * dir[j] * pos[k] + dir[i] * pos[j] * dir[k] + pos[i] * dir[j] * dir[k], dir[i] * dir[j] * dir[k]);
+    };
+
+    const auto quadricCoeffs = glm::dvec4(glm::dot(pos, Apos + 2.0 * a4) + cu.m_a44, 2 * glm::dot(dir, Apos + a4), glm::dot(dir, A * dir), 0);
+    const auto coeffs = quadricCoeffs + cu.m_b12 * cubicTerm(0, 0, 1) + cu.m_b13 * cubicTerm(0, 0, 2) + cu.m_b21 * cubicTerm(0, 1, 1) +
+                        cu.m_b23 * cubicTerm(1, 1, 2) + cu.m_b31 * cubicTerm(0, 2, 2) + cu.m_b32 * cubicTerm(1, 2, 2);
+
+    // start at the root of the quadric part that is closest to the origin of the element
+    double t          = 0;
+    const double disc = quadricCoeffs[1] * quadricCoeffs[1] - 4 * quadricCoeffs[2] * quadricCoeffs[0];
+    if (disc >= 0) {
+        constexpr auto inf = std::numeric_limits<double>::max();
+        const auto q       = -0.5 * (quadricCoeffs[1] + (quadricCoeffs[1] < 0 ? -1.0 : 1.0) * sqrt(disc));
+        const auto t1      = quadricCoeffs[2] != 0 ? q / quadricCoeffs[2] : inf;
+        const auto t2      = q != 0 ? quadricCoeffs[0] / q : inf;
+        const auto tq      = glm::abs(t1) < glm::abs(t2) ? t1 : t2;
+        t                  = glm::abs(tq) < inf ? tq : 0.0;
     }
 
-    glm::dvec3 pos = cubicPosition(rayPosition, cu.m_psi);
-    double x       = pos.x;
-    double y       = pos.y;
-    double z       = pos.z;
-    double x1      = 0;
-    double xx      = 0;
-    double y1      = 0;
-    double yy      = 0;
-    double z1      = 0;
-    double zz      = 0;
-    double counter = 0;
-    double dx      = 0;
-
-    glm::dvec3 dir = cubicDirection(rayDirection, cu.m_psi);
-    double al      = dir.x;
-    double am      = dir.y;
-    double an      = dir.z;
-
-    if (cs == 1) {
-        double aml = am / al;
-        double anl = an / al;
-
-        do {
-            x1 = xx;
-            y1 = y - aml * (x - xx);
-            z1 = z - anl * (x - xx);
-
-            double func = (2 * ((x1 - xx) * an - al * z1) * cu.m_a23 - (2 * cu.m_a24 + cu.m_b12 * pow(float(xx), 2.0)) * al +
-                           ((x1 - xx) * am - al * y1) * (cu.m_a22 + cu.m_b21 * xx)) *
-                          ((x1 - xx) * am - al * y1);
-            func = func + pow(float(((x1 - xx) * an - al * z1)), 2.0) * cu.m_a33;
-            func = func - ((x1 - xx) * an - al * z1) * (2 * cu.m_a34 + cu.m_b13 * pow(float(xx), 2.0) * al + cu.m_a44 * pow(float(al), 2.0));
-            func = (func -
-                    (2 * ((x1 - xx) * an - al * z1) * cu.m_a13 - (cu.m_a11 * xx + 2 * cu.m_a14) * al + 2 * ((x1 - xx) * am - al * y1) * cu.m_a12) *
-                        al * xx) *
-                   al;
-            func = (func - (pow(float(((x1 - xx) * am - al * y1)), 2.0) * cu.m_b23 +
-                            ((x1 - xx) * am - al * y1) * ((x1 - xx) * an - al * z1) * cu.m_b32 - ((x1 - xx) * an - al * z1) * al * cu.m_b31 * xx) *
-                               ((x1 - xx) * an - al * z1) / pow(float(al), 3));
-
-            double dfunc = (2 * ((x1 - xx) * an - al * z1) * cu.m_a23 - (2 * cu.m_a24 + cu.m_b12 * pow(float(xx), 2)) * al +
-                            ((x1 - xx) * am - al * y1) * (cu.m_a22 + cu.m_b21 * xx)) *
-                           am;
-            dfunc = dfunc - (2 * (cu.m_a12 * am + cu.m_a13 * an) + cu.m_a11 * al) * al * xx;
-            dfunc =
-                dfunc + (2 * ((x1 - xx) * an - al * z1) * cu.m_a13 - (cu.m_a11 * xx + 2 * cu.m_a14) * al + 2 * ((x1 - xx) * am - al * y1) * cu.m_a12);
-            dfunc =
-                dfunc * al + ((cu.m_a22 + cu.m_b21 * xx) * am + 2 * (cu.m_a23 * an + al * cu.m_b12 * xx) - ((x1 - xx) * am - al * y1) * cu.m_b21) *
-                                 ((x1 - xx) * am - al * y1);
-            dfunc = (dfunc + 2 * ((x1 - xx) * an - al * z1) * (cu.m_a33 * an + al * cu.m_b13 * xx) -
-                     (2 * cu.m_a34 + cu.m_b13 * pow(float(xx), 2)) * al * an) *
-                    al;
-            dfunc = (dfunc - ((((x1 - xx) * an - al * z1) * (al * cu.m_b31 + am * cu.m_b32) - al * an * cu.m_b31 * xx +
-                               ((x1 - xx) * am - al * y1) * (2 * am * cu.m_b23 + an * cu.m_b32)) *
-                                  ((x1 - xx) * an - al * z1) +
-                              (pow(float(((x1 - xx) * am - al * y1)), 2) * cu.m_b23 +
-                               ((x1 - xx) * am - al * y1) * ((x1 - xx) * an - al * z1) * cu.m_b32 - ((x1 - xx) * an - al * z1) * al * cu.m_b31 * xx) *
-                                  an));
-            dfunc = dfunc / pow(float(al), 3);
-
-            if (glm::abs(dfunc) < 0.001) { dfunc = 0.001; }
-
-            dx = func / dfunc;
-            xx = xx - dx;
-
-            x = x1;
-            y = y1;
-            z = z1;
-
-            if (counter > 1000) {
-                x = -2 * y1 / 2 / aml;
-                y = y1 + aml * x;
-                z = z1 + anl * x;
-            }
-            counter++;
-        } while (glm::abs(dx) > 0.001);
-    } else if (cs == 2) {
-        double alm = al / am;
-        double anm = an / am;
-
-        do {
-            x1 = x - alm * (y - yy);
-            y1 = yy;
-            z1 = z - anm * (y - yy);
-
-            double func = (2 * (((y1 - yy) * an - am * z1) * cu.m_a13 - (cu.m_a12 * yy + cu.m_a14) * am) +
-                           ((y1 - yy) * al - am * x1) * (cu.m_a11 + cu.m_b12 * yy)) *
-                          ((y1 - yy) * al - am * x1);
-            func = func + (((y1 - yy) * an - am * z1) * cu.m_a33 - 2 * (cu.m_a23 * yy + cu.m_a34) * am) * ((y1 - yy) * an - am * z1) +
-                   (2 * cu.m_a24 * yy + cu.m_a44 + cu.m_a22 * pow(float(yy), 2) * pow(float(am), 2));
-            func = func * am +
-                   ((((y1 - yy) * an - am * z1) * cu.m_b32 - am * cu.m_b23 * yy) * am * yy - pow(float((y1 - yy) * al - am * x1), 2) * cu.m_b13) *
-                       ((y1 - yy) * an - am * z1);
-            func = func - (pow(float(((y1 - yy) * an - am * z1)), 2) * cu.m_b31 + pow(float(am), 2) * cu.m_b21 * pow(float(yy), 2)) *
-                              ((y1 - yy) * al - am * x1);
-            func = func / pow(float(am), 3);
-
-            double dfunc = (pow(float((y1 - yy) * an - am * z1), 2) * cu.m_b31 + pow(float(am), 2) * cu.m_b21 * pow(float(yy), 2) * al +
-                            2 * (((y1 - yy) * an - am * z1) * an * cu.m_b31 - pow(float(am), 2)) * cu.m_b21 * yy) *
-                           ((y1 - yy) * al - am * x1);
-            dfunc =
-                dfunc -
-                ((((y1 - yy) * an - am * z1) * cu.m_b32 - am * cu.m_b23 * yy) * am * yy - pow(float((y1 - yy) * al - am * x1), 2) * cu.m_b13) * an;
-            dfunc = dfunc + (2 * ((y1 - yy) * al - am * x1) * al * cu.m_b13 - (am * cu.m_b23 + an * cu.m_b32) * am * yy +
-                             (((y1 - yy) * an - am * z1) * cu.m_b32 - am * cu.m_b23 * yy) * am) *
-                                ((y1 - yy) * an - am * z1);
-            dfunc = dfunc - (((cu.m_a11 + cu.m_b12 * yy) * al + 2 * (cu.m_a12 * am + cu.m_a13 * an) - ((y1 - yy) * al - am * x1) * cu.m_b12) *
-                                 ((y1 - yy) * al - am * x1) -
-                             2 * (cu.m_a22 * pow(float(am), 2) * yy + cu.m_a23 * pow(float(am), 2) * z1 - cu.m_a23 * am * an * y1 +
-                                  2 * cu.m_a23 * am * an * yy + cu.m_a24 * pow(float(am), 2) + cu.m_a33 * am * an * z1 -
-                                  cu.m_a33 * pow(float(an), 2) * y1 + cu.m_a33 * pow(float(an), 2) * yy + cu.m_a34 * am * an) +
-                             (2 * (((y1 - yy) * an - am * z1) * cu.m_a13 - (cu.m_a12 * yy + cu.m_a14) * am) +
-                              ((y1 - yy) * al - am * x1) * (cu.m_a11 + cu.m_b12 * yy)) *
-                                 al) *
-                                am;
-            dfunc = dfunc / pow(float(am), 3);
-
-            if (glm::abs(dfunc) < 0.001) { dfunc = 0.001; }
-
-            dx = func / dfunc;
-            yy = yy - dx;
-
-            x = x1;
-            y = y1;
-            z = z1;
-
-            if (counter > 1000) {
-                x = x1;
-                y = 0;
-                z = z1;
-            }
-            counter++;
-        } while (glm::abs(dx) > 0.001);
-    } else {
-        double aln = al / an;
-        double amn = am / an;
-
-        do {
-            x1 = x - aln * (z - zz);
-            y1 = y - amn * (z - zz);
-            z1 = zz;
-
-            double func = ((2 * (((z1 - zz) * am - an * y1) * cu.m_a12 - (cu.m_a13 * zz + cu.m_a14) * an) + ((z1 - zz) * al - an * x1) * cu.m_a11) *
-                               ((z1 - zz) * al - an * x1) +
-                           (((z1 - zz) * am - an * y1) * cu.m_a22 - 2 * (cu.m_a23 * zz + cu.m_a24) * an) * ((z1 - zz) * am - an * y1) +
-                           (2 * cu.m_a34 * zz + cu.m_a44 + cu.m_a33 * pow(float(zz), 2)) * pow(float(an), 2)) *
-                          an;
-            func = func - ((((z1 - zz) * am - an * y1) * cu.m_b12 - an * cu.m_b13 * zz) * pow(float(((z1 - zz) * al - an * x1)), 2) -
-                           (((z1 - zz) * am - an * y1) * cu.m_b23 - an * cu.m_b32 * zz) * ((z1 - zz) * am - an * y1) * an * zz +
-                           (pow(float(((z1 - zz) * am - an * y1)), 2) * cu.m_b21 + pow(float(an), 2) * cu.m_b31 * pow(float(zz), 2)) *
-                               ((z1 - zz) * al - an * x1));
-            func = func / pow(float(an), 3);
-
-            double dfunc = (((z1 - zz) * am - an * y1) * cu.m_a22 - 2 * (cu.m_a23 * zz + cu.m_a24) * an) * am +
-                           (2 * (cu.m_a12 * am + cu.m_a13 * an) + cu.m_a11 * al) * ((z1 - zz) * al - an * x1);
-            dfunc = dfunc + ((z1 - zz) * am - an * y1) * (cu.m_a22 * am + 2 * cu.m_a23 * an) - 2 * (cu.m_a33 * zz + cu.m_a34) * pow(float(an), 2);
-            dfunc = (dfunc +
-                     (2 * (((z1 - zz) * am - an * y1) * cu.m_a12 - (cu.m_a13 * zz + cu.m_a14) * an) + ((z1 - zz) * al - an * x1) * cu.m_a11) * al) *
-                    an;
-            dfunc = dfunc - (2 *
-                                 (((z1 - zz) * am - an * y1) * am * cu.m_b21 - pow(float(an), 2) * cu.m_b31 * zz +
-                                  (((z1 - zz) * am - an * y1) * cu.m_b12 - an * cu.m_b13 * zz) * al) *
-                                 ((z1 - zz) * al - an * x1) +
-                             (pow(float(((z1 - zz) * am - an * y1)), 2) * cu.m_b21 + pow(float(an), 2) * cu.m_b31 * pow(float(zz), 2)) * al +
-                             pow(float(((z1 - zz) * al - an * x1)), 2) * (am * cu.m_b12 + an * cu.m_b13) -
-                             ((z1 - zz) * am - an * y1) * (am * cu.m_b23 + an * cu.m_b32) * an * zz +
-                             (((z1 - zz) * am - an * y1) * cu.m_b23 - an * cu.m_b32 * zz) * (am * z1 - 2 * am * zz - an * y1) * an);
-            dfunc = (-dfunc) / pow(float(an), 3);
-
-            if (glm::abs(dfunc) < 0.001) { dfunc = 0.001; }
-
-            dx = func / dfunc;
-            zz = zz - dx;
-
-            x = x1;
-            y = y1;
-            z = z1;
-
-            if (counter > 1000) {
-                x = x1 + aln * z;
-                y = y1 + amn * z;
-                z = -2 * y1 / 2 / amn;
-            }
-            counter++;
-        } while (glm::abs(dx) > 0.001);
-        // rayPosition = glm::dvec3(a, b, c);
+    auto converged = false;
+    for (int n = 0; n < MAX_NEWTON_ITERATIONS; ++n) {
+        const auto func  = ((coeffs[3] * t + coeffs[2]) * t + coeffs[1]) * t + coeffs[0];
+        const auto dfunc = (3 * coeffs[3] * t + 2 * coeffs[2]) * t + coeffs[1];
+        const auto at    = glm::abs(t);
+        const auto scale = ((glm::abs(coeffs[3]) * at + glm::abs(coeffs[2])) * at + glm::abs(coeffs[1])) * at + glm::abs(coeffs[0]);
+
+        // a vanishing derivative gives no newton step, so t is only accepted if it is a root
+        converged = glm::abs(func) <= RESIDUAL_TOLERANCE * scale;
+        if (converged || dfunc == 0) break;
+
+        const auto dt = func / dfunc;
+        t -= dt;
+        converged = glm::abs(dt) <= TOLERANCE;
+        if (converged) break;
     }
 
+    // newton did not converge, there is no intersection close to the element
+    if (!converged) return std::nullopt;
+
     // intersection point is in the negative direction (behind the position when the direction is followed forwards), set weight to 0
     // if ((x - rayPosition.x) / rayDirection.x < 0 || (y - rayPosition.y) / rayDirection.y < 0 || (z - rayPosition.z) / rayDirection.z < 0) {
     //    col.found = false;
     //}
 
+    const auto x = pos.x + t * dir.x;
+    const auto y = pos.y + t * dir.y;
+    const auto z = pos.z + t * dir.z;
+
     double fx = 2 * cu.m_a14 + 2 * cu.m_a11 * x + 2 * cu.m_a12 * y + 2 * cu.m_a13 * z;
     double fy = 2 * cu.m_a24 + 2 * cu.m_a12 * x + 2 * cu.m_a22 * y + 2 * cu.m_a23 * z;
     double fz = 2 * cu.m_a34 + 2 * cu.m_a13 * x + 2 * cu.m_a23 * y + 2 * cu.m_a33 * z;
@@ -367,66 +154,93 @@ OptCollisionPoint getCubicCollision(const glm::dvec3& __restrict rayPosition, co
 /**************************************************************
  *                    Toroid Collision
  **************************************************************/
-// this uses newton to approximate a solution.
+// the toroid is the surface of revolution of a circle (radius shortRad) around the axis parallel to x through (0, longRad, 0), restricted to the
+// half of the torus that contains the origin. inserting the ray into the implicit torus equation gives a quartic in the ray parameter, which is
+// solved in closed form. the cost per ray is bounded, and grazing rays are handled as well as steep ones.
 RAYX_FN_ACC
 OptCollisionPoint getToroidCollision(const glm::dvec3& __restrict rayPosition, const glm::dvec3& __restrict rayDirection,
                                      const Surface::Toroid& __restrict toroid, bool isTriangul) {
     // Constants
-    const double NEW_TOLERANCE   = 0.0001;
-    const int NEW_MAX_ITERATIONS = 50;
+    const int POLISH_ITERATIONS = 2;
 
-    double longRad  = toroid.m_longRadius;
-    double shortRad = (toroid.m_toroidType == ToroidType::Convex) ? -toroid.m_shortRadius : toroid.m_shortRadius;
+    const double longRad  = toroid.m_longRadius;
+    const double shortRad = (toroid.m_toroidType == ToroidType::Convex) ? -toroid.m_shortRadius : toroid.m_shortRadius;
 
     // sign radius: +1 = concave, -1 = convex
-    double isigro = glm::sign(shortRad);
-
-    // double aln = rayDirection.x / rayDirection.z;
-    // double amn = rayDirection.y / rayDirection.z;
-
-    glm::dvec4 normal         = glm::dvec4(0, 0, 0, 0);
-    double xx                 = 0.0;
-    double zz                 = 0.0;
-    double yy                 = 0.0;
-    double dz                 = 0.0;
-    glm::dvec3 normalized_dir = glm::dvec3(rayDirection) / rayDirection.z;
-
-    int n = 0;
-    // Newton's method iteration
-    // While not converged...
-    do {
-        zz = zz + dz;
-        xx = rayPosition.x + normalized_dir.x * (zz - rayPosition.z);
-        if (xx * xx > shortRad * shortRad) { xx = xx / glm::abs(xx) * 0.95 * shortRad; }
-        yy        = rayPosition.y + normalized_dir.y * (zz - rayPosition.z);
-        double sq = sqrt(shortRad * shortRad - xx * xx);
-        double rx = (longRad - shortRad + isigro * sq);
-
-        // Calculate toroid normal
-        normal.x = (-2 * xx * isigro / sq) * rx;
-        normal.y = -2 * (yy - longRad);
-        normal.z = -2 * zz;
-
-        double func = -rx * rx + (yy - longRad) * (yy - longRad) + zz * zz;
-        double df   = normalized_dir.x * normal.x + normalized_dir.y * normal.y + normal.z;  // dot(normalized_dir, glm::dvec3(normal));
-        dz          = func / df;
-        n += 1;
-        if (n >= NEW_MAX_ITERATIONS) { return std::nullopt; }
-    } while (glm::abs(dz) > NEW_TOLERANCE);
+    const double isigro = glm::sign(shortRad);
+
+    // distance of the circle of tube centers to the axis of revolution
+    const double tubeDist  = longRad - shortRad;
+    const double shortRad2 = shortRad * shortRad;
+    const auto axisCenter  = glm::dvec3(0, longRad, 0);
+
+    // parameterize the ray relative to its point closest to the axis center, and scale to unit size. this keeps the quartic well conditioned
+    const auto dir             = glm::normalize(rayDirection);
+    const auto t0              = glm::dot(axisCenter - rayPosition, dir);
+    const auto scale           = glm::max(glm::abs(tubeDist), glm::abs(shortRad));
+    const auto o               = (rayPosition + t0 * dir - axisCenter) / scale;
+    const auto tubeDistScaled2 = tubeDist * tubeDist / (scale * scale);
+    const auto shortRadScaled2 = shortRad2 / (scale * scale);
+
+    // (|P|^2 + tubeDist^2 - shortRad^2)^2 = 4 * tubeDist^2 * (P.y^2 + P.z^2) with P = o + u * dir
+    const auto b = 2 * glm::dot(o, dir);
+    const auto k = glm::dot(o, o) + tubeDistScaled2 - shortRadScaled2;
+    const auto e = dir.y * dir.y + dir.z * dir.z;
+    const auto f = 2 * (o.y * dir.y + o.z * dir.z);
+    const auto h = o.y * o.y + o.z * o.z;
+
+    double roots[4];
+    const auto numRoots = solveQuartic(2 * b, b * b + 2 * k - 4 * tubeDistScaled2 * e, 2 * b * k - 4 * tubeDistScaled2 * f,
+                                       k * k - 4 * tubeDistScaled2 * h, roots);
+
+    // of all intersections with the correct half of the torus, take the one closest to the origin of the element
+    bool found      = false;
+    double bestT    = 0.0;
+    double bestDist = 0.0;
+    for (int i = 0; i < numRoots; ++i) {
+        auto t = t0 + roots[i] * scale;
+
+        // polish on the distance to the tube, which does not suffer from the large coefficients of the quartic
+        for (int n = 0; n < POLISH_ITERATIONS; ++n) {
+            const auto p   = rayPosition + t * dir - axisCenter;
+            const auto rho = sqrt(p.y * p.y + p.z * p.z);
+            if (rho == 0.0) break;
+            const auto func = (rho - tubeDist) * (rho - tubeDist) + p.x * p.x - shortRad2;
+            const auto df   = 2 * (rho - tubeDist) * (p.y * dir.y + p.z * dir.z) / rho + 2 * p.x * dir.x;
+            if (df != 0.0) t -= func / df;
+        }
+
+        const auto hitpoint = rayPosition + t * dir;
+        const auto p        = hitpoint - axisCenter;
+        const auto rho      = sqrt(p.y * p.y + p.z * p.z);
+        if (isigro * (rho - tubeDist) < 0.0) continue;
+
+        const auto dist = glm::dot(hitpoint, hitpoint);
+        if (!found || dist < bestDist) {
+            found    = true;
+            bestT    = t;
+            bestDist = dist;
+        }
+    }
+
+    if (!found) return std::nullopt;
+
+    const auto hitpoint = rayPosition + bestT * dir;
+    const auto p        = hitpoint - axisCenter;
+    const auto rho      = sqrt(p.y * p.y + p.z * p.z);
+
+    // gradient of the distance to the tube, oriented like the normal of the former newton based implementation
+    const auto normal = -isigro * glm::dvec3(p.x, (rho - tubeDist) * p.y / rho, (rho - tubeDist) * p.z / rho);
 
     CollisionPoint col;
-    col.normal   = normalize(glm::dvec3(normal));
-    col.hitpoint = glm::dvec3(xx, yy, zz);
+    col.normal   = normalize(normal);
+    col.hitpoint = hitpoint;
 
     if (isTriangul)  // TODO: Hack, Triangulation sensetive to direction apparently. Actual fix or func rework is needed!
         return col;
 
-    glm::dvec3 rayToHitpoint = col.hitpoint - rayPosition;
-    // edit: if ray points away from the hitpoint, no collision can be found.
-    // Note that multiplying the rays direction with -1 SHOULD totally have an effect on the collision detection - in most cases this 180° rotation
-    // will make the ray point away from the toroid, and hence preventing a Collision completely. The above code however, is unaffected when
-    // multiplying the ray direction with -1. Due to it having no effect on `glm::dvec3 normalized_dir = glm::dvec3(rayDirection) / rayDirection.z;`
-    if (dot(rayToHitpoint, rayDirection) <= 0.0) return std::nullopt;
+    // if ray points away from the hitpoint, no collision can be found.
+    if (bestT <= 0.0) return std::nullopt;
 
     return col;
 }
@@ -184,22 +184,24 @@ inline ComplexFresnelCoeffs computeMultilayerReflectance(
     const double* __restrict thicknesses,    // Längen: numLayers
     const complex::Complex* __restrict iors  // Längen: numLayers + 2 (Vakuum + Schichten + Substrat)
 ) {
-    constexpr int MAX_ANGLES = 18;  // unterstützt bis zu 16 Schichten
-    complex::Complex thetas[MAX_ANGLES];
-
-    // Einfallswinkel in den einzelnen Schichten
-    thetas[0] = incidentAngle;
-    for (int i = 1; i <= numLayers + 1; ++i) { thetas[i] = calcRefractAngle(thetas[i - 1], iors[i - 1], iors[i]); }
+    // Einfallswinkel in Schicht i. Nach Snellius gilt iors[0] * sin(incidentAngle) = iors[i] * sin(theta_i), daher muss der Winkel nicht
+    // Schicht für Schicht berechnet und für alle Schichten gespeichert werden
+    const auto calcTheta = [&](const int i) { return i == 0 ? incidentAngle : calcRefractAngle(incidentAngle, iors[0], iors[i]); };
 
     // Startwert: Reflexion an Substratgrenze
-    ComplexFresnelCoeffs r = calcReflectAmplitude(thetas[numLayers], thetas[numLayers + 1], iors[numLayers], iors[numLayers + 1]);
+    auto thetaBelow        = calcTheta(numLayers + 1);
+    auto thetaAbove        = calcTheta(numLayers);
+    ComplexFresnelCoeffs r = calcReflectAmplitude(thetaAbove, thetaBelow, iors[numLayers], iors[numLayers + 1]);
 
     // Parratt-Rekursion von unten nach oben
     for (int j = numLayers - 1; j >= 0; --j) {
-        const auto delta = (2.0 * PI / wavelength) * iors[j + 1] * complex::cos(thetas[j + 1]) * thicknesses[j];
+        thetaBelow = thetaAbove;
+        thetaAbove = calcTheta(j);
+
+        const auto delta = (2.0 * PI / wavelength) * iors[j + 1] * complex::cos(thetaBelow) * thicknesses[j];
         const auto phase = complex::exp(complex::Complex(0.0, 2.0) * delta);
 
-        const auto r_j = calcReflectAmplitude(thetas[j], thetas[j + 1], iors[j], iors[j + 1]);
+        const auto r_j = calcReflectAmplitude(thetaAbove, thetaBelow, iors[j], iors[j + 1]);
 
         r.s = (r_j.s + r.s * phase) / (complex::Complex(1.0) + r_j.s * r.s * phase);
         r.p = (r_j.p + r.p * phase) / (complex::Complex(1.0) + r_j.p * r.p * phase);
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "Element/Element.h"
+#include "MultilayerTable.h"
 #include "RaysPtr.h"
+#include "RefractiveIndex.h"
 
 namespace RAYX {
 
@@ -22,7 +24,9 @@ struct RAYX_API ConstState {
     OpticalElement* __restrict elements;
     int* __restrict materialIndices;
     double* __restrict materialTable;
-    bool* __restrict objectRecordMask;  // Mask that decides which elements to record events for (array length is numElements)
+    RefractiveIndexTable refractiveIndexTable;     // optional resampled material data. disabled if numSamples is 0
+    MultilayerTable* __restrict multilayerTables;  // one per element. disabled for elements without a tabulated multilayer coating
+    bool* __restrict objectRecordMask;             // Mask that decides which elements to record events for (array length is numElements)
     RayAttrMask attrRecordMask;
     RaysPtr rays;
 };
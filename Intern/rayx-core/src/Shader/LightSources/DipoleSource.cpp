@@ -1,6 +1,8 @@
 #include "DipoleSource.h"
 
+#include <algorithm>
 #include <fstream>
+#include <limits>
 
 #include "Debug/Debug.h"
 #include "Debug/Instrumentor.h"
@@ -361,6 +363,51 @@ double calcMaxFlux(double photonEnergy, double energySpread, double criticalEner
 
 double calcGamma(double electronEnergy) { return std::fabs(electronEnergy) * get_factorElectronEnergy(); }
 
+namespace {
+
+/// places numQuantiles samples on uniformly spaced quantiles of a distribution, given by its density at the ascending positions xs.
+/// the density is integrated with the trapezoidal rule. falls back to a uniform distribution, if the density vanishes everywhere
+std::vector<double> invertCumulativeDistribution(const std::vector<double>& xs, const std::vector<double>& density, const int numQuantiles) {
+    const auto n = static_cast<int>(xs.size());
+
+    auto cdf = std::vector<double>(n, 0.0);
+    for (int i = 1; i < n; ++i) { cdf[i] = cdf[i - 1] + 0.5 * (density[i - 1] + density[i]) * (xs[i] - xs[i - 1]); }
+
+    auto quantiles = std::vector<double>(numQuantiles);
+    if (!(cdf.back() > 0.0)) {
+        for (int k = 0; k < numQuantiles; ++k) { quantiles[k] = xs.front() + (xs.back() - xs.front()) * k / (numQuantiles - 1); }
+        return quantiles;
+    }
+
+    auto i = 0;
+    for (int k = 0; k < numQuantiles; ++k) {
+        const auto target = cdf.back() * k / (numQuantiles - 1);
+        while (i < n - 2 && cdf[i + 1] < target) { ++i; }
+
+        const auto mass = cdf[i + 1] - cdf[i];
+        const auto t    = mass > 0.0 ? std::clamp((target - cdf[i]) / mass, 0.0, 1.0) : 0.0;
+        quantiles[k]    = xs[i] + t * (xs[i + 1] - xs[i]);
+    }
+    return quantiles;
+}
+
+}  // unnamed namespace
+
+DipoleSamplingTables DipoleSamplingTablesData::view() const {
+    return DipoleSamplingTables{
+        .energies      = energies.data(),
+        .psis          = psis.data(),
+        .stokes        = stokes.data(),
+        .numQuantiles  = numQuantiles,
+        .numEnergies   = numEnergies,
+        .numPsis       = numPsis,
+        .energyMin     = energyMin,
+        .invEnergyStep = invEnergyStep,
+        .psiMin        = psiMin,
+        .invPsiStep    = invPsiStep,
+    };
+}
+
 DipoleSource::DipoleSource(const DesignSource& dSource)
     : LightSourceBase(dSource),
       m_bendingRadius(dSource.getBendingRadius()),
@@ -383,6 +430,66 @@ DipoleSource::DipoleSource(const DesignSource& dSource)
     m_maxIntensity = calcMaxIntensity(m_photonEnergy, m_verDivergence, m_electronEnergy, m_criticalEnergy, m_electronEnergyOrientation, rand);
     m_maxFlux      = calcMaxFlux(m_photonEnergy, m_energySpread, m_criticalEnergy, m_gamma);
     // m_flux = calcFluxOrg(m_photonEnergy, m_energySpread, dSource.getEnergySpreadUnit(), m_horDivergence, m_stokes);
+    m_samplingTables = DipoleSamplingTablesData{}.view();  // disabled until set by the tracer
+}
+
+DipoleSamplingTablesData DipoleSource::createSamplingTables(int numQuantiles, int numEnergies, int numPsis) const {
+    RAYX_PROFILE_FUNCTION_STDOUT();
+
+    if (numQuantiles < 2 || numEnergies < 1 || numPsis < 2) RAYX_EXIT << "invalid resolution of dipole sampling tables";
+
+    auto data = DipoleSamplingTablesData{};
+
+    // energy. the Schwinger function is resolved finer than the quantiles
+    const auto numEnergySamples = 4 * numQuantiles;
+    const auto energyMin        = m_photonEnergy - m_energySpread / 2.0;
+    auto energySamples          = std::vector<double>(numEnergySamples);
+    auto flux                   = std::vector<double>(numEnergySamples);
+    for (int i = 0; i < numEnergySamples; ++i) {
+        energySamples[i] = energyMin + m_energySpread * i / (numEnergySamples - 1);
+        flux[i]          = schwinger(energySamples[i], m_gamma, m_criticalEnergy);
+    }
+    data.energies     = invertCumulativeDistribution(energySamples, flux, numQuantiles);
+    data.numQuantiles = numQuantiles;
+
+    // the rows span the energies, that are actually emitted
+    const auto rowEnergyMin = data.energies.front();
+    const auto rowEnergyMax = data.energies.back();
+    data.numEnergies        = rowEnergyMax > rowEnergyMin ? numEnergies : 1;
+    data.energyMin          = rowEnergyMin;
+    data.invEnergyStep      = data.numEnergies > 1 ? (data.numEnergies - 1) / (rowEnergyMax - rowEnergyMin) : 0.0;
+
+    // psi in mrad, in the same range as the rejection sampling in getPsiandStokes
+    const auto psiMin = -3.0 * m_verDivergence;
+    const auto psiMax = 3.0 * m_verDivergence;
+    auto psiSamples   = std::vector<double>(numPsis);
+    for (int j = 0; j < numPsis; ++j) { psiSamples[j] = psiMin + (psiMax - psiMin) * j / (numPsis - 1); }
+    data.numPsis    = numPsis;
+    data.psiMin     = psiMin;
+    data.invPsiStep = psiMax > psiMin ? (numPsis - 1) / (psiMax - psiMin) : 0.0;
+
+    data.psis.reserve(data.numEnergies * numQuantiles);
+    data.stokes.reserve(data.numEnergies * numPsis);
+    auto intensity = std::vector<double>(numPsis);
+    for (int i = 0; i < data.numEnergies; ++i) {
+        // the Bessel series is only valid for positive energies
+        const auto rowEnergy = data.numEnergies > 1 ? rowEnergyMin + i / data.invEnergyStep : rowEnergyMin;
+        const auto energy    = std::max(rowEnergy, std::numeric_limits<double>::min());
+
+        for (int j = 0; j < numPsis; ++j) {
+            const auto s = getStokesSyn(energy, psiSamples[j], psiSamples[j], m_electronEnergy, m_criticalEnergy, m_electronEnergyOrientation);
+
+            // same layout as returned by calcDipoleFold
+            const auto stokes = glm::dvec4(s[2] + s[3], s[0], 0.0, s[1]);
+            data.stokes.push_back(stokes);
+            intensity[j] = stokes[0];
+        }
+
+        const auto psis = invertCumulativeDistribution(psiSamples, intensity, numQuantiles);
+        data.psis.insert(data.psis.end(), psis.begin(), psis.end());
+    }
+
+    return data;
 }
 
 /**
@@ -404,9 +511,11 @@ detail::Ray DipoleSource::genRay(const int rayPathIndex, const int sourceId, Ran
 
     glm::dvec3 position = getXYZPosition(phi, rand);
 
-    en = getEnergy(rand);  // Verteilung nach Schwingerfunktion
+    // Verteilung nach Schwingerfunktion
+    const auto useSamplingTables = m_samplingTables.numQuantiles != 0;
+    en                           = useSamplingTables ? sampleEnergy(rand) : getEnergy(rand);
 
-    auto psiandstokes = getPsiandStokes(en, rand);
+    auto psiandstokes = useSamplingTables ? samplePsiandStokes(en, rand) : getPsiandStokes(en, rand);
     psiandstokes.psi  = psiandstokes.psi;
 
     // get corresponding angles based on distribution and deviation from
@@ -499,4 +608,64 @@ PsiAndStokes DipoleSource::getPsiandStokes(double en, Rand& __restrict rand) con
     return psiandstokes;
 }
 
+/**
+ * chooses photon energy according to the natural energy distribution spectrum by schwinger, using the inverse cumulative distribution table
+ */
+RAYX_FN_ACC
+double DipoleSource::sampleEnergy(Rand& __restrict rand) const {
+    const auto& tables = m_samplingTables;
+
+    const double x = rand.randomDouble() * (tables.numQuantiles - 1);
+    const int i    = glm::min(static_cast<int>(x), tables.numQuantiles - 2);
+
+    return glm::mix(tables.energies[i], tables.energies[i + 1], x - i);
+}
+
+/**
+ * chooses psi and stokes-vector according to the natural distribution spectrum, using the inverse cumulative distribution tables.
+ * the tables of the two energy rows next to en are interpolated
+ */
+RAYX_FN_ACC
+PsiAndStokes DipoleSource::samplePsiandStokes(double en, Rand& __restrict rand) const {
+    const auto& tables = m_samplingTables;
+
+    const double y    = glm::clamp((en - tables.energyMin) * tables.invEnergyStep, 0.0, tables.numEnergies - 1.0);
+    const int row     = glm::min(static_cast<int>(y), glm::max(tables.numEnergies - 2, 0));
+    const int nextRow = glm::min(row + 1, tables.numEnergies - 1);
+    const double ty   = y - row;
+
+    // psi in mrad
+    const double x       = rand.randomDouble() * (tables.numQuantiles - 1);
+    const int i          = glm::min(static_cast<int>(x), tables.numQuantiles - 2);
+    const auto samplePsi = [&](const int r) {
+        const auto* quantiles = tables.psis + r * tables.numQuantiles + i;
+        return glm::mix(quantiles[0], quantiles[1], x - i);
+    };
+    double psi = glm::mix(samplePsi(row), samplePsi(nextRow), ty);
+
+    // fold with the vertical divergence of the electron beam, as in calcDipoleFold
+    if (m_verEbeamDivergence != 0.0) {
+        const double trsgyp = -0.5 / m_verEbeamDivergence / m_verEbeamDivergence;
+        const double sgyp   = 4.0e-3 * m_verEbeamDivergence;
+        double sy;
+        do {
+            sy = (rand.randomDouble() - 0.5) * sgyp;
+        } while (exp(trsgyp * sy * sy) - rand.randomDouble() < 0);
+        psi += sy;
+    }
+
+    const double z               = glm::clamp((psi - tables.psiMin) * tables.invPsiStep, 0.0, tables.numPsis - 1.0);
+    const int j                  = glm::min(static_cast<int>(z), tables.numPsis - 2);
+    const auto interpolateStokes = [&](const int r) {
+        const auto* stokes = tables.stokes + r * tables.numPsis + j;
+        return glm::mix(stokes[0], stokes[1], z - j);
+    };
+
+    PsiAndStokes psiandstokes;
+    psiandstokes.stokes = glm::mix(interpolateStokes(row), interpolateStokes(nextRow), ty);
+    psiandstokes.psi    = psi * 1e-3;  // psi in rad
+
+    return psiandstokes;
+}
+
 }  // namespace RAYX
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <list>
+#include <vector>
 
 #include "LightSource.h"
 #include "Shader/Rand.h"
@@ -12,6 +13,40 @@ struct PsiAndStokes {
     double psi;
 };
 
+/// Inverse cumulative distribution tables of a dipole source. Replace the rejection sampling of energy, psi and stokes vector, which evaluates
+/// the Schwinger function and the Bessel series of `getStokesSyn` repeatedly for every ray, by O(1) lookups. A table with `numQuantiles == 0`
+/// is disabled.
+struct DipoleSamplingTables {
+    const double* __restrict energies;    // numQuantiles energies, placed on uniformly spaced quantiles of the Schwinger distribution
+    const double* __restrict psis;        // numEnergies x numQuantiles vertical angles in mrad, placed on uniformly spaced quantiles of the
+                                          // intensity at each energy
+    const glm::dvec4* __restrict stokes;  // numEnergies x numPsis stokes vectors on a uniform grid of psi
+    int numQuantiles;
+    int numEnergies;
+    int numPsis;
+    double energyMin;
+    double invEnergyStep;
+    double psiMin;
+    double invPsiStep;
+};
+
+/// host side storage of `DipoleSamplingTables`
+struct RAYX_API DipoleSamplingTablesData {
+    std::vector<double> energies;
+    std::vector<double> psis;
+    std::vector<glm::dvec4> stokes;
+    int numQuantiles     = 0;
+    int numEnergies      = 0;
+    int numPsis          = 0;
+    double energyMin     = 0.0;
+    double invEnergyStep = 0.0;
+    double psiMin        = 0.0;
+    double invPsiStep    = 0.0;
+
+    /// view of the host side storage. the storage must outlive the view
+    DipoleSamplingTables view() const;
+};
+
 RAYX_API double get_factorCriticalEnergy();
 RAYX_API double get_factorElectronEnergy();
 RAYX_API double get_factorOmega();
@@ -35,14 +70,22 @@ class RAYX_API DipoleSource : public LightSourceBase {
 
     RAYX_FN_ACC detail::Ray genRay(const int rayPathIndex, const int sourceId, Rand& __restrict rand) const;
 
+    /// builds the sampling tables on the host. the resolution of the tables is given in number of samples
+    DipoleSamplingTablesData createSamplingTables(int numQuantiles = 1024, int numEnergies = 64, int numPsis = 513) const;
+
+    /// genRay samples from the tables, instead of rejection sampling. the tables must outlive this source
+    void setSamplingTables(const DipoleSamplingTables& tables) { m_samplingTables = tables; }
+
   private:
     // calculate Ray-Information
     RAYX_FN_ACC glm::dvec3 getXYZPosition(double, Rand& __restrict rand) const;
     RAYX_FN_ACC PsiAndStokes getPsiandStokes(double, Rand& __restrict rand) const;
+    RAYX_FN_ACC PsiAndStokes samplePsiandStokes(double, Rand& __restrict rand) const;
 
     // support functions
     RAYX_FN_ACC double getNormalFromRange(double range, Rand& __restrict rand) const;
     RAYX_FN_ACC double getEnergy(Rand& __restrict rand) const;
+    RAYX_FN_ACC double sampleEnergy(Rand& __restrict rand) const;
 
     // Geometric Params
     double m_bendingRadius;
@@ -79,6 +122,8 @@ class RAYX_API DipoleSource : public LightSourceBase {
     double m_maxIntensity;
     double m_horDivergence;
     double m_verDivergence;
+
+    DipoleSamplingTables m_samplingTables;
 };
 
 }  // namespace RAYX
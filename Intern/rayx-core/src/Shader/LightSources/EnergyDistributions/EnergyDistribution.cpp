@@ -1,25 +1,9 @@
 #include "EnergyDistribution.h"
 
-namespace {
-
-RAYX_FN_ACC
-int binarySearchPrefix(const double* __restrict prefixWeights, int size, double r) {
-    int left  = 0;
-    int right = size - 1;
-
-    while (left < right) {
-        int mid = left + (right - left) / 2;
-        if (r > prefixWeights[mid]) {
-            left = mid + 1;
-        } else {
-            right = mid;
-        }
-    }
-
-    return left;
-}
+#include <cmath>
+#include <numeric>
 
-}  // unnamed namespace
+#include "Debug/Debug.h"
 
 namespace RAYX {
 
@@ -50,15 +34,108 @@ RAYX_FN_ACC double selectEnergy(const SeparateEnergies& __restrict separateEnerg
 }
 
 RAYX_FN_ACC double selectEnergy(const EnergyDistributionList& __restrict energyDistributionList, Rand& __restrict rand) {
-    // TODO: implement all the other stuff from DayFile::selectEnergy
-    // TODO: implement continous
-    const auto r    = rand.randomDouble() * energyDistributionList.weightSum;
-    const int index = binarySearchPrefix(energyDistributionList.prefixWeights, energyDistributionList.size, r);
-    return energyDistributionList.energies[index];
+    const auto& list = energyDistributionList;
+
+    // Walker's alias method: choose a column uniformly, then either keep it or jump to its alias
+    const double x           = rand.randomDouble() * list.size;
+    const int column         = glm::min(static_cast<int>(x), list.size - 1);
+    const double u           = x - column;
+    const double probability = list.probabilities[column];
+    const bool keep          = u < probability;
+    const int index          = keep ? column : list.aliases[column];
+
+    if (!list.continous) return list.energies[index];
+
+    // the remainder of the random number is uniformly distributed as well. use it as position within the segment
+    const double v = keep ? u / probability : (u - probability) / (1.0 - probability);
+
+    // invert the cumulative distribution of the weights, interpolated linearly between the lines
+    const double a           = list.weights[index];
+    const double b           = list.weights[index + 1];
+    const double denominator = a + glm::sqrt(a * a + v * (b * b - a * a));
+    const double t           = denominator > 0.0 ? v * (a + b) / denominator : v;
+
+    return glm::mix(list.energies[index], list.energies[index + 1], glm::min(t, 1.0));
 }
 
 RAYX_FN_ACC double selectEnergy(const EnergyDistributionDataVariant& __restrict energyDistribution, Rand& __restrict rand) {
     return std::visit([&]<typename T>(const T& __restrict value) { return selectEnergy(value, rand); }, energyDistribution);
 }
 
+EnergyDistributionList EnergyDistributionListData::view() const {
+    return EnergyDistributionList{
+        .probabilities = probabilities.data(),
+        .aliases       = aliases.data(),
+        .energies      = energies.data(),
+        .weights       = weights.data(),
+        .size          = size,
+        .continous     = continous,
+    };
+}
+
+EnergyDistributionListData createEnergyDistributionList(const DatFile& datFile) {
+    const auto numLines = static_cast<int>(datFile.m_Lines.size());
+    if (numLines == 0) RAYX_EXIT << "DatFile \"" << datFile.m_title << "\" does not contain any lines";
+
+    auto data = EnergyDistributionListData{};
+    for (const auto& line : datFile.m_Lines) {
+        if (line.m_weight < 0.0) RAYX_EXIT << "DatFile \"" << datFile.m_title << "\" contains a negative weight: " << line.m_weight;
+        data.energies.push_back(line.m_energy);
+        data.weights.push_back(line.m_weight);
+    }
+
+    // a continuous distribution requires at least one segment
+    data.continous = datFile.m_continuous && numLines > 1;
+
+    // probability mass of each column
+    auto masses = std::vector<double>();
+    if (data.continous) {
+        for (int i = 0; i < numLines - 1; ++i) {
+            masses.push_back(0.5 * (data.weights[i] + data.weights[i + 1]) * std::abs(data.energies[i + 1] - data.energies[i]));
+        }
+    } else {
+        masses = data.weights;
+    }
+
+    data.size        = static_cast<int>(masses.size());
+    const auto total = std::accumulate(masses.begin(), masses.end(), 0.0);
+    if (!(total > 0.0)) RAYX_EXIT << "DatFile \"" << datFile.m_title << "\" has a vanishing total weight";
+
+    // Vose's construction of the alias table. columns with less than average mass are filled up by columns with more
+    data.probabilities.resize(data.size);
+    data.aliases.resize(data.size);
+    auto scaled = std::vector<double>(data.size);
+    auto small  = std::vector<int>();
+    auto large  = std::vector<int>();
+    for (int i = 0; i < data.size; ++i) {
+        scaled[i] = masses[i] * data.size / total;
+        (scaled[i] < 1.0 ? small : large).push_back(i);
+    }
+
+    while (!small.empty() && !large.empty()) {
+        const auto s = small.back();
+        const auto l = large.back();
+        small.pop_back();
+        large.pop_back();
+
+        data.probabilities[s] = scaled[s];
+        data.aliases[s]       = l;
+
+        scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+        (scaled[l] < 1.0 ? small : large).push_back(l);
+    }
+
+    // remaining columns are full, up to rounding errors
+    for (const auto i : small) {
+        data.probabilities[i] = 1.0;
+        data.aliases[i]       = i;
+    }
+    for (const auto i : large) {
+        data.probabilities[i] = 1.0;
+        data.aliases[i]       = i;
+    }
+
+    return data;
+}
+
 }  // namespace RAYX
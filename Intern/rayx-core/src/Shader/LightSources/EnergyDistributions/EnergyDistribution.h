@@ -1,19 +1,41 @@
 #pragma once
 
+#include <vector>
+
 #include "Beamline/EnergyDistribution.h"
 #include "Core.h"
 #include "Shader/Rand.h"
 
 namespace RAYX {
 
+/// Energy distribution of a DatFile, prepared for sampling with Walker's alias method in O(1).
+/// Discrete distributions have one column per line. Continuous distributions interpolate the weights linearly between the lines and have
+/// one column per segment between two consecutive lines.
 struct EnergyDistributionList {
-    double* __restrict prefixWeights;
-    double* __restrict energies;
-    double weightSum;
-    int size;
+    const double* __restrict probabilities;  // probability to keep a column, instead of jumping to its alias
+    const int* __restrict aliases;
+    const double* __restrict energies;  // energies of the lines
+    const double* __restrict weights;   // weights of the lines
+    int size;                           // number of columns
     bool continous;
 };
 
+/// host side storage of `EnergyDistributionList`
+struct RAYX_API EnergyDistributionListData {
+    std::vector<double> probabilities;
+    std::vector<int> aliases;
+    std::vector<double> energies;
+    std::vector<double> weights;
+    int size       = 0;
+    bool continous = false;
+
+    /// view of the host side storage. the storage must outlive the view
+    EnergyDistributionList view() const;
+};
+
+/// builds the alias table of the lines in datFile
+RAYX_API EnergyDistributionListData createEnergyDistributionList(const DatFile& datFile);
+
 // TODO: use cuda::std::variant
 using EnergyDistributionDataVariant = std::variant<HardEdge, SoftEdge, SeparateEnergies, EnergyDistributionList>;
 
@@ -0,0 +1,28 @@
+#include "RayListSource.h"
+
+#include "Shader/ElectricField.h"
+
+namespace RAYX {
+
+RAYX_FN_ACC detail::Ray RayListSource::genRay(const int i, const int rayPathIndex, const int sourceId, Rand& __restrict rand) const {
+    const auto direction     = rays.direction(i);
+    const auto electricField = contains(attrMask, RayAttrMask::ElectricField) ? rays.electric_field(i)
+                                                                               : stokesToElectricFieldWithBaseConvention(Stokes(1, 1, 0, 0), direction);
+
+    return detail::Ray{
+        .position            = rays.position(i),
+        .direction           = direction,
+        .energy              = rays.energy[i],
+        .optical_path_length = contains(attrMask, RayAttrMask::OpticalPathLength) ? rays.optical_path_length[i] : 0.0,
+        .electric_field      = electricField,
+        .rand                = contains(attrMask, RayAttrMask::RandCounter) ? Rand(rays.rand_counter[i]) : std::move(rand),
+        .path_id             = contains(attrMask, RayAttrMask::PathId) ? rays.path_id[i] : rayPathIndex,
+        .path_event_id       = contains(attrMask, RayAttrMask::PathEventId) ? rays.path_event_id[i] : -1,
+        .order               = contains(attrMask, RayAttrMask::Order) ? rays.order[i] : 0,
+        .object_id           = sourceId,
+        .source_id           = sourceId,
+        .event_type          = contains(attrMask, RayAttrMask::EventType) ? rays.event_type[i] : EventType::Emitted,
+    };
+}
+
+}  // namespace RAYX
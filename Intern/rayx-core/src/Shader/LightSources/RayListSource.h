@@ -2,11 +2,22 @@
 
 #include "LightSource.h"
 #include "Rays.h"
+#include "Shader/Ray.h"
+#include "Shader/RaysPtr.h"
 
 namespace RAYX {
 
+/// rays of a ray list, that are streamed to the device batch by batch. The ray list may contain only some of the attributes, see `genRay`
 struct RAYX_API RayListSource {
-    RaysPtr rays;
+    RaysPtr rays;          // rays of the current batch
+    RayAttrMask attrMask;  // attributes contained in rays
+
+    /// attributes, that a ray list must contain
+    static constexpr RayAttrMask requiredAttrMask = RayAttrMask::Position | RayAttrMask::Direction | RayAttrMask::Energy;
+
+    /// loads the i-th ray of the current batch. Attributes missing in the ray list are replaced by the values a generated ray would have. The
+    /// electric field defaults to linear horizontal polarization
+    RAYX_FN_ACC detail::Ray genRay(const int i, const int rayPathIndex, const int sourceId, Rand& __restrict rand) const;
 };
 
 }  // namespace RAYX
@@ -72,14 +72,6 @@ SimpleUndulatorSource::SimpleUndulatorSource(const DesignSource& dSource) : Ligh
     m_sourceHeight  = getSourceHeight(electronSigmaY, undulatorSigma);
 }
 
-/**
- * get deviation from main ray according to specified distribution (uniform if
- * hard edge, gaussian if soft edge)) and extent (eg specified width/height of
- * source)
- */
-RAYX_FN_ACC
-double SimpleUndulatorSource::getCoord(const double extent, Rand& __restrict rand) const { return rand.randomDoubleNormalDistributed(0, 1) * extent; }
-
 /**
  * Creates random rays from simple undulator Source
  *
@@ -90,14 +82,16 @@ detail::Ray SimpleUndulatorSource::genRay(const int rayPathIndex, const int sour
                                           const EnergyDistributionDataVariant& __restrict energyDistribution, Rand& __restrict rand) const {
     // create ray with random position and divergence within the given span
     // for width, height, depth, horizontal and vertical divergence
-    auto x              = getCoord(m_sourceWidth, rand);
-    auto y              = getCoord(m_sourceHeight, rand);
+    double normals[4];
+    rand.randomDoublesNormalDistributed(normals);
+    auto x              = normals[0] * m_sourceWidth;
+    auto y              = normals[1] * m_sourceHeight;
     auto z              = (rand.randomDouble() - 0.5) * m_sourceDepth;
     const auto en       = selectEnergy(energyDistribution, rand);
     glm::dvec3 position = glm::dvec3(x, y, z);
 
-    const auto phi = getCoord(m_horDivergence, rand);
-    const auto psi = getCoord(m_verDivergence, rand);
+    const auto phi = normals[2] * m_horDivergence;
+    const auto psi = normals[3] * m_verDivergence;
     // get corresponding angles based on distribution and deviation from
     // main ray (main ray: xDir=0,yDir=0,zDir=1 for phi=psi=0)
     glm::dvec3 direction = getDirectionFromAngles(phi, psi);
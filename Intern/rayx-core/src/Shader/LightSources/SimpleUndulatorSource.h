@@ -12,8 +12,6 @@ class RAYX_API SimpleUndulatorSource : public LightSourceBase {
     RAYX_FN_ACC detail::Ray genRay(const int rayPathIndex, const int sourceId, const EnergyDistributionDataVariant& __restrict energyDistribution,
                                    Rand& __restrict rand) const;
 
-    RAYX_FN_ACC double getCoord(const double extent, Rand& __restrict rand) const;
-
   private:
     // Geometric Params
     double m_horDivergence;
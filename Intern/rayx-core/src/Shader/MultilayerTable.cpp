@@ -0,0 +1,79 @@
+#include "MultilayerTable.h"
+
+#include "Utils.h"
+
+namespace RAYX {
+
+RAYX_FN_ACC
+ComplexFresnelCoeffs RAYX_API calcMultilayerReflectance(const double energy, const double incidentAngle,
+                                                        const Coating::MultilayerCoating& __restrict coating, const int substrateMaterial,
+                                                        const int* __restrict materialIndices, const double* __restrict materialTable,
+                                                        const RefractiveIndexTable& __restrict refractiveIndexTable,
+                                                        RefractiveIndexCache& __restrict refractiveIndexCache) {
+    const auto getIor = [&](const int m) {
+        return getRefractiveIndex(energy, m, materialIndices, materialTable, refractiveIndexTable, refractiveIndexCache);
+    };
+
+    constexpr int vacuum_material = -1;
+    const int n                   = coating.numLayers;
+    complex::Complex iors[1002];
+
+    iors[0] = getIor(vacuum_material);
+    for (int i = 0; i < n; ++i) { iors[i + 1] = getIor(coating.material[i]); }
+    iors[n + 1] = getIor(substrateMaterial);
+
+    const auto angle = complex::Complex(incidentAngle == 0.0 ? 1e-8 : incidentAngle, 0.0);
+
+    const double wavelength = energyToWaveLength(energy);
+
+    return computeMultilayerReflectance(angle, wavelength, n, coating.thickness, iors);
+}
+
+RAYX_FN_ACC
+std::optional<ComplexFresnelCoeffs> RAYX_API lookupMultilayerReflectance(const double energy, const double incidentAngle,
+                                                                         const MultilayerTable& __restrict table) {
+    if (table.numEnergies < 2 || table.numAngles < 2) return std::nullopt;
+
+    // position on the grid, measured in samples
+    const double x = (energy - table.energyMin) * table.invEnergyStep;
+    const double y = (incidentAngle - table.angleMin) * table.invAngleStep;
+
+    // written as a negation, to also catch NaN
+    if (!(0.0 <= x && x <= table.numEnergies - 1 && 0.0 <= y && y <= table.numAngles - 1)) return std::nullopt;
+
+    const int i   = glm::min(static_cast<int>(x), table.numEnergies - 2);
+    const int j   = glm::min(static_cast<int>(y), table.numAngles - 2);
+    const auto tx = x - i;
+    const auto ty = y - j;
+
+    const auto* low  = table.samples + i * table.numAngles + j;
+    const auto* high = low + table.numAngles;
+
+    const auto lerp   = [](const complex::Complex a, const complex::Complex b, const double t) { return a + (b - a) * t; };
+    const auto bilerp = [&](const complex::Complex a00, const complex::Complex a01, const complex::Complex a10, const complex::Complex a11) {
+        return lerp(lerp(a00, a01, ty), lerp(a10, a11, ty), tx);
+    };
+
+    return ComplexFresnelCoeffs{
+        .s = bilerp(low[0].s, low[1].s, high[0].s, high[1].s),
+        .p = bilerp(low[0].p, low[1].p, high[0].p, high[1].p),
+    };
+}
+
+RAYX_FN_ACC
+double RAYX_API calcMultilayerTableCellDeviation(const int cell, const MultilayerTable& __restrict table,
+                                                 const Coating::MultilayerCoating& __restrict coating, const int substrateMaterial,
+                                                 const int* __restrict materialIndices, const double* __restrict materialTable,
+                                                 const RefractiveIndexTable& __restrict refractiveIndexTable) {
+    const auto numCellsAngle = table.numAngles - 1;
+    const auto energy        = table.energyMin + (cell / numCellsAngle + 0.5) / table.invEnergyStep;
+    const auto angle         = table.angleMin + (cell % numCellsAngle + 0.5) / table.invAngleStep;
+
+    auto refractiveIndexCache = RefractiveIndexCache{};
+    const auto expected       = calcMultilayerReflectance(energy, angle, coating, substrateMaterial, materialIndices, materialTable,
+                                                          refractiveIndexTable, refractiveIndexCache);
+    const auto actual         = *lookupMultilayerReflectance(energy, angle, table);
+    return glm::max(complex::abs(actual.s - expected.s), complex::abs(actual.p - expected.p));
+}
+
+}  // namespace RAYX
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <optional>
+
+#include "Core.h"
+#include "Efficiency.h"
+#include "Element/Coating.h"
+#include "RefractiveIndex.h"
+
+namespace RAYX {
+
+/// Reflectance amplitudes of the multilayer coating of a single element (including its substrate), tabulated on a uniform grid of
+/// energy x incidence angle. Rays hitting the element interpolate the amplitudes in O(1), instead of running the Parratt recursion over all
+/// layers on every hit. The tables are built by the tracer, if enabled in the `TracerConfig`. A table with `numEnergies == 0` is disabled.
+struct MultilayerTable {
+    const ComplexFresnelCoeffs* __restrict samples;  // numEnergies * numAngles amplitudes. the angle is the fastest running index
+    int numEnergies;
+    int numAngles;
+    double energyMin;
+    double invEnergyStep;
+    double angleMin;  // incidence angle relative to the surface normal, in rad
+    double invAngleStep;
+};
+
+/**
+ * computes the reflectance amplitudes of a multilayer coating on top of the substrate material
+ * @param energy photon energy in eV
+ * @param incidentAngle angle between the incoming ray and the surface normal in rad
+ */
+RAYX_FN_ACC ComplexFresnelCoeffs RAYX_API calcMultilayerReflectance(const double energy, const double incidentAngle,
+                                                                    const Coating::MultilayerCoating& __restrict coating, const int substrateMaterial,
+                                                                    const int* __restrict materialIndices, const double* __restrict materialTable,
+                                                                    const RefractiveIndexTable& __restrict refractiveIndexTable,
+                                                                    RefractiveIndexCache& __restrict refractiveIndexCache);
+
+/**
+ * bilinearly interpolates the reflectance amplitudes in the table
+ * @return the amplitudes, or std::nullopt if the table is disabled or does not cover energy and incidentAngle
+ */
+RAYX_FN_ACC std::optional<ComplexFresnelCoeffs> RAYX_API lookupMultilayerReflectance(const double energy, const double incidentAngle,
+                                                                                     const MultilayerTable& __restrict table);
+
+/**
+ * maximal absolute deviation of the interpolated from the exact amplitudes in the center of a cell of the table. The tracer refines the table,
+ * until the deviation in every cell is within the tolerance
+ * @param cell index of the cell. there are (numEnergies - 1) x (numAngles - 1) cells, the angle is the fastest running index
+ */
+RAYX_FN_ACC double RAYX_API calcMultilayerTableCellDeviation(const int cell, const MultilayerTable& __restrict table,
+                                                             const Coating::MultilayerCoating& __restrict coating, const int substrateMaterial,
+                                                             const int* __restrict materialIndices, const double* __restrict materialTable,
+                                                             const RefractiveIndexTable& __restrict refractiveIndexTable);
+
+}  // namespace RAYX
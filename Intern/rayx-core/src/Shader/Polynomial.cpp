@@ -0,0 +1,102 @@
+#include "Polynomial.h"
+
+#include <glm.hpp>
+
+namespace {
+// relative tolerance for negative discriminants, that are considered to be zero
+constexpr double POLYNOMIAL_EPSILON = 1e-12;
+// number of newton steps applied to each root of the quartic
+constexpr int QUARTIC_POLISH_ITERATIONS = 2;
+}  // unnamed namespace
+
+namespace RAYX {
+
+RAYX_FN_ACC
+int RAYX_API solveQuadratic(const double b, const double c, double* __restrict roots) {
+    auto disc = b * b - 4 * c;
+    if (disc < 0) {
+        if (disc < -POLYNOMIAL_EPSILON * (b * b + glm::abs(c))) return 0;
+        disc = 0;
+    }
+
+    // avoid cancellation of -b and sqrt(disc) by computing the larger root first
+    const auto q = -0.5 * (b + (b < 0 ? -1.0 : 1.0) * glm::sqrt(disc));
+    roots[0]     = q;
+    roots[1]     = q != 0 ? c / q : 0;
+    return 2;
+}
+
+RAYX_FN_ACC
+double RAYX_API largestRealRootOfCubic(const double a, const double b, const double c) {
+    // depressed cubic z^3 + p*z + q = 0 with x = z - a/3
+    const auto p     = b - a * a / 3;
+    const auto q     = 2 * a * a * a / 27 - a * b / 3 + c;
+    const auto shift = -a / 3;
+    const auto disc  = q * q / 4 + p * p * p / 27;
+
+    auto x = shift;
+    if (disc > 0) {
+        // one real root
+        const auto cbrt     = [](const double v) { return glm::sign(v) * glm::pow(glm::abs(v), 1.0 / 3.0); };
+        const auto sqrtDisc = glm::sqrt(disc);
+        x += cbrt(-q / 2 + sqrtDisc) + cbrt(-q / 2 - sqrtDisc);
+    } else if (p < 0) {
+        // three real roots, the largest one is found at k = 0
+        const auto r      = glm::sqrt(-p / 3);
+        const auto cosPhi = glm::clamp(-q / (2 * r * r * r), -1.0, 1.0);
+        x += 2 * r * glm::cos(glm::acos(cosPhi) / 3);
+    }
+
+    // one newton step to counter round off of cardanos formula
+    const auto f  = ((x + a) * x + b) * x + c;
+    const auto df = (3 * x + 2 * a) * x + b;
+    if (df != 0) x -= f / df;
+
+    return x;
+}
+
+RAYX_FN_ACC
+int RAYX_API solveQuartic(const double a, const double b, const double c, const double d, double* __restrict roots) {
+    // depressed quartic y^4 + p*y^2 + q*y + r = 0 with x = y - a/4
+    const auto a2    = a * a;
+    const auto p     = b - 3 * a2 / 8;
+    const auto q     = c - a * b / 2 + a2 * a / 8;
+    const auto r     = d - a * c / 4 + a2 * b / 16 - 3 * a2 * a2 / 256;
+    const auto shift = -a / 4;
+
+    // resolvent cubic m^3 + p*m^2 + (p^2/4 - r)*m - q^2/8 = 0. its largest root is non-negative
+    const auto m = largestRealRootOfCubic(p, p * p / 4 - r, -q * q / 8);
+
+    int numRoots = 0;
+    if (m <= POLYNOMIAL_EPSILON * (glm::abs(p) + glm::sqrt(glm::abs(r)))) {
+        // biquadratic: z^2 + p*z + r = 0 with z = y^2
+        double z[2];
+        if (solveQuadratic(p, r, z) == 2) {
+            for (int i = 0; i < 2; ++i) {
+                if (z[i] < 0) continue;
+                const auto y      = glm::sqrt(z[i]);
+                roots[numRoots++] = y;
+                roots[numRoots++] = -y;
+            }
+        }
+    } else {
+        // factor into two quadratics: (y^2 + p/2 + m)^2 = (s*y - q/(2s))^2 with s = sqrt(2m)
+        const auto s = glm::sqrt(2 * m);
+        numRoots += solveQuadratic(-s, p / 2 + m + q / (2 * s), roots + numRoots);
+        numRoots += solveQuadratic(s, p / 2 + m - q / (2 * s), roots + numRoots);
+    }
+
+    for (int i = 0; i < numRoots; ++i) {
+        auto x = roots[i] + shift;
+        for (int k = 0; k < QUARTIC_POLISH_ITERATIONS; ++k) {
+            const auto f  = (((x + a) * x + b) * x + c) * x + d;
+            const auto df = ((4 * x + 3 * a) * x + 2 * b) * x + c;
+            if (df != 0) x -= f / df;
+        }
+        roots[i] = x;
+    }
+
+    return numRoots;
+}
+
+}  // namespace RAYX
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Core.h"
+
+namespace RAYX {
+
+/**
+ * solves the monic quadratic equation x^2 + b*x + c = 0.
+ * slightly negative discriminants (caused by round off at tangential solutions) are treated as zero.
+ * @param roots output array with room for 2 roots. double roots are reported twice
+ * @return number of real roots, either 0 or 2
+ */
+RAYX_FN_ACC int RAYX_API solveQuadratic(const double b, const double c, double* __restrict roots);
+
+/**
+ * finds the largest real root of the monic cubic equation x^3 + a*x^2 + b*x + c = 0 (Cardano, or trigonometric if there are three real roots)
+ */
+RAYX_FN_ACC double RAYX_API largestRealRootOfCubic(const double a, const double b, const double c);
+
+/**
+ * solves the monic quartic equation x^4 + a*x^3 + b*x^2 + c*x + d = 0 in closed form (Ferrari), followed by a fixed number of newton steps to
+ * polish the roots. the cost is bounded and does not depend on the input.
+ * @param roots output array with room for 4 roots. roots are not sorted and multiple roots may be reported more than once
+ * @return number of real roots, either 0, 2 or 4
+ */
+RAYX_FN_ACC int RAYX_API solveQuartic(const double a, const double b, const double c, const double d, double* __restrict roots);
+
+}  // namespace RAYX
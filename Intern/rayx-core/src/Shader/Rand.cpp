@@ -53,4 +53,125 @@ double RAYX_API squaresNormalRNG(RandCounter& ctr, double mu, double sigma) {
     return Z;
 }
 
+namespace {
+
+struct SobolPolynomial {
+    int degree;
+    uint32_t coefficients;
+    uint32_t initialDirections[6];
+};
+
+// primitive polynomials and initial direction numbers of dimensions 1 to 15. dimension 0 is the van der Corput sequence
+constexpr SobolPolynomial SOBOL_POLYNOMIALS[SOBOL_NUM_DIMENSIONS - 1] = {
+    {1, 0, {1}},
+    {2, 1, {1, 3}},
+    {3, 1, {1, 3, 1}},
+    {3, 2, {1, 1, 1}},
+    {4, 1, {1, 1, 3, 3}},
+    {4, 4, {1, 3, 5, 13}},
+    {5, 2, {1, 1, 5, 5, 17}},
+    {5, 4, {1, 1, 5, 5, 5}},
+    {5, 7, {1, 1, 7, 11, 19}},
+    {5, 11, {1, 1, 5, 1, 1}},
+    {5, 13, {1, 1, 1, 3, 11}},
+    {5, 14, {1, 3, 5, 5, 31}},
+    {6, 1, {1, 3, 3, 9, 7, 49}},
+    {6, 13, {1, 1, 1, 15, 21, 21}},
+    {6, 16, {1, 3, 1, 13, 27, 49}},
+};
+
+struct SobolDirections {
+    uint32_t v[SOBOL_NUM_DIMENSIONS][32];
+};
+
+constexpr SobolDirections calcSobolDirections() {
+    SobolDirections directions{};
+    for (int k = 0; k < 32; ++k) { directions.v[0][k] = 1u << (31 - k); }
+
+    for (int d = 1; d < SOBOL_NUM_DIMENSIONS; ++d) {
+        const auto& polynomial = SOBOL_POLYNOMIALS[d - 1];
+        const int s            = polynomial.degree;
+        auto* v                = directions.v[d];
+
+        for (int k = 0; k < 32; ++k) {
+            if (k < s) {
+                v[k] = polynomial.initialDirections[k] << (31 - k);
+            } else {
+                v[k] = v[k - s] ^ (v[k - s] >> s);
+                for (int j = 1; j < s; ++j) {
+                    if ((polynomial.coefficients >> (s - 1 - j)) & 1u) v[k] ^= v[k - j];
+                }
+            }
+        }
+    }
+    return directions;
+}
+
+RAYX_CONSTEXPR_ACC SobolDirections SOBOL_DIRECTIONS = calcSobolDirections();
+
+RAYX_FN_ACC
+uint32_t reverseBits(uint32_t x) {
+    x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+    x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+    x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+    x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+    return (x >> 16) | (x << 16);
+}
+
+// integer hash by C. Wellons (lowbias32)
+RAYX_FN_ACC
+uint32_t hash32(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// permutes the bits of x, such that every bit only depends on the less significant bits (Laine and Karras)
+RAYX_FN_ACC
+uint32_t laineKarrasPermutation(uint32_t x, const uint32_t seed) {
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return x;
+}
+
+}  // unnamed namespace
+
+RAYX_FN_ACC
+double RAYX_API scrambledSobol(uint32_t index, const int dimension, const uint32_t seed) {
+    const auto* v = SOBOL_DIRECTIONS.v[dimension];
+
+    uint32_t x = 0;
+    for (int k = 0; index; ++k, index >>= 1) {
+        if (index & 1u) x ^= v[k];
+    }
+
+    // nested uniform scrambling, with an independent seed per dimension
+    const auto dimensionSeed = hash32(seed ^ hash32(static_cast<uint32_t>(dimension)));
+    x                        = reverseBits(laineKarrasPermutation(reverseBits(x), dimensionSeed));
+
+    return x * (1.0 / 4294967296.0);
+}
+
+RAYX_FN_ACC
+double RAYX_API boxMuller(double u, double v, double mu, double sigma) {
+    double z0, z1;
+    boxMullerPair(u, v, z0, z1);
+    return z0 * sigma + mu;
+}
+
+RAYX_FN_ACC
+void RAYX_API boxMullerPair(double u, double v, double& z0, double& z1) {
+    // 1 - u lies in (0, 1], which keeps the logarithm finite
+    const double r   = glm::sqrt(-2.0 * glm::log(1.0 - u));
+    const double phi = 2.0 * PI * v;
+    z0               = r * glm::cos(phi);
+    z1               = r * glm::sin(phi);
+}
+
 }  // namespace RAYX
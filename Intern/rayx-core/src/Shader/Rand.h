@@ -26,6 +26,26 @@ RAYX_FN_ACC double RAYX_API squaresDoubleRNG(RandCounter& ctr);
 // mu and standard deviation sigma
 RAYX_FN_ACC double RAYX_API squaresNormalRNG(RandCounter& ctr, double mu, double sigma);
 
+// number of dimensions of the Sobol sequence. direction numbers by S. Joe and F. Y. Kuo (new-joe-kuo-6.21201)
+constexpr int SOBOL_NUM_DIMENSIONS = 16;
+
+/*
+ * Title: "Practical Hash-based Owen Scrambling"
+ * Author: Brent Burley
+ * Date: 2020
+ * URL: https://jcgt.org/published/0009/04/01/
+ */
+// returns the coordinate `dimension` of the point `index` of the Sobol sequence, owen scrambled by `seed`. uniformly distributed in [0, 1)
+RAYX_FN_ACC double RAYX_API scrambledSobol(uint32_t index, int dimension, uint32_t seed);
+
+// creates (via the Box-Muller transform) a normal distributed double with mean mu and standard deviation sigma from two uniformly
+// distributed doubles in [0, 1)
+RAYX_FN_ACC double RAYX_API boxMuller(double u, double v, double mu, double sigma);
+
+// creates (via the Box-Muller transform) a pair of independent standard normal distributed doubles from two uniformly distributed doubles in
+// [0, 1). the first one equals boxMuller(u, v, 0, 1)
+RAYX_FN_ACC void RAYX_API boxMullerPair(double u, double v, double& z0, double& z1);
+
 struct Rand {
     Rand() noexcept {}
 
@@ -53,25 +73,99 @@ struct Rand {
         // counter = rayPathIndex * workerCounterNum + randomPhase;
     }
 
+    // draws the following random doubles from the point `index` of a scrambled Sobol sequence (quasi Monte Carlo), until its dimensions are
+    // used up or endQuasiRandom is called. afterwards the pseudo random counter continues. the quasi random state is not stored with rays
+    RAYX_FN_ACC
+    void beginQuasiRandom(const uint32_t index, const uint32_t seed) {
+        sobolIndex      = index;
+        sobolSeed       = seed;
+        sobolDimension  = 0;
+        hasCachedNormal = false;
+    }
+
+    RAYX_FN_ACC
+    void endQuasiRandom() { sobolDimension = SOBOL_NUM_DIMENSIONS; }
+
+    RAYX_FN_ACC
+    bool isQuasiRandom() const { return sobolDimension < SOBOL_NUM_DIMENSIONS; }
+
     RAYX_FN_ACC
     uint64_t randomInt() { return squares64(counter); }
 
     // TODO: review this function. does the combination of int and uint work as intended?
     RAYX_FN_ACC
     int randomIntInRange(const int min_inclusive, const int max_exclusive) {
+        if (isQuasiRandom()) {
+            const auto offset = static_cast<int>(randomDouble() * (max_exclusive - min_inclusive));
+            return min_inclusive + (offset < max_exclusive - min_inclusive ? offset : max_exclusive - min_inclusive - 1);
+        }
         return min_inclusive + squares64(counter) % (max_exclusive - min_inclusive);
     }
 
     RAYX_FN_ACC
-    double randomDouble() { return squaresDoubleRNG(counter); }
+    double randomDouble() { return isQuasiRandom() ? scrambledSobol(sobolIndex, sobolDimension++, sobolSeed) : squaresDoubleRNG(counter); }
 
     RAYX_FN_ACC
     double randomDoubleInRange(const double min, const double max) { return min + randomDouble() * (max - min); }
 
+    // the Box-Muller transform creates two normal distributed doubles at once. the second one is cached and returned by the next call
     RAYX_FN_ACC
-    double randomDoubleNormalDistributed(double mu, double sigma) { return squaresNormalRNG(counter, mu, sigma); }
+    double randomDoubleNormalDistributed(double mu, double sigma) {
+        if (isQuasiRandom()) {
+            const auto u = randomDouble();
+            const auto v = randomDouble();
+            return boxMuller(u, v, mu, sigma);
+        }
+
+        if (hasCachedNormal) {
+            hasCachedNormal = false;
+            return cachedNormal * sigma + mu;
+        }
+
+        const auto u = squaresDoubleRNG(counter);
+        const auto v = squaresDoubleRNG(counter);
+        double z0;
+        boxMullerPair(u, v, z0, cachedNormal);
+        hasCachedNormal = true;
+        return z0 * sigma + mu;
+    }
+
+    // fills `values` with standard normal distributed doubles. yields the same values as N successive calls to
+    // randomDoubleNormalDistributed(0, 1), but draws the uniform inputs independently of each other, so that the loop vectorizes
+    template <int N>
+    RAYX_FN_ACC void randomDoublesNormalDistributed(double (&values)[N]) {
+        if (isQuasiRandom() || hasCachedNormal) {
+            for (int i = 0; i < N; ++i) { values[i] = randomDoubleNormalDistributed(0, 1); }
+            return;
+        }
+
+        constexpr int numPairs = (N + 1) / 2;
+        double normals[2 * numPairs];
+        for (int i = 0; i < numPairs; ++i) {
+            auto ctr     = counter + static_cast<RandCounter>(2 * i);
+            const auto u = squaresDoubleRNG(ctr);
+            const auto v = squaresDoubleRNG(ctr);
+            boxMullerPair(u, v, normals[2 * i], normals[2 * i + 1]);
+        }
+        counter += static_cast<RandCounter>(2 * numPairs);
+
+        for (int i = 0; i < N; ++i) { values[i] = normals[i]; }
+        if constexpr (N % 2 == 1) {
+            cachedNormal    = normals[N];
+            hasCachedNormal = true;
+        }
+    }
 
     RandCounter counter;
+
+    // second value of the last Box-Muller transform, not yet returned. not stored with rays
+    double cachedNormal  = 0.0;
+    bool hasCachedNormal = false;
+
+    // quasi random state
+    uint32_t sobolIndex = 0;
+    uint32_t sobolSeed  = 0;
+    int sobolDimension  = SOBOL_NUM_DIMENSIONS;
 };
 
 }  // namespace RAYX
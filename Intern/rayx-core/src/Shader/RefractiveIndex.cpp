@@ -146,6 +146,62 @@ complex::Complex RAYX_API getRefractiveIndex(double energy, int material, const
     return complex::Complex(-1.0, -1.0);
 }
 
+RAYX_FN_ACC
+complex::Complex RAYX_API getRefractiveIndex(double energy, int material, const int* __restrict materialIndices,
+                                             const double* __restrict materialTable, const RefractiveIndexTable& __restrict refractiveIndexTable) {
+    const auto& table = refractiveIndexTable;
+
+    if (table.numSamples > 1 && 1 <= material && material <= 92) {
+        const int row = table.rows[material - 1];
+
+        // position of energy on the grid, measured in samples
+        const double x = (glm::log(energy) - table.logEnergyMin) * table.invLogEnergyStep;
+
+        if (row >= 0 && 0.0 <= x && x <= table.numSamples - 1) {
+            const int i  = glm::min(static_cast<int>(x), table.numSamples - 2);
+            const auto t = x - i;
+
+            const auto low  = table.samples[row + i];
+            const auto high = table.samples[row + i + 1];
+            return low + (high - low) * t;
+        }
+    }
+
+    // material or energy not covered by the table
+    return getRefractiveIndex(energy, material, materialIndices, materialTable);
+}
+
+RAYX_FN_ACC
+complex::Complex RAYX_API getRefractiveIndex(double energy, int material, const int* __restrict materialIndices,
+                                             const double* __restrict materialTable, const RefractiveIndexTable& __restrict refractiveIndexTable,
+                                             RefractiveIndexCache& __restrict refractiveIndexCache) {
+    if (material == -1) {  // vacuum, no need to cache
+        return complex::Complex(1., 0.);
+    }
+
+    auto& cache = refractiveIndexCache;
+
+    if (cache.energy != energy) {
+        cache.energy     = energy;
+        cache.numEntries = 0;
+        cache.nextEntry  = 0;
+    }
+
+    for (int i = 0; i < cache.numEntries; ++i) {
+        if (cache.materials[i] == material) return cache.iors[i];
+    }
+
+    const auto ior = getRefractiveIndex(energy, material, materialIndices, materialTable, refractiveIndexTable);
+
+    const int i        = cache.nextEntry;
+    cache.materials[i] = material;
+    cache.iors[i]      = ior;
+    cache.nextEntry    = (i + 1) % RefractiveIndexCache::capacity;
+    cache.numEntries   = glm::min(cache.numEntries + 1, RefractiveIndexCache::capacity);
+
+    return ior;
+}
+
 // returns dvec2(atomic mass, density) extracted from materials.xmacro
 RAYX_FN_ACC
 glm::dvec2 RAYX_API getAtomicMassAndRho(int material) {
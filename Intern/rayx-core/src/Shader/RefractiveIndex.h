@@ -1,7 +1,6 @@
 #pragma once
 
 #include "Complex.h"
-#include "InvocationState.h"
 
 namespace RAYX {
 
@@ -25,6 +24,17 @@ struct NffEntry {
     double m_f2;
 };
 
+/// Refractive indices of the loaded materials, resampled on a uniform grid in log(energy). This allows the refractive index to be looked up in
+/// O(1) with linear interpolation, instead of binary searching the Palik and Nff tables.
+/// The table is built on the host side by `createRefractiveIndexTable` (see Material.h). A table with `numSamples == 0` is disabled.
+struct RefractiveIndexTable {
+    const complex::Complex* __restrict samples;  // numSamples refractive indices per tabulated material
+    const int* __restrict rows;                  // rows[material - 1] is the offset of the material in samples, or -1 if it is not tabulated
+    int numSamples;
+    double logEnergyMin;
+    double invLogEnergyStep;
+};
+
 RAYX_FN_ACC int RAYX_API getPalikEntryCount(int material, const int* materialIndices);
 
 RAYX_FN_ACC int RAYX_API getNffEntryCount(int material, const int* materialIndices);
@@ -36,6 +46,28 @@ RAYX_FN_ACC NffEntry RAYX_API getNffEntry(int index, int material, const int* ma
 // returns dvec2 to represent a complex number
 RAYX_FN_ACC complex::Complex RAYX_API getRefractiveIndex(double energy, int material, const int* materialIndices, const double* materialTable);
 
+/// Caches the refractive indices of a few materials for a single ray. Since the energy of a ray does not change while it propagates through the
+/// beamline, the refractive indices of the substrates and coatings only need to be looked up once per ray.
+/// The cache is keyed by material and invalidated whenever the energy changes. If it is full, the oldest entry is replaced.
+struct RefractiveIndexCache {
+    static constexpr int capacity = 4;
+
+    double energy  = 0.0;
+    int numEntries = 0;
+    int nextEntry  = 0;
+    int materials[capacity];
+    complex::Complex iors[capacity];
+};
+
+// same as above, but looks up the refractive index in the resampled table if the material and energy are covered by it.
+// falls back to the Palik and Nff tables otherwise.
+RAYX_FN_ACC complex::Complex RAYX_API getRefractiveIndex(double energy, int material, const int* materialIndices, const double* materialTable,
+                                                        const RefractiveIndexTable& refractiveIndexTable);
+
+// same as above, but returns the cached refractive index if the material has already been looked up for this energy
+RAYX_FN_ACC complex::Complex RAYX_API getRefractiveIndex(double energy, int material, const int* materialIndices, const double* materialTable,
+                                                        const RefractiveIndexTable& refractiveIndexTable, RefractiveIndexCache& refractiveIndexCache);
+
 // returns dvec2(atomic mass, density) extracted from materials.xmacro
 RAYX_FN_ACC glm::dvec2 RAYX_API getAtomicMassAndRho(int material);
 
@@ -12,7 +12,11 @@ namespace RAYX {
 
 RAYX_FN_ACC
 void traceSequential(const int gid, const ConstState& __restrict constState, MutableState& __restrict mutableState) {
-    auto ray = loadRay(gid, constState.rays);
+    traceSequential(gid, loadRay(gid, constState.rays), constState, mutableState);
+}
+
+RAYX_FN_ACC
+void traceSequential(const int gid, detail::Ray ray, const ConstState& __restrict constState, MutableState& __restrict mutableState) {
     assertObjectIdInBounds(ray.object_id, constState.numSources + constState.numElements);
     // TODO: do we want to increment here? its a design question. in case one traces one beamline and uses events to trace another beamline, the
     // ray_path_id does not overlap, because it was incremented
@@ -24,6 +28,9 @@ void traceSequential(const int gid, const ConstState& __restrict constState, Mut
 
     rayMatrixMult(constState.objectTransforms[ray.object_id].m_inTrans, ray.position, ray.direction, ray.electric_field);
 
+    // refractive indices of substrates and coatings are looked up once per ray
+    auto refractiveIndexCache = RefractiveIndexCache{};
+
     for (int elementIndex = 0; elementIndex < constState.numElements; ++elementIndex) {
         if (isRayTerminated(ray.event_type)) break;
 
@@ -43,7 +50,8 @@ void traceSequential(const int gid, const ConstState& __restrict constState, Mut
         ray.object_id      = constState.numSources + elementIndex;
         ray.event_type     = EventType::HitElement;
 
-        behave(ray, *col, element, constState.materialIndices, constState.materialTable);
+        behave(ray, *col, element, constState.materialIndices, constState.materialTable, constState.refractiveIndexTable, refractiveIndexCache,
+               constState.multilayerTables[elementIndex]);
 
         assertObjectIdInBounds(ray.object_id, constState.numSources + constState.numElements);
         const auto stored = storeRay(getRecordIndex(gid, ray.object_id, constState.outputEventsGridStride), mutableState.storedFlags,
@@ -56,7 +64,11 @@ void traceSequential(const int gid, const ConstState& __restrict constState, Mut
 
 RAYX_FN_ACC
 void traceNonSequential(const int gid, const ConstState& __restrict constState, MutableState& __restrict mutableState) {
-    auto ray = loadRay(gid, constState.rays);
+    traceNonSequential(gid, loadRay(gid, constState.rays), constState, mutableState);
+}
+
+RAYX_FN_ACC
+void traceNonSequential(const int gid, detail::Ray ray, const ConstState& __restrict constState, MutableState& __restrict mutableState) {
     assertObjectIdInBounds(ray.object_id, constState.numSources + constState.numElements);
     // TODO: see above (traceSequential)
     ++ray.path_event_id;
@@ -68,6 +80,9 @@ void traceNonSequential(const int gid, const ConstState& __restrict constState,
     // TODO: object_id from previous beamline is not correct for this beamline
     rayMatrixMult(constState.objectTransforms[ray.object_id].m_inTrans, ray.position, ray.direction, ray.electric_field);
 
+    // refractive indices of substrates and coatings are looked up once per ray
+    auto refractiveIndexCache = RefractiveIndexCache{};
+
     for (int hitIndex = 0; hitIndex < constState.maxEvents; ++hitIndex) {
         if (isRayTerminated(ray.event_type)) break;
 
@@ -88,7 +103,8 @@ void traceNonSequential(const int gid, const ConstState& __restrict constState,
         ray.object_id      = constState.numSources + col->elementIndex;
         ray.event_type     = EventType::HitElement;
 
-        behave(ray, col->point, element, constState.materialIndices, constState.materialTable);
+        behave(ray, col->point, element, constState.materialIndices, constState.materialTable, constState.refractiveIndexTable, refractiveIndexCache,
+               constState.multilayerTables[col->elementIndex]);
 
         // check if the number of events exceed capacity. if so, set event type to TooManyEvents
         if (hitIndex == constState.maxEvents - 1 && !isRayTerminated(ray.event_type)) {
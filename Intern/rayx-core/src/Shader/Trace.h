@@ -2,10 +2,16 @@
 
 #include "Core.h"
 #include "InvocationState.h"
+#include "Ray.h"
 
 namespace RAYX {
 
+// trace the ray `gid` of `constState.rays`
 RAYX_FN_ACC void traceSequential(const int gid, const ConstState& __restrict constState, MutableState& __restrict mutableState);
 RAYX_FN_ACC void traceNonSequential(const int gid, const ConstState& __restrict constState, MutableState& __restrict mutableState);
 
+// trace a given ray, e.g. a ray that was just generated. `gid` determines where its events are recorded
+RAYX_FN_ACC void traceSequential(const int gid, detail::Ray ray, const ConstState& __restrict constState, MutableState& __restrict mutableState);
+RAYX_FN_ACC void traceNonSequential(const int gid, detail::Ray ray, const ConstState& __restrict constState, MutableState& __restrict mutableState);
+
 }  // namespace RAYX
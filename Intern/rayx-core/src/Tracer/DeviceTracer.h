@@ -1,6 +1,9 @@
 #pragma once
 
 #include <cstring>
+#include <functional>
+#include <glm.hpp>
+#include <optional>
 #include <vector>
 
 #include "Core.h"
@@ -10,6 +13,17 @@
 
 namespace RAYX {
 
+/// configures how rays are passed on from one beamline to the next one in chained tracing
+struct RAYX_API ChainConfig {
+    /// element of the first beamline, at which rays leave it. given as index among the elements. defaults to the last element
+    std::optional<int> exitElementIndex;
+    /// transform applied to the rays in the coordinate system of the exit element, before they enter the second beamline
+    glm::dmat4 transform = glm::dmat4(1.0);
+};
+
+/// receives the recorded events of one batch. invoked on the tracing thread, in order of the batches
+using BatchCallback = std::function<void(Rays&&)>;
+
 /**
  * @brief DeviceTracer is an interface to a tracer implementation
  * we need this interface to remove the actual implementation from the rayx api
@@ -18,8 +32,13 @@ class RAYX_API DeviceTracer {
   public:
     virtual ~DeviceTracer() = default;
 
+    /// if onBatch is set, the events of each batch are passed to it instead of being returned
     virtual Rays trace(const Group& beamline, Sequential sequential, const ObjectIndexMask& objectRecordMask, const RayAttrMask attrRecordMask,
-                       const int maxEvents, const int maxBatchSize) = 0;
+                       const int maxEvents, const int maxBatchSize, const BatchCallback& onBatch) = 0;
+
+    virtual Rays traceChained(const Group& first, const Group& second, const ChainConfig& chainConfig, Sequential sequential,
+                              const ObjectIndexMask& objectRecordMask, const RayAttrMask attrRecordMask, const int maxEventsFirst,
+                              const int maxEventsSecond, const int maxBatchSize) = 0;
 };
 
 }  // namespace RAYX
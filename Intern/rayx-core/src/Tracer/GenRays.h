@@ -17,56 +17,94 @@
 #include "Shader/LightSources/SimpleUndulatorSource.h"
 #include "Shader/RaysPtr.h"
 #include "Shader/RecordEvent.h"
+#include "TracerConfig.h"
 #include "Util.h"
+#include "Writer/RayListReader.h"
 
 namespace RAYX {
 namespace {
 
-struct GenRaysKernel {
-    // DipoleSource
-    template <typename Acc>
-    RAYX_FN_ACC void operator()(const Acc& __restrict acc, RaysPtr dstRays, const int startRayIndexBatch, const DipoleSource source,
-                                const int sourceId, const int startRayIndex, const int numRaysTotal, const double seed, const int n) const {
-        const auto gid = alpaka::getIdx<alpaka::Grid, alpaka::Threads>(acc)[0];
-
-        if (gid < n) {
-            const auto rayPathIndex = startRayIndex + gid;
-            auto rand               = Rand(rayPathIndex, numRaysTotal, seed);
-            const auto ray          = source.genRay(rayPathIndex, sourceId, rand);
-            const auto dstIndex     = startRayIndexBatch + gid;
-            storeRay(dstIndex, dstRays, ray);
-        }
+/// random numbers of a source ray. in quasi random mode, the first random numbers are taken from a scrambled Sobol sequence, indexed by the
+/// ray path index, so the result does not depend on how rays are distributed among batches. the ray is stored without the quasi random state,
+/// so tracing continues with pseudo random numbers
+RAYX_FN_ACC inline Rand createRand(const int rayPathIndex, const int numRaysTotal, const double seed, const bool quasiRandom) {
+    auto rand = Rand(rayPathIndex, numRaysTotal, seed);
+    if (quasiRandom) rand.beginQuasiRandom(static_cast<uint32_t>(rayPathIndex), static_cast<uint32_t>(seed * 4294967296.0));
+    return rand;
+}
+
+/// output of GenRaysKernel, that stores the generated rays in a buffer, to be traced by a separate kernel
+struct StoreRays {
+    RaysPtr rays;
+
+    RAYX_FN_ACC void operator()(const int i, const detail::Ray& __restrict ray) const {
+        auto dstRays = rays;
+        storeRay(i, dstRays, ray);
     }
+};
 
-    // RayListSource
-    template <typename Acc>
-    RAYX_FN_ACC void operator()(const Acc& __restrict acc, RaysPtr dstRays, const int startRayIndexBatch, const RayListSource source,
-                                const int sourceId, const int srcStartIndex, const int n) const {
-        const auto gid = alpaka::getIdx<alpaka::Grid, alpaka::Threads>(acc)[0];
+using SourceVariant = std::variant<CircleSource, DipoleSource, MatrixSource, PixelSource, PointSource, SimpleUndulatorSource, RayListSource>;
 
-        if (gid < n) {
-            const auto srcIndex = srcStartIndex + gid;
-            auto ray            = loadRay(srcIndex, source.rays);
-            ray.source_id       = sourceId;
-            ray.object_id       = sourceId;
-            const auto dstIndex = startRayIndexBatch + gid;
-            storeRay(dstIndex, dstRays, ray);
-        }
+/// entry of the source table, that is uploaded to the device once per beamline
+struct SourceTableEntry {
+    SourceVariant source;
+    EnergyDistributionDataVariant energyDistribution;  // unused by DipoleSource and RayListSource
+};
+static_assert(std::is_trivially_copyable_v<SourceTableEntry>);
+
+/// finds the source of a ray in the batch. `batchSourceOffsets` holds the index of the first ray of each source in the batch, followed by the
+/// number of rays in the batch. sources without rays in the batch are skipped
+RAYX_FN_ACC inline int findSourceIndex(const int i, const int* __restrict batchSourceOffsets, const int numSources) {
+    auto lo = 0;
+    auto hi = numSources;
+    while (hi - lo > 1) {
+        const auto mid = (lo + hi) / 2;
+        if (batchSourceOffsets[mid] <= i)
+            lo = mid;
+        else
+            hi = mid;
     }
+    return lo;
+}
 
-    // other sources
-    template <typename Acc, typename Source>
-    RAYX_FN_ACC void operator()(const Acc& __restrict acc, RaysPtr dstRays, const int startRayIndexBatch, const Source source, const int sourceId,
-                                const EnergyDistributionDataVariant energyDistribution, const int startRayIndex, const int numRaysTotal,
-                                const double seed, const int n) const {
+/// generates the rays of all sources of a batch in a single launch. rays of the same source are contiguous in the batch, so threads of a warp
+/// mostly take the same branch
+struct GenRaysKernel {
+    template <typename Acc, typename Output>
+    RAYX_FN_ACC void operator()(const Acc& __restrict acc, const Output output, const SourceTableEntry* __restrict sourceTable,
+                                const int* __restrict batchSourceOffsets, const int numSources, const int startRayIndex, const int numRaysTotal,
+                                const double seed, const bool quasiRandom, const int n) const {
         const auto gid = alpaka::getIdx<alpaka::Grid, alpaka::Threads>(acc)[0];
 
         if (gid < n) {
+            const auto sourceId     = findSourceIndex(gid, batchSourceOffsets, numSources);
+            const auto& entry       = sourceTable[sourceId];
             const auto rayPathIndex = startRayIndex + gid;
-            auto rand               = Rand(rayPathIndex, numRaysTotal, seed);
-            const auto ray          = source.genRay(rayPathIndex, sourceId, energyDistribution, rand);
-            const auto dstIndex     = startRayIndexBatch + gid;
-            storeRay(dstIndex, dstRays, ray);
+
+            auto ray = std::visit(
+                [&]<typename Source>(const Source& source) -> detail::Ray {
+                    // RayListSource
+                    if constexpr (std::is_same_v<Source, RayListSource>) {
+                        const auto srcIndex = gid - batchSourceOffsets[sourceId];
+                        auto rand           = Rand(rayPathIndex, numRaysTotal, seed);
+                        return source.genRay(srcIndex, rayPathIndex, sourceId, rand);
+                    }
+
+                    // DipoleSource
+                    else if constexpr (std::is_same_v<Source, DipoleSource>) {
+                        auto rand = createRand(rayPathIndex, numRaysTotal, seed, quasiRandom);
+                        return source.genRay(rayPathIndex, sourceId, rand);
+                    }
+
+                    // other sources
+                    else {
+                        auto rand = createRand(rayPathIndex, numRaysTotal, seed, quasiRandom);
+                        return source.genRay(rayPathIndex, sourceId, entry.energyDistribution, rand);
+                    }
+                },
+                entry.source);
+
+            output(gid, std::move(ray));
         }
     }
 };
@@ -89,23 +127,47 @@ struct GenRays {
     };
 
     template <typename Queue>
-    SourceConfig update(Queue q, const Group& beamline, const int maxBatchSize) {
+    SourceConfig update(Queue q, const Group& beamline, const int maxBatchSize, const TracerConfig& config) {
         RAYX_PROFILE_FUNCTION_STDOUT();
 
+        m_quasiRandom       = config.sourceSampling == SamplingMode::QuasiRandom;
+        m_interleaveSources = config.adaptiveStopping.enable;
+
         const auto platformHost = alpaka::PlatformCpu{};
         const auto devHost      = alpaka::getDevByIdx(platformHost, 0);
 
         m_startRayIndex = 0;
 
-        auto rayListSourcesIndex = 0;
+        auto dipoleSourcesIndex  = 0;
         const auto compileSource = [&, this](const DesignSource& designSource) -> std::optional<SourceVariant> {
             switch (designSource.getType()) {
                 case ElementType::PointSource:
                     return PointSource(designSource);
                 case ElementType::MatrixSource:
                     return MatrixSource(designSource);
-                case ElementType::DipoleSource:
-                    return DipoleSource(designSource);
+                case ElementType::DipoleSource: {
+                    // replace rejection sampling by inverse cumulative distribution tables
+                    auto source      = DipoleSource(designSource);
+                    const auto index = dipoleSourcesIndex++;
+                    if (static_cast<int>(d_dipoleSamplingTables.size()) <= index) d_dipoleSamplingTables.emplace_back();
+                    auto& d_tables       = d_dipoleSamplingTables[index];
+                    const auto h_tables  = source.createSamplingTables();
+                    const auto numPsis   = static_cast<int>(h_tables.psis.size());
+                    const auto numStokes = static_cast<int>(h_tables.stokes.size());
+                    allocBuf(q, d_tables.energies, h_tables.numQuantiles);
+                    allocBuf(q, d_tables.psis, numPsis);
+                    allocBuf(q, d_tables.stokes, numStokes);
+                    alpaka::memcpy(q, *d_tables.energies, alpaka::createView(devHost, h_tables.energies, h_tables.numQuantiles));
+                    alpaka::memcpy(q, *d_tables.psis, alpaka::createView(devHost, h_tables.psis, numPsis));
+                    alpaka::memcpy(q, *d_tables.stokes, alpaka::createView(devHost, h_tables.stokes, numStokes));
+
+                    auto tables     = h_tables.view();
+                    tables.energies = alpaka::getPtrNative(*d_tables.energies);
+                    tables.psis     = alpaka::getPtrNative(*d_tables.psis);
+                    tables.stokes   = alpaka::getPtrNative(*d_tables.stokes);
+                    source.setSamplingTables(tables);
+                    return source;
+                }
                 case ElementType::PixelSource:
                     return PixelSource(designSource);
                 case ElementType::CircleSource:
@@ -113,16 +175,19 @@ struct GenRays {
                 case ElementType::SimpleUndulatorSource:
                     return SimpleUndulatorSource(designSource);
                 case ElementType::RayListSource: {
-                    const auto index = rayListSourcesIndex++;
-                    if (static_cast<int>(d_rayListSources.size()) <= index) d_rayListSources.emplace_back();
-                    const auto numRaysSource = static_cast<int>(designSource.getNumberOfRays());
-                    allocRaysBuf(q, RayAttrMask::All, d_rayListSources[index], numRaysSource);
-                    const auto& rays = *designSource.getRayList();
-                    assert(rays.attrMask() == RayAttrMask::All && "rays in RayListSource must contain all attributes");
-#define X(type, name, flag) alpaka::memcpy(q, *d_rayListSources[index].name, alpaka::createView(devHost, rays.name, numRaysSource), numRaysSource);
-                    RAYX_X_MACRO_RAY_ATTR
-#undef X
-                    return RayListSource{.rays = raysBufToRaysPtr(d_rayListSources[index])};
+                    // the rays are streamed to the device batch by batch. the device buffer is allocated, once the batch size is known
+                    auto reader            = designSource.createRayListReader();
+                    const auto attrMask    = reader->attrMask();
+                    const auto numRays     = static_cast<int>(designSource.getNumberOfRays());
+                    const auto numRaysList = reader->size();
+                    if (!contains(attrMask, RayListSource::requiredAttrMask))
+                        RAYX_EXIT << "RayListSource \"" << designSource.getName() << "\" must contain the attributes "
+                                  << to_string(RayListSource::requiredAttrMask) << ", but contains only " << to_string(attrMask);
+                    if (numRaysList < numRays)
+                        RAYX_EXIT << "RayListSource \"" << designSource.getName() << "\" should emit " << numRays << " rays, but contains only "
+                                  << numRaysList;
+                    m_rayListReaders.push_back(std::move(reader));
+                    return RayListSource{.rays = {}, .attrMask = attrMask};
                 }
                 default:
                     throw std::runtime_error(std::format("Unimplemented source type ({}) with name: \"{}\"",
@@ -144,39 +209,30 @@ struct GenRays {
                     if constexpr (std::is_same_v<T, SoftEdge>) { return value; }
                     if constexpr (std::is_same_v<T, SeparateEnergies>) { return value; }
                     if constexpr (std::is_same_v<T, DatFile>) {
-                        assert(value.m_Lines.size() > 0);
-                        assert(d_energyDistributionListWeights.size() == d_energyDistributionListEnergies.size());
-
-                        // get the data
-                        std::vector<double> weights;
-                        std::vector<double> energies;
-                        for (const auto entry : value.m_Lines) {
-                            weights.push_back(entry.m_weight);
-                            energies.push_back(entry.m_energy);
-                        }
-                        std::vector<double> prefixWeights(weights.size());
-                        std::inclusive_scan(weights.begin(), weights.end(), prefixWeights.begin());
-                        const auto weightSum = weights.back() + prefixWeights.back();
+                        // alias table for sampling in O(1)
+                        const auto h_list = createEnergyDistributionList(value);
 
                         // alloc device buffers and transfer data
                         const auto index = energyDistributionListIndex++;
-                        const auto size  = static_cast<int>(value.m_Lines.size());
-                        if (static_cast<int>(d_energyDistributionListWeights.size()) <= index) {
-                            d_energyDistributionListWeights.emplace_back();
-                            d_energyDistributionListEnergies.emplace_back();
-                        }
-                        allocBuf(q, d_energyDistributionListWeights[index], size);
-                        allocBuf(q, d_energyDistributionListEnergies[index], size);
-                        alpaka::memcpy(q, *d_energyDistributionListWeights[index], alpaka::createView(devHost, prefixWeights, size));
-                        alpaka::memcpy(q, *d_energyDistributionListEnergies[index], alpaka::createView(devHost, energies, size));
-
-                        return EnergyDistributionList{
-                            .prefixWeights = alpaka::getPtrNative(*d_energyDistributionListWeights[index]),
-                            .energies      = alpaka::getPtrNative(*d_energyDistributionListEnergies[index]),
-                            .weightSum     = weightSum,
-                            .size          = size,
-                            .continous     = value.m_continuous,
-                        };
+                        if (static_cast<int>(d_energyDistributionLists.size()) <= index) d_energyDistributionLists.emplace_back();
+                        auto& d_list          = d_energyDistributionLists[index];
+                        const auto numLines   = static_cast<int>(h_list.energies.size());
+                        const auto numColumns = h_list.size;
+                        allocBuf(q, d_list.probabilities, numColumns);
+                        allocBuf(q, d_list.aliases, numColumns);
+                        allocBuf(q, d_list.energies, numLines);
+                        allocBuf(q, d_list.weights, numLines);
+                        alpaka::memcpy(q, *d_list.probabilities, alpaka::createView(devHost, h_list.probabilities, numColumns));
+                        alpaka::memcpy(q, *d_list.aliases, alpaka::createView(devHost, h_list.aliases, numColumns));
+                        alpaka::memcpy(q, *d_list.energies, alpaka::createView(devHost, h_list.energies, numLines));
+                        alpaka::memcpy(q, *d_list.weights, alpaka::createView(devHost, h_list.weights, numLines));
+
+                        auto list          = h_list.view();
+                        list.probabilities = alpaka::getPtrNative(*d_list.probabilities);
+                        list.aliases       = alpaka::getPtrNative(*d_list.aliases);
+                        list.energies      = alpaka::getPtrNative(*d_list.energies);
+                        list.weights       = alpaka::getPtrNative(*d_list.weights);
+                        return list;
                     }
 
                     RAYX_EXIT << "error: unimplemented energy distribution type";
@@ -185,9 +241,10 @@ struct GenRays {
                 designSource.getEnergyDistribution());
         };
 
-        m_numRaysTotal      = 0;
-        auto numRaysSources = std::vector<int>();
-        auto sourceId       = static_cast<int>(0);
+        m_sourceStates.clear();
+        m_rayListReaders.clear();
+        m_numRaysTotal     = 0;
+        auto h_sourceTable = std::vector<SourceTableEntry>();
 
         for (const auto* designSource : beamline.getSources()) {
             const auto source             = *compileSource(*designSource);
@@ -195,92 +252,146 @@ struct GenRays {
             const auto numRaysSource      = static_cast<int>(designSource->getNumberOfRays());
             m_numRaysTotal += numRaysSource;
 
+            h_sourceTable.push_back(SourceTableEntry{
+                .source             = source,
+                .energyDistribution = energyDistribution.value_or(HardEdge(0.0, 0.0)),
+            });
+
             m_sourceStates.push_back(SourceState{
-                .source                 = source,
-                .sourceId               = sourceId,
-                .energyDistribution     = energyDistribution,
+                .rayListIndex           = std::holds_alternative<RayListSource>(source) ? static_cast<int>(m_rayListReaders.size()) - 1 : -1,
                 .numRaysSource          = numRaysSource,
                 .numRaysSourceRemaining = numRaysSource,
                 .name                   = designSource->getName(),
             });
-
-            ++sourceId;
         }
 
         m_numRaysBatchAtMost = std::min(m_numRaysTotal, maxBatchSize);
+        m_numBatches         = m_numRaysBatchAtMost ? ceilIntDivision(m_numRaysTotal, m_numRaysBatchAtMost) : 0;
+
+        // if sources are interleaved, the share of a source in a batch is rounded, so a batch may exceed the nominal batch size by a few rays
+        if (m_interleaveSources) {
+            m_numRaysBatchAtMost = 0;
+            for (int batchIndex = 0; batchIndex < m_numBatches; ++batchIndex) {
+                auto numRaysBatch = 0;
+                for (const auto& sourceState : m_sourceStates) { numRaysBatch += numRaysBatchOfSource(sourceState, batchIndex); }
+                m_numRaysBatchAtMost = std::max(m_numRaysBatchAtMost, numRaysBatch);
+            }
+        }
+
+        // a RayListSource contributes at most numRaysBatchAtMost rays to a batch, and only these rays are held on the device
+        if (d_rayListSources.size() < m_rayListReaders.size()) d_rayListSources.resize(m_rayListReaders.size());
+        for (size_t i = 0; i < m_sourceStates.size(); ++i) {
+            const auto& sourceState = m_sourceStates[i];
+            if (sourceState.rayListIndex < 0) continue;
+
+            auto& source       = std::get<RayListSource>(h_sourceTable[i].source);
+            auto& d_rayList    = d_rayListSources[sourceState.rayListIndex];
+            const auto numRays = std::min(sourceState.numRaysSource, m_numRaysBatchAtMost);
+            if (numRays) allocRaysBuf(q, source.attrMask, d_rayList, numRays);
+            source.rays = raysBufToRaysPtr(d_rayList);
+        }
+
+        // the source table is uploaded once, while the offsets of the sources in a batch are uploaded per batch
+        const auto numSources = static_cast<int>(h_sourceTable.size());
+        if (numSources) {
+            allocBuf(q, d_sourceTable, numSources);
+            alpaka::memcpy(q, *d_sourceTable, alpaka::createView(devHost, h_sourceTable, numSources), numSources);
+        }
+        allocBuf(q, d_batchSourceOffsets, numSources + 1);
 
+        // if ray generation is fused into tracing, the generated rays are not stored
+        if (!config.fuseRayGeneration) {
 #define X(type, name, flag) allocBuf(q, d_rays.name, m_numRaysBatchAtMost);
 
-        RAYX_X_MACRO_RAY_ATTR
+            RAYX_X_MACRO_RAY_ATTR
 #undef X
-
-        const auto numBatches = m_numRaysBatchAtMost ? ceilIntDivision(m_numRaysTotal, m_numRaysBatchAtMost) : 0;
+        }
 
         m_seed = randomDouble();
 
         return {
             .numRaysTotal       = m_numRaysTotal,
             .numRaysBatchAtMost = m_numRaysBatchAtMost,
-            .numBatches         = numBatches,
+            .numBatches         = m_numBatches,
         };
     }
 
+    /// number of rays generated for a batch
+    int numRaysBatch(const int batchIndex) const {
+        if (m_interleaveSources) {
+            auto numRaysBatch = 0;
+            for (const auto& sourceState : m_sourceStates) { numRaysBatch += numRaysBatchOfSource(sourceState, batchIndex); }
+            return numRaysBatch;
+        }
+
+        const auto batchStartRayIndex    = batchIndex * m_numRaysBatchAtMost;
+        const auto numRaysTotalRemaining = m_numRaysTotal - batchStartRayIndex;
+        return std::min(numRaysTotalRemaining, m_numRaysBatchAtMost);
+    }
+
+    /// generates the rays of a batch into the buffer `d_rays`. batches must be generated in order
     template <typename DevAcc, typename Queue>
     BatchConfig genRaysBatch(DevAcc devAcc, Queue q, const int batchIndex) {
+        const auto numRaysBatch = genRaysBatch(devAcc, q, batchIndex, StoreRays{.rays = raysBufToRaysPtr(d_rays)});
+
+        return BatchConfig{
+            .numRaysBatch = numRaysBatch,
+            .d_rays       = d_rays,
+        };
+    }
+
+    /// generates the rays of a batch and passes each ray with its index in the batch to `output`, which may store the ray or process it right away.
+    /// batches must be generated in order. returns the number of rays of the batch
+    template <typename DevAcc, typename Queue, typename Output>
+    int genRaysBatch(DevAcc devAcc, Queue q, const int batchIndex, const Output output) {
         RAYX_PROFILE_FUNCTION_STDOUT();
 
-        const auto batchStartRayIndex    = batchIndex * m_numRaysBatchAtMost;
-        const auto numRaysTotalRemaining = m_numRaysTotal - batchStartRayIndex;
-        const auto numRaysBatch          = std::min(numRaysTotalRemaining, m_numRaysBatchAtMost);
-        auto numRaysBatchRemaining       = numRaysBatch;
+        const auto numRaysBatch = this->numRaysBatch(batchIndex);
+        const auto numSources   = static_cast<int>(m_sourceStates.size());
+        if (numRaysBatch == 0) return 0;
 
-        for (auto& sourceState : m_sourceStates) {
-            const auto numRaysBatchSource  = std::min(numRaysBatchRemaining, sourceState.numRaysSourceRemaining);
+        const auto platformHost = alpaka::PlatformCpu{};
+        const auto devHost      = alpaka::getDevByIdx(platformHost, 0);
+
+        // index of the first ray of each source in the batch, followed by the number of rays in the batch
+        auto& h_offsets = m_batchSourceOffsets;
+        h_offsets.resize(numSources + 1);
+        auto numRaysBatchRemaining = numRaysBatch;
+        for (int i = 0; i < numSources; ++i) {
+            auto& sourceState              = m_sourceStates[i];
+            const auto numRaysBatchSource  = m_interleaveSources ? numRaysBatchOfSource(sourceState, batchIndex)
+                                                                 : std::min(numRaysBatchRemaining, sourceState.numRaysSourceRemaining);
             const auto startRayIndexSource = sourceState.numRaysSource - sourceState.numRaysSourceRemaining;
+            h_offsets[i]                   = numRaysBatch - numRaysBatchRemaining;
 
-            if (numRaysBatchSource) {
-                const auto startRayIndexBatch = numRaysBatch - numRaysBatchRemaining;
-                numRaysBatchRemaining -= numRaysBatchSource;
-                sourceState.numRaysSourceRemaining -= numRaysBatchSource;
-
-                std::visit(
-                    [&]<typename Source>(const Source& source) {
-                        RAYX_VERB << "execute GenRaysKernel<Source> with Source = '" << sourceState.name << "'";
-
-                        // DipoleSource
-                        if constexpr (std::is_same_v<Source, DipoleSource>) {
-                            execWithValidWorkDiv<Acc>(devAcc, q, numRaysBatchSource, BlockSizeConstraint::None{}, GenRaysKernel{},
-                                                      raysBufToRaysPtr(d_rays), startRayIndexBatch, source, sourceState.sourceId, m_startRayIndex,
-                                                      m_numRaysTotal, m_seed, numRaysBatchSource);
-                        }
-
-                        // RayListSource
-                        else if constexpr (std::is_same_v<Source, RayListSource>) {
-                            execWithValidWorkDiv<Acc>(devAcc, q, numRaysBatchSource, BlockSizeConstraint::None{}, GenRaysKernel{},
-                                                      raysBufToRaysPtr(d_rays), startRayIndexBatch, source, sourceState.sourceId, startRayIndexSource,
-                                                      numRaysBatchSource);
-                        }
-
-                        // other sources
-                        else {
-                            execWithValidWorkDiv<Acc>(devAcc, q, numRaysBatchSource, BlockSizeConstraint::None{}, GenRaysKernel{},
-                                                      raysBufToRaysPtr(d_rays), startRayIndexBatch, source, sourceState.sourceId,
-                                                      *sourceState.energyDistribution, m_startRayIndex, m_numRaysTotal, m_seed, numRaysBatchSource);
-                        }
-                    },
-                    sourceState.source);
-
-                m_startRayIndex += numRaysBatchSource;
-
-                assert(0 <= numRaysBatchRemaining);
-                if (numRaysBatchRemaining == 0) break;
+            // stream the slice of the ray list, that is needed for this batch
+            if (0 <= sourceState.rayListIndex && numRaysBatchSource) {
+                const auto rays = m_rayListReaders[sourceState.rayListIndex]->read(startRayIndexSource, numRaysBatchSource);
+                auto& d_rayList = d_rayListSources[sourceState.rayListIndex];
+#define X(type, name, flag) \
+    if (!rays.name.empty()) alpaka::memcpy(q, *d_rayList.name, alpaka::createView(devHost, rays.name, numRaysBatchSource), numRaysBatchSource);
+
+                RAYX_X_MACRO_RAY_ATTR
+#undef X
             }
+
+            numRaysBatchRemaining -= numRaysBatchSource;
+            sourceState.numRaysSourceRemaining -= numRaysBatchSource;
         }
+        h_offsets[numSources] = numRaysBatch;
+        assert(numRaysBatchRemaining == 0);
 
-        return BatchConfig{
-            .numRaysBatch = numRaysBatch,
-            .d_rays       = d_rays,
-        };
+        const auto numOffsets = static_cast<int>(h_offsets.size());
+        alpaka::memcpy(q, *d_batchSourceOffsets, alpaka::createView(devHost, h_offsets, numOffsets), numOffsets);
+
+        RAYX_VERB << "execute GenRaysKernel for " << numSources << " sources";
+        execWithValidWorkDiv<Acc>(devAcc, q, numRaysBatch, BlockSizeConstraint::None{}, GenRaysKernel{}, output,
+                                  alpaka::getPtrNative(*d_sourceTable), alpaka::getPtrNative(*d_batchSourceOffsets), numSources, m_startRayIndex,
+                                  m_numRaysTotal, m_seed, m_quasiRandom, numRaysBatch);
+
+        m_startRayIndex += numRaysBatch;
+
+        return numRaysBatch;
     }
 
   private:
@@ -288,18 +399,35 @@ struct GenRays {
     /// generated rays
     RaysBuf<Acc> d_rays;
 
+    /// rays of the current batch of each RayListSource
     std::vector<RaysBuf<Acc>> d_rayListSources;
+    std::vector<std::unique_ptr<RayListReader>> m_rayListReaders;
+
+    // buffers for the sampling tables of DipoleSource
+    struct DipoleSamplingTablesBuf {
+        OptBuf<Acc, double> energies;
+        OptBuf<Acc, double> psis;
+        OptBuf<Acc, glm::dvec4> stokes;
+    };
+    std::vector<DipoleSamplingTablesBuf> d_dipoleSamplingTables;
 
     // buffers for EnergyDistributionList (DatFile)
-    std::vector<OptBuf<Acc, double>> d_energyDistributionListWeights;
-    std::vector<OptBuf<Acc, double>> d_energyDistributionListEnergies;
+    struct EnergyDistributionListBuf {
+        OptBuf<Acc, double> probabilities;
+        OptBuf<Acc, int> aliases;
+        OptBuf<Acc, double> energies;
+        OptBuf<Acc, double> weights;
+    };
+    std::vector<EnergyDistributionListBuf> d_energyDistributionLists;
 
-    using SourceVariant = std::variant<CircleSource, DipoleSource, MatrixSource, PixelSource, PointSource, SimpleUndulatorSource, RayListSource>;
+    /// sources of the beamline and their energy distributions
+    OptBuf<Acc, SourceTableEntry> d_sourceTable;
+    /// offsets of the sources in the current batch. see `GenRaysKernel`
+    OptBuf<Acc, int> d_batchSourceOffsets;
+    std::vector<int> m_batchSourceOffsets;
 
     struct SourceState {
-        const SourceVariant source;
-        const int sourceId;
-        const std::optional<EnergyDistributionDataVariant> energyDistribution;
+        int rayListIndex;  // index into m_rayListReaders and d_rayListSources, or -1 if the source is not a RayListSource
         int numRaysSource;
         int numRaysSourceRemaining;
         std::string name;
@@ -309,7 +437,18 @@ struct GenRays {
     int m_startRayIndex;
     int m_numRaysTotal;
     int m_numRaysBatchAtMost;
+    int m_numBatches;
     double m_seed;
+    bool m_quasiRandom;
+    bool m_interleaveSources;
+
+    /// number of rays a source contributes to a batch, if sources are interleaved. Every source is spread evenly over all batches, so that each
+    /// batch is a representative sample of all sources, and tracing may stop after any batch without biasing the result
+    int numRaysBatchOfSource(const SourceState& sourceState, const int batchIndex) const {
+        const auto startRayIndexSource = static_cast<int64_t>(batchIndex) * sourceState.numRaysSource / m_numBatches;
+        const auto endRayIndexSource   = static_cast<int64_t>(batchIndex + 1) * sourceState.numRaysSource / m_numBatches;
+        return static_cast<int>(endRayIndexSource - startRayIndexSource);
+    }
 };
 
 }  // namespace RAYX
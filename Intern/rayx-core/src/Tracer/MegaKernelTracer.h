@@ -1,7 +1,14 @@
 #pragma once
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <limits>
 #include <numeric>
+#include <optional>
 #include <set>
+#include <utility>
 
 #include "Beamline/Beamline.h"
 #include "Debug/Instrumentor.h"
@@ -10,6 +17,8 @@
 #include "Material/Material.h"
 #include "Random.h"
 #include "Shader/Trace.h"
+#include "Shader/Utils.h"
+#include "TracerConfig.h"
 #include "Util.h"
 
 namespace RAYX {
@@ -36,6 +45,21 @@ struct TraceNonSequentialKernel {
     }
 };
 
+/// output of GenRaysKernel, that traces each generated ray right away (fused ray generation)
+struct TraceRays {
+    ConstState constState;
+    MutableState mutableState;
+
+    RAYX_FN_ACC void operator()(const int gid, detail::Ray ray) const {
+        // drop the state of Rand that is not stored with rays, as storing and loading the ray would. so fused and unfused tracing agree
+        ray.rand = Rand(ray.rand.counter);
+
+        auto state = mutableState;
+        if (constState.sequential == Sequential::Yes) traceSequential(gid, std::move(ray), constState, state);
+        else traceNonSequential(gid, std::move(ray), constState, state);
+    }
+};
+
 struct ScatterCompactKernel {
     template <typename Acc, typename T>
     RAYX_FN_ACC void operator()(const Acc& __restrict acc, T* __restrict dst, const T* __restrict src, const int* __restrict prefix,
@@ -49,6 +73,104 @@ struct ScatterCompactKernel {
     }
 };
 
+/// finds the last event of each ray on the exit element of the first of two chained beamlines. Only events on the exit element are recorded.
+/// rays that never reached the exit element or were absorbed by it are not passed on, which is marked by -1
+struct FindExitEventsKernel {
+    template <typename Acc>
+    RAYX_FN_ACC void operator()(const Acc& __restrict acc, int* __restrict exitRecordIndices, const RaysPtr events,
+                                const bool* __restrict storedFlags, const int maxEvents, const int gridStride, const int n) const {
+        const auto gid = alpaka::getIdx<alpaka::Grid, alpaka::Threads>(acc)[0];
+
+        if (gid < n) {
+            auto exitRecordIndex = -1;
+            for (int recordIndex = maxEvents - 1; 0 <= recordIndex; --recordIndex) {
+                const auto i = getRecordIndex(gid, recordIndex, gridStride);
+                if (!storedFlags[i]) continue;
+                if (events.event_type[i] == EventType::HitElement) exitRecordIndex = recordIndex;
+                break;
+            }
+            exitRecordIndices[gid] = exitRecordIndex;
+        }
+    }
+};
+
+/// emits the rays found by FindExitEventsKernel from the source of the second beamline. the rays are compacted and transformed
+struct ChainRaysKernel {
+    template <typename Acc>
+    RAYX_FN_ACC void operator()(const Acc& __restrict acc, const RaysPtr dstRays, const RaysPtr events, const int* __restrict exitRecordIndices,
+                                const int* __restrict prefixSum, const glm::dmat4 transform, const int sourceId, const int gridStride,
+                                const int n) const {
+        const auto gid = alpaka::getIdx<alpaka::Grid, alpaka::Threads>(acc)[0];
+
+        if (gid < n && 0 <= exitRecordIndices[gid]) {
+            auto ray = loadRay(getRecordIndex(gid, exitRecordIndices[gid], gridStride), events);
+            rayMatrixMult(transform, ray.position, ray.direction, ray.electric_field);
+            ray.object_id = sourceId;
+            ray.source_id = sourceId;
+
+            auto dst = dstRays;
+            storeRay(prefixSum[gid], dst, ray);
+        }
+    }
+};
+
+struct MultilayerTableKernel {
+    template <typename Acc>
+    RAYX_FN_ACC void operator()(const Acc& __restrict acc, ComplexFresnelCoeffs* __restrict samples, const MultilayerTable table,
+                                const OpticalElement* __restrict elements, const int elementIndex, const int* __restrict materialIndices,
+                                const double* __restrict materialTable, const RefractiveIndexTable refractiveIndexTable, const int n) const {
+        const auto gid = alpaka::getIdx<alpaka::Grid, alpaka::Threads>(acc)[0];
+
+        if (gid < n) {
+            const auto energy   = table.energyMin + (gid / table.numAngles) / table.invEnergyStep;
+            const auto angle    = table.angleMin + (gid % table.numAngles) / table.invAngleStep;
+            const auto& element = elements[elementIndex];
+
+            auto refractiveIndexCache = RefractiveIndexCache{};
+            samples[gid] = calcMultilayerReflectance(energy, angle, element.m_coating.get<Coating::MultilayerCoating>(), element.m_material,
+                                                     materialIndices, materialTable, refractiveIndexTable, refractiveIndexCache);
+        }
+    }
+};
+
+struct MultilayerTableDeviationKernel {
+    template <typename Acc>
+    RAYX_FN_ACC void operator()(const Acc& __restrict acc, double* __restrict deviations, const MultilayerTable table,
+                                const OpticalElement* __restrict elements, const int elementIndex, const int* __restrict materialIndices,
+                                const double* __restrict materialTable, const RefractiveIndexTable refractiveIndexTable, const int n) const {
+        const auto gid = alpaka::getIdx<alpaka::Grid, alpaka::Threads>(acc)[0];
+
+        if (gid < n) {
+            const auto& element = elements[elementIndex];
+            deviations[gid] = calcMultilayerTableCellDeviation(gid, table, element.m_coating.get<Coating::MultilayerCoating>(), element.m_material,
+                                                               materialIndices, materialTable, refractiveIndexTable);
+        }
+    }
+};
+
+/// counts the events recorded on each element. The number of events on an element per traced ray estimates the transmission to this element
+inline void countEventsOnElements(std::vector<int64_t>& numEventsElements, const int32_t* objectIds, const int numEvents, const int numSources) {
+    for (int i = 0; i < numEvents; ++i) {
+        const auto elementIndex = objectIds[i] - numSources;
+        if (0 <= elementIndex && elementIndex < static_cast<int>(numEventsElements.size())) ++numEventsElements[elementIndex];
+    }
+}
+
+/// relative standard error of the least precise transmission estimate of the recorded elements, assuming binomial statistics. The transmission
+/// to a recorded element without events is not estimated yet, thus its error is infinite
+inline double calcMaxRelativeTransmissionError(const std::vector<int64_t>& numEventsElements, const ObjectIndexMask& objectRecordMask,
+                                               const int64_t numRaysTraced) {
+    auto maxRelativeError = 0.0;
+    for (int i = 0; i < static_cast<int>(numEventsElements.size()); ++i) {
+        if (!objectRecordMask.shouldRecordElement(i)) continue;
+        const auto numEvents = numEventsElements[i];
+        if (numEvents == 0) return std::numeric_limits<double>::infinity();
+        const auto transmission = static_cast<double>(numEvents) / static_cast<double>(numRaysTraced);
+        maxRelativeError        = std::max(maxRelativeError, std::sqrt(std::max(0.0, 1.0 - transmission) / static_cast<double>(numEvents)));
+    }
+    return maxRelativeError;
+}
+
 }  // unnamed namespace
 
 /// keeps track of all resources used by the tracer. manages allocation and update of buffers
@@ -62,6 +184,9 @@ struct Resources {
     /// material data
     OptBuf<Acc, int> d_materialIndices;
     OptBuf<Acc, double> d_materialTable;
+    /// material data resampled on a uniform grid in log(energy). only allocated if enabled in the tracer config
+    OptBuf<Acc, complex::Complex> d_refractiveIndexSamples;
+    OptBuf<Acc, int> d_refractiveIndexRows;
 
     // resources per beamline. constant per beamline
     /// beamline object transforms
@@ -73,10 +198,16 @@ struct Resources {
     /// mask for which elements to record events
     OptBuf<Acc, bool> d_objectRecordMask;
 
+    /// reflectance tables of multilayer coatings, one per element. samples are only allocated if enabled in the tracer config
+    OptBuf<Acc, MultilayerTable> d_multilayerTables;
+    OptBuf<Acc, ComplexFresnelCoeffs> d_multilayerTableSamples;
+    OptBuf<Acc, double> d_multilayerTableDeviations;  // deviation in the center of every cell of a table, to check its accuracy
+
     // output events per tracing. required if 'events' is enabled in output config
     /// output events from tracer kernel
     RaysBuf<Acc> d_eventsBatch;
-    /// output events, compacted for faster transfer
+    /// output events, compacted for faster transfer. not used if the accelerator runs on the host, since events are compacted into the host
+    /// output directly
     RaysBuf<Acc> d_compactEventsBatch;
     /// flag for each possible ouput event, wether it was stored or not. used for compaction
     OptBuf<Acc, bool> d_eventStoreFlags;
@@ -86,12 +217,13 @@ struct Resources {
     struct BeamlineConfig {
         int numSources;
         int numElements;
+        RefractiveIndexTable refractiveIndexTable;
     };
 
     /// update resources
     template <typename Queue>
     BeamlineConfig update(Queue q, const Group& group, int maxEvents, int numRaysBatchAtMost, const ObjectIndexMask& objectRecordMask,
-                          const RayAttrMask attrRecordMask) {
+                          const RayAttrMask attrRecordMask, const TracerConfig& config) {
         RAYX_PROFILE_FUNCTION_STDOUT();
 
         const auto platformHost = alpaka::PlatformCpu{};
@@ -108,6 +240,9 @@ struct Resources {
         alpaka::memcpy(q, *d_materialIndices, alpaka::createView(devHost, materialIndices, numMaterialIndices));
         alpaka::memcpy(q, *d_materialTable, alpaka::createView(devHost, materialTable, materialTableSize));
 
+        // material data resampled on a uniform grid in log(energy)
+        const auto refractiveIndexTable = updateRefractiveIndexTable(q, devHost, materialTables, config.refractiveIndexTable);
+
         // beamline elements
         // TODO: this should be two arrays, one of elements, one for transforms
         const auto elementsAndTransforms = group.compileElements();
@@ -118,6 +253,9 @@ struct Resources {
         allocBuf(q, d_elements, numElements);
         alpaka::memcpy(q, *d_elements, alpaka::createView(devHost, elements, numElements));
 
+        // reflectance tables of multilayer coatings
+        updateMultilayerTables(q, devHost, group, elements, refractiveIndexTable, config.multilayerTable);
+
         const auto sources    = group.getSources();
         const auto numSources = static_cast<int>(sources.size());
         const auto numObjects = numSources + numElements;
@@ -148,15 +286,227 @@ struct Resources {
 
         // output events and compacted output events
         allocRaysBuf(q, attrRecordMask, d_eventsBatch, numEventsBatchAtMostAccountForGridStride);
-        allocRaysBuf(q, attrRecordMask, d_compactEventsBatch, numEventsBatchAtMost);
+        if constexpr (!isAccOnHost<Acc>) allocRaysBuf(q, attrRecordMask, d_compactEventsBatch, numEventsBatchAtMost);
 
         // event storage flags, used for compaction of events
         allocBuf(q, d_eventStoreFlags, numEventsBatchAtMostAccountForGridStride);
         allocBuf(q, d_eventStoreFlagsPrefixSum, numEventsBatchAtMostAccountForGridStride);
 
         return {
-            .numSources  = numSources,
-            .numElements = numElements,
+            .numSources           = numSources,
+            .numElements          = numElements,
+            .refractiveIndexTable = refractiveIndexTable,
+        };
+    }
+
+  private:
+    template <typename Queue, typename DevHost>
+    RefractiveIndexTable updateRefractiveIndexTable(Queue q, DevHost devHost, const MaterialTables& materialTables,
+                                                    const RefractiveIndexTableConfig& config) {
+        const auto disabled = RefractiveIndexTable{
+            .samples          = nullptr,
+            .rows             = nullptr,
+            .numSamples       = 0,
+            .logEnergyMin     = 0.0,
+            .invLogEnergyStep = 0.0,
+        };
+
+        if (!config.enable) return disabled;
+
+        const auto h_table = createRefractiveIndexTable(materialTables, config);
+        if (h_table.numSamples == 0) return disabled;
+
+        const auto deviation = calcRefractiveIndexTableDeviation(materialTables, h_table);
+        RAYX_VERB << "resampled material tables with " << h_table.numSamples << " samples per material. max relative deviation: " << deviation;
+        if (deviation > config.tolerance)
+            RAYX_WARN << "the resampled material tables deviate from the original tables by up to " << deviation
+                      << ", which exceeds the tolerance of " << config.tolerance << ". consider increasing the number of samples";
+
+        const auto numSamplesTotal = static_cast<int>(h_table.samples.size());
+        const auto numRows         = static_cast<int>(h_table.rows.size());
+        allocBuf(q, d_refractiveIndexSamples, numSamplesTotal);
+        allocBuf(q, d_refractiveIndexRows, numRows);
+        alpaka::memcpy(q, *d_refractiveIndexSamples, alpaka::createView(devHost, h_table.samples, numSamplesTotal), numSamplesTotal);
+        alpaka::memcpy(q, *d_refractiveIndexRows, alpaka::createView(devHost, h_table.rows, numRows), numRows);
+
+        return RefractiveIndexTable{
+            .samples          = alpaka::getPtrNative(*d_refractiveIndexSamples),
+            .rows             = alpaka::getPtrNative(*d_refractiveIndexRows),
+            .numSamples       = h_table.numSamples,
+            .logEnergyMin     = h_table.logEnergyMin,
+            .invLogEnergyStep = h_table.invLogEnergyStep,
+        };
+    }
+
+    template <typename Queue, typename DevHost>
+    void updateMultilayerTables(Queue q, DevHost devHost, const Group& group, const std::vector<OpticalElement>& elements,
+                                const RefractiveIndexTable& refractiveIndexTable, const MultilayerTableConfig& config) {
+        const auto numElements = static_cast<int>(elements.size());
+        const auto disabled    = MultilayerTable{
+            .samples       = nullptr,
+            .numEnergies   = 0,
+            .numAngles     = 0,
+            .energyMin     = 0.0,
+            .invEnergyStep = 0.0,
+            .angleMin      = 0.0,
+            .invAngleStep  = 0.0,
+        };
+        auto h_tables = std::vector<MultilayerTable>(numElements, disabled);
+
+        // only mirrors evaluate their multilayer coating
+        auto multilayerElementIndices = std::vector<int>();
+        for (int i = 0; i < numElements; ++i) {
+            if (elements[i].m_behaviour.is<Behaviour::Mirror>() && elements[i].m_coating.is<Coating::MultilayerCoating>())
+                multilayerElementIndices.push_back(i);
+        }
+
+        const auto energyRange = group.calcEnergyRange();
+        const auto energyMin   = config.energyMin ? config.energyMin : (energyRange ? std::optional(energyRange->x) : std::nullopt);
+        const auto energyMax   = config.energyMax ? config.energyMax : (energyRange ? std::optional(energyRange->y) : std::nullopt);
+
+        if (config.enable && !multilayerElementIndices.empty()) {
+            if (!energyMin || !energyMax) {
+                RAYX_WARN << "could not determine the energy range of the sources. multilayer tables are disabled. specify the energy range in the "
+                             "tracer config to enable them";
+            } else {
+                buildMultilayerTables(q, devHost, multilayerElementIndices, elements, refractiveIndexTable, config, *energyMin, *energyMax,
+                                      h_tables);
+            }
+        }
+
+        allocBuf(q, d_multilayerTables, numElements);
+        alpaka::memcpy(q, *d_multilayerTables, alpaka::createView(devHost, h_tables, numElements), numElements);
+    }
+
+    template <typename Queue, typename DevHost>
+    void buildMultilayerTables(Queue q, DevHost devHost, const std::vector<int>& multilayerElementIndices,
+                               const std::vector<OpticalElement>& elements, const RefractiveIndexTable& refractiveIndexTable,
+                               const MultilayerTableConfig& config, double energyMin, double energyMax, std::vector<MultilayerTable>& h_tables) {
+        if (config.numEnergies < 2 || config.numAngles < 2) RAYX_EXIT << "multilayer tables require at least 2 energies and 2 angles";
+        if (energyMax < energyMin || config.angleMax <= config.angleMin) RAYX_EXIT << "invalid range for multilayer tables";
+
+        // monochromatic sources. widen the range slightly to obtain a valid grid
+        if (energyMax == energyMin) {
+            energyMin *= 1.0 - 1e-6;
+            energyMax *= 1.0 + 1e-6;
+        }
+
+        const auto devAcc    = alpaka::getDev(q);
+        const auto numTables = static_cast<int>(multilayerElementIndices.size());
+        auto numEnergies     = config.numEnergies;
+        auto numAngles       = config.numAngles;
+        auto deviation       = 0.0;
+
+        for (int refinement = 0;; ++refinement) {
+            const auto numSamplesTable = numEnergies * numAngles;
+            const auto numSamplesTotal = numSamplesTable * numTables;
+            allocBuf(q, d_multilayerTableSamples, numSamplesTotal);
+            auto* samples = alpaka::getPtrNative(*d_multilayerTableSamples);
+
+            for (int t = 0; t < numTables; ++t) {
+                const auto elementIndex = multilayerElementIndices[t];
+                h_tables[elementIndex] = MultilayerTable{
+                    .samples       = samples + t * numSamplesTable,
+                    .numEnergies   = numEnergies,
+                    .numAngles     = numAngles,
+                    .energyMin     = energyMin,
+                    .invEnergyStep = (numEnergies - 1) / (energyMax - energyMin),
+                    .angleMin      = config.angleMin,
+                    .invAngleStep  = (numAngles - 1) / (config.angleMax - config.angleMin),
+                };
+
+                RAYX_VERB << "execute MultilayerTableKernel for element " << elementIndex;
+                execWithValidWorkDiv<Acc>(devAcc, q, numSamplesTable, BlockSizeConstraint::None{}, MultilayerTableKernel{},
+                                          samples + t * numSamplesTable, h_tables[elementIndex], alpaka::getPtrNative(*d_elements), elementIndex,
+                                          alpaka::getPtrNative(*d_materialIndices), alpaka::getPtrNative(*d_materialTable), refractiveIndexTable,
+                                          numSamplesTable);
+            }
+
+            // check the accuracy in the center of every cell, so that narrow peaks between the grid points are not missed
+            const auto numCellsTable = (numEnergies - 1) * (numAngles - 1);
+            allocBuf(q, d_multilayerTableDeviations, numCellsTable);
+            auto h_deviations = std::vector<double>(numCellsTable);
+
+            deviation = 0.0;
+            for (int t = 0; t < numTables; ++t) {
+                const auto elementIndex = multilayerElementIndices[t];
+
+                RAYX_VERB << "execute MultilayerTableDeviationKernel for element " << elementIndex;
+                execWithValidWorkDiv<Acc>(devAcc, q, numCellsTable, BlockSizeConstraint::None{}, MultilayerTableDeviationKernel{},
+                                          alpaka::getPtrNative(*d_multilayerTableDeviations), h_tables[elementIndex],
+                                          alpaka::getPtrNative(*d_elements), elementIndex, alpaka::getPtrNative(*d_materialIndices),
+                                          alpaka::getPtrNative(*d_materialTable), refractiveIndexTable, numCellsTable);
+                alpaka::memcpy(q, alpaka::createView(devHost, h_deviations, numCellsTable), *d_multilayerTableDeviations, numCellsTable);
+                deviation = std::max(deviation, *std::max_element(h_deviations.begin(), h_deviations.end()));
+            }
+
+            RAYX_VERB << "built " << numTables << " multilayer table(s) with " << numEnergies << " energies x " << numAngles
+                      << " angles. max absolute deviation: " << deviation;
+
+            if (deviation <= config.tolerance || refinement == config.maxRefinements) break;
+
+            // double the resolution, keeping the previous grid points
+            numEnergies = 2 * numEnergies - 1;
+            numAngles   = 2 * numAngles - 1;
+        }
+
+        if (deviation > config.tolerance)
+            RAYX_WARN << "the multilayer tables deviate from the exact reflectance by up to " << deviation << ", which exceeds the tolerance of "
+                      << config.tolerance << ". consider narrowing the energy or angle range, or increasing the number of samples";
+    }
+};
+
+/// resources of the first beamline in chained tracing, and of the rays passed on from it to the second beamline
+template <typename Acc>
+struct ChainResources {
+    /// resources of the first beamline. only events on the exit element are recorded
+    Resources<Acc> first;
+
+    /// record index of the exit event of each ray of the batch, or -1 if the ray is not passed on
+    OptBuf<Acc, int> d_exitRecordIndices;
+    OptBuf<Acc, int> d_exitRecordIndicesPrefixSum;
+    /// host copies, used for the prefix sum. empty if the accelerator runs on the host
+    std::vector<int> h_exitRecordIndices;
+    std::vector<int> h_exitRecordIndicesPrefixSum;
+
+    /// rays emitted by the source of the second beamline
+    RaysBuf<Acc> d_rays;
+
+    /// holds configuration state of chained tracing
+    struct ChainState {
+        typename Resources<Acc>::BeamlineConfig beamlineConf;  // of the first beamline
+        int maxEvents;                                         // of the first beamline
+        glm::dmat4 transform;
+    };
+
+    template <typename Queue>
+    ChainState update(Queue q, const Group& firstGroup, const Group& secondGroup, const ChainConfig& chainConfig, const int maxEvents,
+                      const int numRaysBatchAtMost, const TracerConfig& config) {
+        RAYX_PROFILE_FUNCTION_STDOUT();
+
+        // rays enter the second beamline through its only source
+        const auto secondSources = secondGroup.getSources();
+        if (secondSources.size() != 1 || secondSources[0]->getType() != ElementType::RayListSource)
+            RAYX_EXIT << "chained tracing requires the second beamline to contain exactly one source, which must be a RayListSource";
+
+        const auto numSources       = static_cast<int>(firstGroup.numSources());
+        const auto numElements      = static_cast<int>(firstGroup.numElements());
+        const auto exitElementIndex = chainConfig.exitElementIndex.value_or(numElements - 1);
+        if (exitElementIndex < 0 || numElements <= exitElementIndex)
+            RAYX_EXIT << "exit element index " << exitElementIndex << " is out of bounds [0, " << numElements << ") of the first beamline";
+
+        // only events on the exit element are recorded, but with all attributes, since they are needed to continue the rays
+        const auto exitRecordMask = ObjectIndexMask::byIndices(numSources, numElements, {numSources + exitElementIndex});
+        const auto beamlineConf   = first.update(q, firstGroup, maxEvents, numRaysBatchAtMost, exitRecordMask, RayAttrMask::All, config);
+
+        allocBuf(q, d_exitRecordIndices, numRaysBatchAtMost);
+        allocBuf(q, d_exitRecordIndicesPrefixSum, numRaysBatchAtMost);
+        allocRaysBuf(q, RayAttrMask::All, d_rays, numRaysBatchAtMost);
+
+        return {
+            .beamlineConf = beamlineConf,
+            .maxEvents    = maxEvents,
+            .transform    = chainConfig.transform,
         };
     }
 };
@@ -180,11 +530,15 @@ struct Resources {
  * 3. Compact recorded events to optimize memory transfers.
  * 4. Transfer compacted recorded events back to the host.
  * 5. Aggregate results from all batches into a final Rays object for output.
+ *
+ * If the accelerator runs on the host (CPU backends), steps 3 to 5 are fused: the compaction
+ * kernel scatters recorded events directly into the final Rays object at the offset of the
+ * current batch, avoiding the transfer and aggregation copies.
  */
 template <typename AccTag>
 class MegaKernelTracer : public DeviceTracer {
   public:
-    explicit MegaKernelTracer(int deviceIndex) : m_deviceIndex(deviceIndex) {}
+    MegaKernelTracer(int deviceIndex, const TracerConfig& config) : m_deviceIndex(deviceIndex), m_config(config) {}
     MegaKernelTracer(const MegaKernelTracer&)            = delete;
     MegaKernelTracer(MegaKernelTracer&&)                 = default;
     MegaKernelTracer& operator=(const MegaKernelTracer&) = delete;
@@ -196,18 +550,40 @@ class MegaKernelTracer : public DeviceTracer {
     using Acc = alpaka::TagToAcc<AccTag, Dim, Idx>;
 
     const int m_deviceIndex;
+    const TracerConfig m_config;
     Resources<Acc> m_resources;
 
     using GenRaysAcc = GenRays<Acc>;
     GenRaysAcc m_genRaysResources;
 
+    ChainResources<Acc> m_chainResources;
+
   public:
     virtual Rays trace(const Group& beamline, Sequential sequential, const ObjectIndexMask& objectRecordMask, const RayAttrMask attrRecordMask,
-                       const int maxEventsElements, const int maxBatchSize) override {
+                       const int maxEventsElements, const int maxBatchSize, const BatchCallback& onBatch) override {
+        return traceBatches(nullptr, beamline, ChainConfig(), sequential, objectRecordMask, attrRecordMask, 0, maxEventsElements, maxBatchSize,
+                            onBatch);
+    }
+
+    virtual Rays traceChained(const Group& first, const Group& second, const ChainConfig& chainConfig, Sequential sequential,
+                              const ObjectIndexMask& objectRecordMask, const RayAttrMask attrRecordMask, const int maxEventsFirst,
+                              const int maxEventsSecond, const int maxBatchSize) override {
+        return traceBatches(&first, second, chainConfig, sequential, objectRecordMask, attrRecordMask, maxEventsFirst, maxEventsSecond,
+                            maxBatchSize, BatchCallback());
+    }
+
+  private:
+    /// traces all batches through beamline. in chained tracing, the rays are generated by the sources of first and traced through first, before
+    /// they are traced through beamline. otherwise first is nullptr and the rays are generated by the sources of beamline.
+    /// if onBatch is set, the events are passed to it batch by batch and the returned Rays are empty
+    Rays traceBatches(const Group* first, const Group& beamline, const ChainConfig& chainConfig, Sequential sequential,
+                      const ObjectIndexMask& objectRecordMask, const RayAttrMask attrRecordMask, const int maxEventsElementsFirst,
+                      const int maxEventsElements, const int maxBatchSize, const BatchCallback& onBatch) {
         RAYX_PROFILE_FUNCTION_STDOUT();
 
         const auto maxEventsSources = 1;
         const auto maxEvents        = maxEventsSources + maxEventsElements;
+        const auto maxEventsFirst   = maxEventsSources + maxEventsElementsFirst;  // only used in chained tracing
 
         const auto platformHost = alpaka::PlatformCpu{};
         const auto devHost      = alpaka::getDevByIdx(platformHost, 0);
@@ -216,20 +592,40 @@ class MegaKernelTracer : public DeviceTracer {
         using Queue             = alpaka::Queue<Acc, alpaka::Blocking>;
         auto q                  = Queue(devAcc);
 
-        const auto sourceConf   = m_genRaysResources.update(q, beamline, maxBatchSize);
-        const auto beamlineConf = m_resources.update(q, beamline, maxEvents, sourceConf.numRaysBatchAtMost, objectRecordMask, attrRecordMask);
+        // the transmission to the elements is estimated from the recorded events, thus object ids need to be traced for adaptive stopping
+        const auto& adaptiveStopping = m_config.adaptiveStopping;
+        const auto trackTransmission = adaptiveStopping.enable && adaptiveStopping.maxRelativeError.has_value();
+        const auto attrTraceMask     = trackTransmission ? attrRecordMask | RayAttrMask::ObjectId : attrRecordMask;
+        const auto startTime         = std::chrono::steady_clock::now();
+
+        const auto sourceConf   = m_genRaysResources.update(q, first ? *first : beamline, maxBatchSize, m_config);
+        const auto beamlineConf =
+            m_resources.update(q, beamline, maxEvents, sourceConf.numRaysBatchAtMost, objectRecordMask, attrTraceMask, m_config);
+        const auto chainState   = first ? std::make_optional(m_chainResources.update(q, *first, beamline, chainConfig, maxEventsFirst,
+                                                                                       sourceConf.numRaysBatchAtMost, m_config))
+                                        : std::nullopt;
 
         RAYX_VERB << "trace beamline:";
         RAYX_VERB << "\t- num sources: " << beamlineConf.numSources;
         RAYX_VERB << "\t- num elements: " << beamlineConf.numElements;
         RAYX_VERB << "\t- sequential: " << (sequential == Sequential::Yes ? "yes" : "no");
         RAYX_VERB << "\t- max events on elements: " << maxEventsElements;
+        if (chainState) {
+            RAYX_VERB << "\t- chained after beamline with " << chainState->beamlineConf.numSources << " sources and "
+                      << chainState->beamlineConf.numElements << " elements";
+            RAYX_VERB << "\t- max events on elements of first beamline: " << maxEventsElementsFirst;
+        }
         RAYX_VERB << "\t- num rays: " << sourceConf.numRaysTotal;
         RAYX_VERB << "\t- max batch size: " << maxBatchSize;
         RAYX_VERB << "\t- batch size: " << sourceConf.numRaysBatchAtMost;
         RAYX_VERB << "\t- num batches: " << sourceConf.numBatches;
         // TODO: print object mask
         RAYX_VERB << "\t- using ray attribute mask: " << to_string(attrRecordMask);
+        if (adaptiveStopping.enable) {
+            RAYX_VERB << "\t- adaptive stopping: min batches = " << adaptiveStopping.minBatches
+                      << ", max relative error = " << adaptiveStopping.maxRelativeError.value_or(0.0)
+                      << ", max duration = " << adaptiveStopping.maxDuration.value_or(0.0) << " s";
+        }
         RAYX_VERB << "\t- backend tag: " << AccTag{}.get_name();
         RAYX_VERB << "\t- device index: " << m_deviceIndex;
         RAYX_VERB << "\t- device name: " << alpaka::getName(devAcc);
@@ -237,18 +633,20 @@ class MegaKernelTracer : public DeviceTracer {
 
         const auto numRaysBatchAtMostAccountForGridStride   = nextMultiple(sourceConf.numRaysBatchAtMost, GRID_STRIDE_MULTIPLE);
         const auto numEventsBatchAtMostAccountForGridStride = numRaysBatchAtMostAccountForGridStride * maxEvents;
-        auto h_compactEventsBatches                         = std::vector<Rays>(sourceConf.numBatches);
-        auto h_eventStoreFlags                              = std::make_unique<bool[]>(numEventsBatchAtMostAccountForGridStride);
-        auto h_eventStoreFlagsPrefixSum                     = std::vector<int>(numEventsBatchAtMostAccountForGridStride);
+        auto h_compactEventsBatches                         = std::vector<Rays>(isAccOnHost<Acc> ? 0 : sourceConf.numBatches);
+        auto h_events                                       = Rays{};  // only used if accelerator runs on host
+        const auto numEventStoreFlagsOnHost                 = isAccOnHost<Acc> ? 0 : numEventsBatchAtMostAccountForGridStride;
+        auto h_eventStoreFlags                              = std::make_unique<bool[]>(numEventStoreFlagsOnHost);
+        auto h_eventStoreFlagsPrefixSum                     = std::vector<int>(numEventStoreFlagsOnHost);
         auto numEventsTotal                                 = 0;
+        auto numRaysTraced                                  = static_cast<int64_t>(0);
+        auto numEventsElements                              = std::vector<int64_t>(trackTransmission ? beamlineConf.numElements : 0);
 
         for (int batchIndex = 0; batchIndex < sourceConf.numBatches; ++batchIndex) {
             RAYX_VERB << "processing batch (" << (batchIndex + 1) << "/" << sourceConf.numBatches << ")";
 
-            // generate input rays for batch
-            auto batchConf = m_genRaysResources.genRaysBatch(devAcc, q, batchIndex);
-
-            const auto numRaysBatchAccountForGridStride   = nextMultiple(batchConf.numRaysBatch, GRID_STRIDE_MULTIPLE);
+            const auto numRaysBatch                       = m_genRaysResources.numRaysBatch(batchIndex);
+            const auto numRaysBatchAccountForGridStride   = nextMultiple(numRaysBatch, GRID_STRIDE_MULTIPLE);
             const auto numEventsBatchAccountForGridStride = numRaysBatchAccountForGridStride * maxEvents;
 
             // clear buffers
@@ -256,100 +654,282 @@ class MegaKernelTracer : public DeviceTracer {
 
             // from here we need to account for grid stride in the output buffers of the trace function: uncompacte events and storedFlag
 
-            // trace current batch
-            traceBatch(devAcc, q, beamlineConf.numSources, beamlineConf.numElements, maxEvents, sequential, attrRecordMask, batchConf,
-                       numRaysBatchAccountForGridStride);
+            // generate input rays and trace current batch
+            if (chainState)
+                traceChainedBatch(devAcc, devHost, q, batchIndex, *chainState, beamlineConf, maxEvents, sequential, attrTraceMask,
+                                  numRaysBatchAccountForGridStride);
+            else
+                traceBatch(devAcc, q, m_resources, batchIndex, beamlineConf, maxEvents, sequential, attrTraceMask, numRaysBatchAccountForGridStride);
 
-            alpaka::memcpy(q, alpaka::createView(devHost, h_eventStoreFlags.get(), numEventsBatchAccountForGridStride),
-                           *m_resources.d_eventStoreFlags, numEventsBatchAccountForGridStride);
-            const auto h_eventStoreFlagsPrefixSumEnd = std::exclusive_scan(
-                h_eventStoreFlags.get(), h_eventStoreFlags.get() + numEventsBatchAccountForGridStride, h_eventStoreFlagsPrefixSum.begin(), 0);
-            const auto numEventsBatch =
-                *(h_eventStoreFlagsPrefixSumEnd - 1);  // access the last element of the exclusive scan result to get the total count
-            alpaka::memcpy(q, *m_resources.d_eventStoreFlagsPrefixSum,
-                           alpaka::createView(devHost, h_eventStoreFlagsPrefixSum, numEventsBatchAccountForGridStride),
-                           numEventsBatchAccountForGridStride);
+            const auto numEventsBatch = scanEventStoreFlags(devHost, q, h_eventStoreFlags.get(), h_eventStoreFlagsPrefixSum.data(),
+                                                            numEventsBatchAccountForGridStride);
 
             // TODO: here we could apply more filters by turning off storedFlags
 
-            // compact events to remove unused events
-            compactEvents(devAcc, q, numEventsBatchAccountForGridStride, attrRecordMask);
+            // events passed on batch by batch are not aggregated, so h_events only ever holds the current batch
+            const auto eventsOffset = onBatch ? 0 : numEventsTotal;
 
-            // end of acocunt for grid stride, because from here we use the compacted buffers
+            if constexpr (isAccOnHost<Acc>) {
+                // compact events directly into the output, placed after the events of the previous batches
+                const auto numBatchesRemaining = onBatch ? 0 : sourceConf.numBatches - batchIndex - 1;
+                reserveEvents(h_events, eventsOffset + numEventsBatch, numEventsBatch, numBatchesRemaining, attrTraceMask);
+                compactEvents(devAcc, q, raysToRaysPtr(h_events, eventsOffset), numEventsBatchAccountForGridStride, attrTraceMask);
+            } else {
+                // compact events to remove unused events
+                compactEvents(devAcc, q, raysBufToRaysPtr(m_resources.d_compactEventsBatch), numEventsBatchAccountForGridStride, attrTraceMask);
 
-            numEventsTotal += numEventsBatch;
+                // end of acocunt for grid stride, because from here we use the compacted buffers
+
+                h_compactEventsBatches[batchIndex] = transferEventsBatch(devHost, q, numEventsBatch, attrTraceMask);
+            }
 
-            h_compactEventsBatches[batchIndex] = transferEventsBatch(devHost, q, numEventsBatch, attrRecordMask);
+            if (trackTransmission) {
+                const int32_t* objectIds = nullptr;
+                if constexpr (isAccOnHost<Acc>) objectIds = h_events.object_id.data() + eventsOffset;
+                else objectIds = h_compactEventsBatches[batchIndex].object_id.data();
+                countEventsOnElements(numEventsElements, objectIds, numEventsBatch, beamlineConf.numSources);
+            }
 
-            RAYX_VERB << "finished batch (" << (batchIndex + 1) << "/" << sourceConf.numBatches << ") with batch size = " << batchConf.numRaysBatch
+            if (onBatch) {
+                auto eventsBatch = Rays{};
+                if constexpr (isAccOnHost<Acc>) eventsBatch = std::exchange(h_events, Rays{});
+                else eventsBatch = std::move(h_compactEventsBatches[batchIndex]);
+
+                // remove attributes, that were only traced for adaptive stopping
+                if (attrTraceMask != attrRecordMask) eventsBatch.filterByAttrMask(attrRecordMask);
+                onBatch(std::move(eventsBatch));
+            }
+
+            numEventsTotal += numEventsBatch;
+            numRaysTraced += numRaysBatch;
+
+            RAYX_VERB << "finished batch (" << (batchIndex + 1) << "/" << sourceConf.numBatches << ") with batch size = " << numRaysBatch
                       << ", recorded " << numEventsBatch << " events";
+
+            if (adaptiveStopping.enable && batchIndex + 1 < sourceConf.numBatches && adaptiveStopping.minBatches <= batchIndex + 1) {
+                const auto duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+                const auto relativeError = trackTransmission ? calcMaxRelativeTransmissionError(numEventsElements, objectRecordMask, numRaysTraced)
+                                                             : std::numeric_limits<double>::infinity();
+                const auto converged = trackTransmission && relativeError <= *adaptiveStopping.maxRelativeError;
+                const auto timeout   = adaptiveStopping.maxDuration && *adaptiveStopping.maxDuration <= duration;
+
+                if (trackTransmission) RAYX_VERB << "relative error of transmission after " << numRaysTraced << " rays: " << relativeError;
+
+                if (converged || timeout) {
+                    RAYX_VERB << "adaptive stopping after batch (" << (batchIndex + 1) << "/" << sourceConf.numBatches << ") with " << numRaysTraced
+                              << " of " << sourceConf.numRaysTotal << " rays, because the " << (converged ? "target error" : "time budget")
+                              << " was reached";
+                    if constexpr (!isAccOnHost<Acc>) h_compactEventsBatches.resize(batchIndex + 1);
+                    break;
+                }
+            }
         }
 
         RAYX_VERB << "number of recorded events: " << numEventsTotal;
 
-        return Rays::concat(h_compactEventsBatches);
-    }
+        auto events = Rays{};
+        if constexpr (isAccOnHost<Acc>) events = std::move(h_events);
+        else events = Rays::concat(h_compactEventsBatches);
 
-  private:
-    template <typename DevAcc, typename Queue>
-    void traceBatch(DevAcc devAcc, Queue q, int numSources, int numElements, int maxEvents, Sequential sequential, RayAttrMask attrRecordMask,
-                    GenRaysAcc::BatchConfig& batchConf, int numRaysBatchAccountForGridStride) {
-        RAYX_PROFILE_FUNCTION_STDOUT();
+        // remove attributes, that were only traced for adaptive stopping
+        if (attrTraceMask != attrRecordMask) events.filterByAttrMask(attrRecordMask);
 
-        const auto constState = ConstState{
+        return events;
+    }
+
+    ConstState makeConstState(Resources<Acc>& resources, const typename Resources<Acc>::BeamlineConfig& beamlineConf, int maxEvents,
+                              Sequential sequential, RayAttrMask attrRecordMask, int numRaysBatchAccountForGridStride) {
+        return ConstState{
             // constants
             .maxEvents              = maxEvents,
             .sequential             = sequential,
-            .numSources             = numSources,
-            .numElements            = numElements,
+            .numSources             = beamlineConf.numSources,
+            .numElements            = beamlineConf.numElements,
             .outputEventsGridStride = numRaysBatchAccountForGridStride,
 
             // buffers
-            .objectTransforms = alpaka::getPtrNative(*m_resources.d_objectTransforms),
-            .elements         = alpaka::getPtrNative(*m_resources.d_elements),
-            .materialIndices  = alpaka::getPtrNative(*m_resources.d_materialIndices),
-            .materialTable    = alpaka::getPtrNative(*m_resources.d_materialTable),
-            .objectRecordMask = alpaka::getPtrNative(*m_resources.d_objectRecordMask),
-            .attrRecordMask   = attrRecordMask,
-            .rays             = raysBufToRaysPtr(batchConf.d_rays),
+            .objectTransforms     = alpaka::getPtrNative(*resources.d_objectTransforms),
+            .elements             = alpaka::getPtrNative(*resources.d_elements),
+            .materialIndices      = alpaka::getPtrNative(*resources.d_materialIndices),
+            .materialTable        = alpaka::getPtrNative(*resources.d_materialTable),
+            .refractiveIndexTable = beamlineConf.refractiveIndexTable,
+            .multilayerTables     = alpaka::getPtrNative(*resources.d_multilayerTables),
+            .objectRecordMask     = alpaka::getPtrNative(*resources.d_objectRecordMask),
+            .attrRecordMask       = attrRecordMask,
         };
+    }
 
-        const auto mutableState = MutableState{
+    MutableState makeMutableState(Resources<Acc>& resources) {
+        return MutableState{
             // buffers
-            .events      = raysBufToRaysPtr(m_resources.d_eventsBatch),
-            .storedFlags = alpaka::getPtrNative(*m_resources.d_eventStoreFlags),
+            .events      = raysBufToRaysPtr(resources.d_eventsBatch),
+            .storedFlags = alpaka::getPtrNative(*resources.d_eventStoreFlags),
         };
+    }
+
+    /// generates the rays of a batch and traces them through the beamline of resources
+    template <typename DevAcc, typename Queue>
+    void traceBatch(DevAcc devAcc, Queue q, Resources<Acc>& resources, const int batchIndex,
+                    const typename Resources<Acc>::BeamlineConfig& beamlineConf, int maxEvents, Sequential sequential, RayAttrMask attrRecordMask,
+                    int numRaysBatchAccountForGridStride) {
+        RAYX_PROFILE_FUNCTION_STDOUT();
+
+        if (m_config.fuseRayGeneration) {
+            // every thread generates a ray and traces it right away. the generated rays are never stored
+            RAYX_VERB << "execute GenRaysKernel fused with tracing (" << (sequential == Sequential::Yes ? "sequential" : "non-sequential") << ")";
+            const auto constState = makeConstState(resources, beamlineConf, maxEvents, sequential, attrRecordMask, numRaysBatchAccountForGridStride);
+            m_genRaysResources.genRaysBatch(devAcc, q, batchIndex, TraceRays{.constState = constState, .mutableState = makeMutableState(resources)});
+            return;
+        }
+
+        // generate input rays for batch
+        auto batchConf = m_genRaysResources.genRaysBatch(devAcc, q, batchIndex);
+        traceRays(devAcc, q, resources, beamlineConf, raysBufToRaysPtr(batchConf.d_rays), batchConf.numRaysBatch, maxEvents, sequential,
+                  attrRecordMask, numRaysBatchAccountForGridStride);
+    }
+
+    /// traces the given rays through the beamline of resources
+    template <typename DevAcc, typename Queue>
+    void traceRays(DevAcc devAcc, Queue q, Resources<Acc>& resources, const typename Resources<Acc>::BeamlineConfig& beamlineConf, RaysPtr rays,
+                   const int numRays, int maxEvents, Sequential sequential, RayAttrMask attrRecordMask, int numRaysBatchAccountForGridStride) {
+        auto constState = makeConstState(resources, beamlineConf, maxEvents, sequential, attrRecordMask, numRaysBatchAccountForGridStride);
+        constState.rays = rays;
+        const auto mutableState = makeMutableState(resources);
 
         if (sequential == Sequential::Yes) {
             RAYX_VERB << "execute TraceSequentialKernel";
-            execWithValidWorkDiv<Acc>(devAcc, q, batchConf.numRaysBatch, BlockSizeConstraint::None{}, TraceSequentialKernel{}, constState,
-                                      mutableState, batchConf.numRaysBatch);
+            execWithValidWorkDiv<Acc>(devAcc, q, numRays, BlockSizeConstraint::None{}, TraceSequentialKernel{}, constState, mutableState, numRays);
         } else {
             RAYX_VERB << "execute TraceNonSequentialKernel";
-            execWithValidWorkDiv<Acc>(devAcc, q, batchConf.numRaysBatch, BlockSizeConstraint::None{}, TraceNonSequentialKernel{}, constState,
-                                      mutableState, batchConf.numRaysBatch);
+            execWithValidWorkDiv<Acc>(devAcc, q, numRays, BlockSizeConstraint::None{}, TraceNonSequentialKernel{}, constState, mutableState, numRays);
+        }
+    }
+
+    /// generates the rays of a batch, traces them through the first beamline and passes the rays leaving it at the exit element on to the second
+    /// beamline. the events of the second beamline are recorded with the grid stride of the batch
+    template <typename DevAcc, typename DevHost, typename Queue>
+    void traceChainedBatch(DevAcc devAcc, DevHost& devHost, Queue q, const int batchIndex, const typename ChainResources<Acc>::ChainState& chainState,
+                           const typename Resources<Acc>::BeamlineConfig& beamlineConf, int maxEvents, Sequential sequential,
+                           RayAttrMask attrRecordMask, int numRaysBatchAccountForGridStride) {
+        RAYX_PROFILE_FUNCTION_STDOUT();
+
+        auto& chain             = m_chainResources;
+        const auto numRaysBatch = m_genRaysResources.numRaysBatch(batchIndex);
+
+        // trace through the first beamline
+        alpaka::memset(q, *chain.first.d_eventStoreFlags, 0, numRaysBatchAccountForGridStride * chainState.maxEvents);
+        traceBatch(devAcc, q, chain.first, batchIndex, chainState.beamlineConf, chainState.maxEvents, sequential, RayAttrMask::All,
+                   numRaysBatchAccountForGridStride);
+
+        // find the rays leaving the first beamline and emit them from the source of the second beamline
+        const auto events = raysBufToRaysPtr(chain.first.d_eventsBatch);
+        RAYX_VERB << "execute FindExitEventsKernel";
+        execWithValidWorkDiv<Acc>(devAcc, q, numRaysBatch, BlockSizeConstraint::None{}, FindExitEventsKernel{},
+                                  alpaka::getPtrNative(*chain.d_exitRecordIndices), events, alpaka::getPtrNative(*chain.first.d_eventStoreFlags),
+                                  chainState.maxEvents, numRaysBatchAccountForGridStride, numRaysBatch);
+
+        const auto numRaysChained = scanExitRecordIndices(devHost, q, numRaysBatch);
+        RAYX_VERB << numRaysChained << " of " << numRaysBatch << " rays leave the first beamline at the exit element";
+        if (numRaysChained == 0) return;
+
+        RAYX_VERB << "execute ChainRaysKernel";
+        const auto sourceId = 0;
+        execWithValidWorkDiv<Acc>(devAcc, q, numRaysBatch, BlockSizeConstraint::None{}, ChainRaysKernel{}, raysBufToRaysPtr(chain.d_rays), events,
+                                  alpaka::getPtrNative(*chain.d_exitRecordIndices), alpaka::getPtrNative(*chain.d_exitRecordIndicesPrefixSum),
+                                  chainState.transform, sourceId, numRaysBatchAccountForGridStride, numRaysBatch);
+
+        // trace through the second beamline
+        traceRays(devAcc, q, m_resources, beamlineConf, raysBufToRaysPtr(chain.d_rays), numRaysChained, maxEvents, sequential, attrRecordMask,
+                  numRaysBatchAccountForGridStride);
+    }
+
+    /// computes the exclusive prefix sum of the rays passed on to the second beamline in chained tracing. returns the number of these rays
+    template <typename DevHost, typename Queue>
+    int scanExitRecordIndices(DevHost& devHost, Queue q, const int numRaysBatch) {
+        RAYX_PROFILE_FUNCTION_STDOUT();
+
+        auto& chain           = m_chainResources;
+        const auto isPassedOn = [](const int exitRecordIndex) { return 0 <= exitRecordIndex ? 1 : 0; };
+
+        const auto scan = [&](const int* exitRecordIndices, int* prefixSum) {
+            std::transform_exclusive_scan(exitRecordIndices, exitRecordIndices + numRaysBatch, prefixSum, 0, std::plus<>(), isPassedOn);
+            return prefixSum[numRaysBatch - 1] + isPassedOn(exitRecordIndices[numRaysBatch - 1]);
+        };
+
+        if constexpr (isAccOnHost<Acc>) {
+            // device buffers are host memory, so we scan them in place
+            return scan(alpaka::getPtrNative(*chain.d_exitRecordIndices), alpaka::getPtrNative(*chain.d_exitRecordIndicesPrefixSum));
+        } else {
+            chain.h_exitRecordIndices.resize(numRaysBatch);
+            chain.h_exitRecordIndicesPrefixSum.resize(numRaysBatch);
+            alpaka::memcpy(q, alpaka::createView(devHost, chain.h_exitRecordIndices, numRaysBatch), *chain.d_exitRecordIndices, numRaysBatch);
+            const auto numRaysChained = scan(chain.h_exitRecordIndices.data(), chain.h_exitRecordIndicesPrefixSum.data());
+            alpaka::memcpy(q, *chain.d_exitRecordIndicesPrefixSum, alpaka::createView(devHost, chain.h_exitRecordIndicesPrefixSum, numRaysBatch),
+                           numRaysBatch);
+            return numRaysChained;
+        }
+    }
+
+    /// computes the exclusive prefix sum of the event store flags and makes it available on device side. returns the number of stored events
+    template <typename DevHost, typename Queue>
+    int scanEventStoreFlags(DevHost& devHost, Queue q, bool* h_eventStoreFlags, int* h_eventStoreFlagsPrefixSum,
+                            const int numEventsBatchAccountForGridStride) {
+        RAYX_PROFILE_FUNCTION_STDOUT();
+
+        if constexpr (isAccOnHost<Acc>) {
+            // device buffers are host memory, so we scan them in place
+            const auto d_eventStoreFlags          = alpaka::getPtrNative(*m_resources.d_eventStoreFlags);
+            const auto d_eventStoreFlagsPrefixSum = alpaka::getPtrNative(*m_resources.d_eventStoreFlagsPrefixSum);
+            const auto d_eventStoreFlagsPrefixSumEnd =
+                std::exclusive_scan(d_eventStoreFlags, d_eventStoreFlags + numEventsBatchAccountForGridStride, d_eventStoreFlagsPrefixSum, 0);
+            return *(d_eventStoreFlagsPrefixSumEnd - 1) + d_eventStoreFlags[numEventsBatchAccountForGridStride - 1];
+        } else {
+            alpaka::memcpy(q, alpaka::createView(devHost, h_eventStoreFlags, numEventsBatchAccountForGridStride), *m_resources.d_eventStoreFlags,
+                           numEventsBatchAccountForGridStride);
+            const auto h_eventStoreFlagsPrefixSumEnd = std::exclusive_scan(
+                h_eventStoreFlags, h_eventStoreFlags + numEventsBatchAccountForGridStride, h_eventStoreFlagsPrefixSum, 0);
+            alpaka::memcpy(q, *m_resources.d_eventStoreFlagsPrefixSum,
+                           alpaka::createView(devHost, h_eventStoreFlagsPrefixSum, numEventsBatchAccountForGridStride),
+                           numEventsBatchAccountForGridStride);
+            // access the last element of the exclusive scan result to get the total count
+            return *(h_eventStoreFlagsPrefixSumEnd - 1) + h_eventStoreFlags[numEventsBatchAccountForGridStride - 1];
         }
     }
 
     template <typename DevAcc, typename Queue>
-    void compactEvents(DevAcc devAcc, Queue q, const int numEventsBatchAccountForGridStride, const RayAttrMask attrRecordMask) {
+    void compactEvents(DevAcc devAcc, Queue q, RaysPtr dst, const int numEventsBatchAccountForGridStride, const RayAttrMask attrRecordMask) {
         RAYX_PROFILE_FUNCTION_STDOUT();
 
         // TODO: compare performance to single scatter kernel execution handling all attributes
 
-        auto execKernel = [&]<typename TOptBuf>(TOptBuf& compactAttrBuf, const TOptBuf& attrBuf) {
+        auto execKernel = [&]<typename T>(T* compactAttr, const OptBuf<Acc, T>& attrBuf) {
             execWithValidWorkDiv<Acc>(devAcc, q, numEventsBatchAccountForGridStride, BlockSizeConstraint::None{}, ScatterCompactKernel{},
-                                      alpaka::getPtrNative(*compactAttrBuf), alpaka::getPtrNative(*attrBuf),
-                                      alpaka::getPtrNative(*m_resources.d_eventStoreFlagsPrefixSum),
+                                      compactAttr, alpaka::getPtrNative(*attrBuf), alpaka::getPtrNative(*m_resources.d_eventStoreFlagsPrefixSum),
                                       alpaka::getPtrNative(*m_resources.d_eventStoreFlags), numEventsBatchAccountForGridStride);
         };
 
 #define X(type, name, flag)                                                                  \
     if (contains(attrRecordMask, RayAttrMask::flag)) {                                       \
         RAYX_VERB << "execute ScatterCompactKernel for compaction of ray attribute: " #name; \
-        execKernel(m_resources.d_compactEventsBatch.name, m_resources.d_eventsBatch.name);   \
+        execKernel(dst.name, m_resources.d_eventsBatch.name);                                \
+    }
+
+        RAYX_X_MACRO_RAY_ATTR
+#undef X
     }
 
+    /// grows the attribute vectors of events to hold numEvents. capacity is extrapolated from the current batch, so that the remaining batches
+    /// likely do not cause a reallocation (which would copy all previously recorded events)
+    void reserveEvents(Rays& events, const int numEvents, const int numEventsBatch, const int numBatchesRemaining, const RayAttrMask attrRecordMask) {
+        const auto resize = [&]<typename T>(std::vector<T>& dst) {
+            if (dst.capacity() < static_cast<size_t>(numEvents))
+                dst.reserve(static_cast<size_t>(numEvents) + static_cast<size_t>(numEventsBatch) * numBatchesRemaining);
+            dst.resize(numEvents);
+        };
+
+#define X(type, name, flag) \
+    if (contains(attrRecordMask, RayAttrMask::flag)) resize(events.name);
+
         RAYX_X_MACRO_RAY_ATTR
 #undef X
     }
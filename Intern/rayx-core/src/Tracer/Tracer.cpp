@@ -9,18 +9,19 @@ namespace {
 using DeviceType  = RAYX::DeviceConfig::DeviceType;
 using DeviceIndex = RAYX::DeviceConfig::Device::Index;
 
-inline std::shared_ptr<RAYX::DeviceTracer> createDeviceTracer(DeviceType deviceType, DeviceIndex deviceIndex) {
+inline std::shared_ptr<RAYX::DeviceTracer> createDeviceTracer(DeviceType deviceType, DeviceIndex deviceIndex,
+                                                              const RAYX::TracerConfig& tracerConfig) {
     switch (deviceType) {
         case DeviceType::GpuCuda:
 #if defined(RAYX_CUDA_ENABLED)
-            return std::make_shared<RAYX::MegaKernelTracer<alpaka::TagGpuCudaRt>>(deviceIndex);
+            return std::make_shared<RAYX::MegaKernelTracer<alpaka::TagGpuCudaRt>>(deviceIndex, tracerConfig);
 #else
             RAYX_EXIT << "Failed to create Tracer with Cuda device. Cuda was disabled during build.";
             return nullptr;
 #endif
         case DeviceType::GpuHip:
 #if defined(RAYX_HIP_ENABLED)
-            eturn std::make_shared<RAYX::MegaKernelTracer<alpaka::TagGpuHipRt>>(deviceIndex);
+            eturn std::make_shared<RAYX::MegaKernelTracer<alpaka::TagGpuHipRt>>(deviceIndex, tracerConfig);
 #else
             RAYX_EXIT << "Failed to create Tracer with Hip device. Hip was disabled during build.";
             return nullptr;
@@ -32,23 +33,30 @@ inline std::shared_ptr<RAYX::DeviceTracer> createDeviceTracer(DeviceType deviceT
             RAYX_WARN << "warning: rayx-core was compiled without OpenMP. The CPU tracer will run in a single thread.";
             using TagCpu = alpaka::TagCpuSerial;
 #endif
-            return std::make_shared<RAYX::MegaKernelTracer<TagCpu>>(deviceIndex);
+            return std::make_shared<RAYX::MegaKernelTracer<TagCpu>>(deviceIndex, tracerConfig);
     }
 }
 
 int defaultNonSequentialMaxEvents(const int numObjects) { return RAYX::defaultMaxEvents(numObjects); }
 
+int calcMaxEvents(const RAYX::Sequential sequential, const RAYX::ObjectIndexMask& objectRecordMask, std::optional<int> maxEvents) {
+    // in sequential mode maxEvents will be the same as the number of objects to record
+    return sequential == RAYX::Sequential::Yes ? objectRecordMask.numObjects()
+                                               // in non-sequential mode maxEvents is optional, if not set, it will be estimated
+                                               : (maxEvents ? *maxEvents : defaultNonSequentialMaxEvents(objectRecordMask.numObjects()));
+}
+
 }  // unnamed namespace
 
 namespace RAYX {
 
-Tracer::Tracer(const DeviceConfig& deviceConfig) {
+Tracer::Tracer(const DeviceConfig& deviceConfig, const TracerConfig& tracerConfig) {
     if (deviceConfig.enabledDevicesCount() != 1) RAYX_EXIT << "The number of selected devices must be exactly 1!";
 
     for (const auto& device : deviceConfig.devices) {
         if (device.enable) {
             RAYX_VERB << "Creating tracer with device: " << device.name;
-            m_deviceTracer = createDeviceTracer(device.type, device.index);
+            m_deviceTracer = createDeviceTracer(device.type, device.index, tracerConfig);
             break;
         }
     }
@@ -57,17 +65,45 @@ Tracer::Tracer(const DeviceConfig& deviceConfig) {
 Rays Tracer::trace(const Group& group, const Sequential sequential, const ObjectMask& objectRecordMask, const RayAttrMask attrRecordMask,
                    std::optional<int> maxEvents, std::optional<int> maxBatchSize) {
     const auto actualObjectRecordMask = objectRecordMask.toObjectIndexMask(group.numSources(), group.numElements());
+    const auto actualMaxEvents        = calcMaxEvents(sequential, actualObjectRecordMask, maxEvents);
+    const auto actualMaxBatchSize     = maxBatchSize ? *maxBatchSize : DEFAULT_BATCH_SIZE;
 
-    const auto actualMaxEvents =
-        // in sequential mode maxEvents will be the same as the number of objects to record
-        sequential == Sequential::Yes ? actualObjectRecordMask.numObjects()
-                                      // in non-sequential mode maxEvents is optional, if not set, it will be estimated
-                                      : (maxEvents ? *maxEvents : defaultNonSequentialMaxEvents(actualObjectRecordMask.numObjects()));
+    auto rays =
+        m_deviceTracer->trace(group, sequential, actualObjectRecordMask, attrRecordMask, actualMaxEvents, actualMaxBatchSize, BatchCallback());
+    if (!rays.isValid()) RAYX_EXIT << "Tracer::trace: one or more recorded attributes have different number of items.";
+    return rays;
+}
+
+void Tracer::traceBatches(const Group& group, const BatchCallback& onBatch, const Sequential sequential, const ObjectMask& objectRecordMask,
+                          const RayAttrMask attrRecordMask, std::optional<int> maxEvents, std::optional<int> maxBatchSize) {
+    const auto actualObjectRecordMask = objectRecordMask.toObjectIndexMask(group.numSources(), group.numElements());
+    const auto actualMaxEvents        = calcMaxEvents(sequential, actualObjectRecordMask, maxEvents);
+    const auto actualMaxBatchSize     = maxBatchSize ? *maxBatchSize : DEFAULT_BATCH_SIZE;
+
+    const auto validateAndPass = [&onBatch](Rays&& rays) {
+        if (!rays.isValid()) RAYX_EXIT << "Tracer::traceBatches: one or more recorded attributes have different number of items.";
+        onBatch(std::move(rays));
+    };
+
+    m_deviceTracer->trace(group, sequential, actualObjectRecordMask, attrRecordMask, actualMaxEvents, actualMaxBatchSize, validateAndPass);
+}
+
+Rays Tracer::traceChained(const Group& first, const Group& second, const ChainConfig& chainConfig, const Sequential sequential,
+                          const ObjectMask& objectRecordMask, const RayAttrMask attrRecordMask, std::optional<int> maxEvents,
+                          std::optional<int> maxBatchSize) {
+    const auto actualObjectRecordMask = objectRecordMask.toObjectIndexMask(second.numSources(), second.numElements());
+
+    // same as in trace, but per group: in sequential mode every object has its own event slot, otherwise maxEvents is optional
+    const auto calcMaxEvents = [&](const Group& group) {
+        const auto numObjects = static_cast<int>(group.numSources() + group.numElements());
+        return sequential == Sequential::Yes ? numObjects : (maxEvents ? *maxEvents : defaultNonSequentialMaxEvents(numObjects));
+    };
 
     const auto actualMaxBatchSize = maxBatchSize ? *maxBatchSize : DEFAULT_BATCH_SIZE;
 
-    auto rays = m_deviceTracer->trace(group, sequential, actualObjectRecordMask, attrRecordMask, actualMaxEvents, actualMaxBatchSize);
-    if (!rays.isValid()) RAYX_EXIT << "Tracer::trace: one or more recorded attributes have different number of items.";
+    auto rays = m_deviceTracer->traceChained(first, second, chainConfig, sequential, actualObjectRecordMask, attrRecordMask, calcMaxEvents(first),
+                                             calcMaxEvents(second), actualMaxBatchSize);
+    if (!rays.isValid()) RAYX_EXIT << "Tracer::traceChained: one or more recorded attributes have different number of items.";
     return rays;
 }
 
@@ -8,6 +8,7 @@
 #include "DeviceConfig.h"
 #include "DeviceTracer.h"
 #include "Rays.h"
+#include "TracerConfig.h"
 
 // Abstract Tracer base class.
 namespace RAYX {
@@ -23,8 +24,9 @@ class RAYX_API Tracer {
     /**
      * @brief Construct a new Tracer object
      * @param deviceConfig Configuration for the device to be used for tracing
+     * @param tracerConfig Configuration of optional optimizations of the tracer
      */
-    Tracer(const DeviceConfig& deviceConfig = DeviceConfig().enableBestDevice());
+    Tracer(const DeviceConfig& deviceConfig = DeviceConfig().enableBestDevice(), const TracerConfig& tracerConfig = TracerConfig());
 
     // This will call the trace implementation of a subclass
     // See `BundleHistory` for information about the return value.
@@ -44,6 +46,40 @@ class RAYX_API Tracer {
                const RayAttrMask attrRecordMask = RayAttrMask::All, std::optional<int> maxEvents = std::nullopt,
                std::optional<int> maxBatchSize = std::nullopt);
 
+    /**
+     *  @brief Trace rays through the given group and pass the recorded events on batch by batch, instead of returning all events at once
+     *  Allows to process the events of a batch, e.g. write them to a file, without holding the events of all batches in memory
+     *  @param group The group to trace rays through
+     *  @param onBatch Receives the events of each batch. It is invoked on the calling thread and tracing continues after it returned
+     *  @param sequential Whether to trace rays sequentially or non-sequentially
+     *  @param objectRecordMask Object record mask specifying which sources and elements to record
+     *  @param attrRecordMask Attributes to record for each ray
+     *  @param maxEvents Optional maximum number of events to trace per ray (only used in non-sequential tracing)
+     *  @param maxBatchSize Optional maximum batch size for tracing
+     */
+    void traceBatches(const Group& group, const BatchCallback& onBatch, const Sequential sequential = Sequential::No,
+                      const ObjectMask& objectRecordMask = ObjectMask::all(), const RayAttrMask attrRecordMask = RayAttrMask::All,
+                      std::optional<int> maxEvents = std::nullopt, std::optional<int> maxBatchSize = std::nullopt);
+
+    /**
+     *  @brief Trace rays through two beamlines in a row, without transferring the rays in between to the host
+     *  Rays leave the first group at its exit element and are emitted by the RayListSource of the second group, as if the events on the exit
+     *  element had been recorded and loaded into the RayListSource. The ray list of the RayListSource is not used.
+     *  @param first The group to trace the rays through first. Its sources generate the rays
+     *  @param second The group to trace the rays through afterwards. It must contain exactly one source, which is a RayListSource
+     *  @param chainConfig Exit element of the first group and transform applied to the rays between the groups
+     *  @param sequential Whether to trace rays sequentially or non-sequentially, in both groups
+     *  @param objectRecordMask Object record mask specifying which sources and elements of the second group to record
+     *  @param attrRecordMask Attributes to record for each ray
+     *  @param maxEvents Optional maximum number of events to trace per ray and group (only used in non-sequential tracing)
+     *  @param maxBatchSize Optional maximum batch size for tracing
+     *  @return A `Rays` struct containing the events recorded in the second group
+     */
+    Rays traceChained(const Group& first, const Group& second, const ChainConfig& chainConfig = ChainConfig(),
+                      const Sequential sequential = Sequential::No, const ObjectMask& objectRecordMask = ObjectMask::all(),
+                      const RayAttrMask attrRecordMask = RayAttrMask::All, std::optional<int> maxEvents = std::nullopt,
+                      std::optional<int> maxBatchSize = std::nullopt);
+
   private:
     std::shared_ptr<DeviceTracer> m_deviceTracer;
 };
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <optional>
+
+#include "Core.h"
+#include "Material/Material.h"
+#include "Shader/Constants.h"
+
+namespace RAYX {
+
+/// configures the tabulation of multilayer coating reflectances. See `MultilayerTable`
+struct RAYX_API MultilayerTableConfig {
+    bool enable     = false;          // if disabled, the reflectance of multilayer coatings is computed on every hit
+    int numEnergies = 256;            // initial number of grid points in energy
+    int numAngles   = 1024;           // initial number of grid points in incidence angle
+    std::optional<double> energyMin;  // lower bound of the grid. Default: the lowest energy emitted by the sources
+    std::optional<double> energyMax;  // upper bound of the grid. Default: the highest energy emitted by the sources
+    double angleMin    = 0.0;         // lower bound of the incidence angle (relative to the surface normal) in rad
+    double angleMax    = PI / 2.0;    // upper bound of the incidence angle (relative to the surface normal) in rad
+    double tolerance   = 1e-3;        // maximal absolute deviation of the interpolated from the exact amplitudes, in the center of every cell
+    int maxRefinements = 2;           // how often the grid resolution may be doubled, if the tolerance is exceeded
+};
+
+/// how light sources draw random numbers
+enum class SamplingMode {
+    PseudoRandom,  // independent pseudo random numbers. the error of statistics decreases with 1 / sqrt(N)
+    QuasiRandom,   // scrambled Sobol sequence (randomized quasi Monte Carlo). converges faster for smooth distributions
+};
+
+/// stops tracing before all rays of the sources are traced, as soon as one of the criteria is met. The number of rays of the sources is the upper
+/// bound. In this mode, every batch draws rays from all sources in proportion to their number of rays, so the traced rays are an unbiased sample
+/// of the beamline, no matter after which batch tracing stops
+struct RAYX_API AdaptiveStoppingConfig {
+    bool enable = false;
+    /// stop once the relative standard error of the transmission to every recorded element is below this value. Requires event type and
+    /// object id to be traced, these are recorded internally if not contained in the attribute record mask. As long as a recorded element was not
+    /// reached by any ray, its transmission is unknown and tracing continues
+    std::optional<double> maxRelativeError;
+    std::optional<double> maxDuration;  // stop once the wall clock time spent tracing exceeds this budget in seconds
+    int minBatches = 1;                 // number of batches traced before the criteria are checked
+};
+
+/// Configuration of optional optimizations of the tracer. Applies to every call of `Tracer::trace`.
+struct RAYX_API TracerConfig {
+    /// resample the material tables for O(1) refractive index lookups
+    RefractiveIndexTableConfig refractiveIndexTable;
+    /// tabulate the reflectance of multilayer coatings for O(1) lookups, instead of O(layers)
+    MultilayerTableConfig multilayerTable;
+    /// sampling of the light sources. RayListSources are not affected
+    SamplingMode sourceSampling = SamplingMode::PseudoRandom;
+    /// trace until a convergence or time target is met, instead of tracing all rays
+    AdaptiveStoppingConfig adaptiveStopping;
+    /// generate each ray in the thread that traces it, instead of storing all generated rays of a batch and loading them again for tracing
+    bool fuseRayGeneration = false;
+};
+
+}  // namespace RAYX
@@ -22,6 +22,10 @@ struct RaysBuf {
 #undef X
 };
 
+/// true if the accelerator runs on the host, so that its buffers are directly accessible from host side
+template <typename Acc>
+constexpr bool isAccOnHost = std::is_same_v<alpaka::Dev<Acc>, alpaka::DevCpu>;
+
 template <typename Acc>
 RaysPtr raysBufToRaysPtr(RaysBuf<Acc>& buf) {
     return RaysPtr{
@@ -32,6 +36,16 @@ RaysPtr raysBufToRaysPtr(RaysBuf<Acc>& buf) {
     };
 }
 
+/// create RaysPtr pointing into the attribute vectors of rays, starting at offset. attributes not present in rays are set to nullptr
+inline RaysPtr raysToRaysPtr(Rays& rays, const int offset) {
+    return RaysPtr{
+#define X(type, name, flag) .name = rays.name.empty() ? nullptr : rays.name.data() + offset,
+
+        RAYX_X_MACRO_RAY_ATTR
+#undef X
+    };
+}
+
 inline int ceilIntDivision(const int dividend, const int divisor) { return (divisor + dividend - 1) / divisor; }
 
 inline int nextPowerOfTwo(const int value) { return static_cast<int>(glm::pow(2, glm::ceil(glm::log(value) / glm::log(2)))); }
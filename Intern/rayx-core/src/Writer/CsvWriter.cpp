@@ -1,11 +1,20 @@
 #include "CsvWriter.h"
 
+#include <algorithm>
+#include <charconv>
+#include <deque>
 #include <filesystem>
 #include <fstream>
+#include <future>
 #include <queue>
+#include <sstream>
+#include <string_view>
+#include <thread>
 
 #include "Beamline/StringConversion.h"
 #include "Debug/Debug.h"
+#include "Debug/Instrumentor.h"
+#include "MappedFile.h"
 
 namespace RAYX {
 
@@ -21,24 +30,16 @@ constexpr int MAX_CELL_SIZE_DOUBLE = 24 + PADDING;
 constexpr int MAX_CELL_SIZE_INT    = 11 + PADDING;
 constexpr int MAX_CELL_SIZE_UINT64 = 20 + PADDING;
 constexpr char DELIMITER           = ',';
+constexpr int MAX_BLOCK_SIZE       = 1 << 20;  // number of bytes formatted by one thread at a time, at most
+constexpr int BLOCKS_PER_THREAD    = 2;        // number of blocks in flight per thread, so that threads keep formatting while a block is written
 
-std::string trimWhitespaces(std::string s) {
-    s.erase(s.begin(), std::find_if(s.begin(), s.end(), [](unsigned char ch) { return !std::isspace(ch); }));
-    s.erase(std::find_if(s.rbegin(), s.rend(), [](unsigned char ch) { return !std::isspace(ch); }).base(), s.end());
+std::string_view trimWhitespaces(std::string_view s) {
+    const auto isSpace = [](unsigned char ch) { return std::isspace(ch); };
+    while (!s.empty() && isSpace(s.front())) s.remove_prefix(1);
+    while (!s.empty() && isSpace(s.back())) s.remove_suffix(1);
     return s;
 }
 
-std::string formatAsString(const double v) {
-    // std::format gives us the exact number of digits, that correctly represent the double.
-    return std::format("{}", v);
-}
-
-std::string formatAsString(const int v) { return std::to_string(v); }
-
-std::string formatAsString(const EventType v) { return EventTypeToString.at(v); }
-
-std::string formatAsString(const RandCounter v) { return std::to_string(v); }
-
 template <typename T>
 int calcCellSize(const std::string header);
 
@@ -89,9 +90,43 @@ std::string formatAsCell(std::string s, const int size) {
     return s;
 }
 
+/// writes v right aligned into a cell of the given size at dst. returns the end of the cell
 template <typename T>
-std::string formatAsCell(const T v, const int size) {
-    return formatAsCell(formatAsString(v), size);
+char* writeCell(char* dst, const T v, const int size) {
+    // std::to_chars without format gives us the shortest representation, that correctly represents a double.
+    char str[32];
+    auto len = 0;
+    if constexpr (std::is_same_v<T, EventType>) {
+        const auto& name = EventTypeToString.at(v);
+        len              = static_cast<int>(name.copy(str, sizeof(str)));
+    } else {
+        const auto [end, ec] = std::to_chars(str, str + sizeof(str), v);
+        if (ec != std::errc()) RAYX_EXIT << "cell: failed to format value: " << v;
+        len = static_cast<int>(end - str);
+    }
+
+    if (size < len)
+        RAYX_EXIT << "cell: string \"" << std::string(str, len) << "\" needs to be shortened! maximum size: " << size << ", actual size: " << len;
+    std::fill_n(dst, size - len, ' ');
+    std::copy_n(str, len, dst + size - len);
+    return dst + size;
+}
+
+/// upper bound of the number of characters of a line in the body, including the line break. complex attributes take two cells
+int calcMaxLineSize(const RayAttrMask attr, const std::vector<int>& cellSizes) {
+    auto maxLineSize = 1;
+    auto attrCount   = 0;
+
+    auto addCells = [&]<typename T>(const RayAttrMask flag) {
+        const auto numCells = std::is_same_v<T, complex::Complex> ? 2 : 1;
+        if (contains(attr, flag)) maxLineSize += numCells * (cellSizes.at(attrCount++) + 1);
+    };
+
+#define X(type, name, flag) addCells.operator()<type>(RayAttrMask::flag);
+    RAYX_X_MACRO_RAY_ATTR
+#undef X
+
+    return maxLineSize;
 }
 
 void writeCsvHeader(std::ostream& os, const RayAttrMask attr, const std::vector<int>& cellSizes) {
@@ -119,54 +154,52 @@ void writeCsvHeader(std::ostream& os, const RayAttrMask attr, const std::vector<
 #undef X
 }
 
-void writeCsvBodyLine(std::ostream& os, const int i, const RayAttrMask attr, const Rays& rays, const std::vector<int>& cellSizes) {
+/// writes line i of the body at dst, without line break. returns the end of the line
+char* writeCsvBodyLine(char* dst, const int i, const RayAttrMask attr, const Rays& rays, const std::vector<int>& cellSizes) {
     const auto numAttr = countSetBits(attr);
     auto attrCount     = 0;
 
-    auto writeCell = [&]<typename T>(const std::vector<T>& src, const RayAttrMask flag) {
+    auto writeAttr = [&]<typename T>(const std::vector<T>& src, const RayAttrMask flag) {
         if constexpr (std::is_same_v<T, complex::Complex>) {
             if (contains(attr, flag)) {
-                os << formatAsCell(src[i].real(), cellSizes.at(attrCount)) << DELIMITER;
-                os << formatAsCell(src[i].imag(), cellSizes.at(attrCount));
-                if (++attrCount < numAttr) os << DELIMITER;
+                dst    = writeCell(dst, src[i].real(), cellSizes[attrCount]);
+                *dst++ = DELIMITER;
+                dst    = writeCell(dst, src[i].imag(), cellSizes[attrCount]);
+                if (++attrCount < numAttr) *dst++ = DELIMITER;
             }
         } else {
             if (contains(attr, flag)) {
-                os << formatAsCell(src[i], cellSizes.at(attrCount));
-                if (++attrCount < numAttr) os << DELIMITER;
+                dst = writeCell(dst, src[i], cellSizes[attrCount]);
+                if (++attrCount < numAttr) *dst++ = DELIMITER;
             }
         }
     };
 
-#define X(type, name, flag) writeCell(rays.name, RayAttrMask::flag);
+#define X(type, name, flag) writeAttr(rays.name, RayAttrMask::flag);
     RAYX_X_MACRO_RAY_ATTR
 #undef X
-}
-
-template <typename T>
-T readCell(const std::string& cell);
 
-template <>
-double readCell<double>(const std::string& cell) {
-    return std::stod(cell);
+    return dst;
 }
 
-template <>
-int readCell<int>(const std::string& cell) {
-    return std::stoi(cell);
-}
-
-template <>
-EventType readCell<EventType>(const std::string& cell) {
-    return StringToEventType.at(trimWhitespaces(cell));
-}
+/// parses the cell starting at src into dst. the cell ends at the next delimiter or at the end of the line. returns the beginning of the next cell
+template <typename T>
+const char* readCell(const char* src, const char* lineEnd, T& dst) {
+    const auto* cellEnd = std::find(src, lineEnd, DELIMITER);
+    const auto cell     = trimWhitespaces(std::string_view(src, static_cast<size_t>(cellEnd - src)));
+
+    if constexpr (std::is_same_v<T, EventType>) {
+        const auto it = StringToEventType.find(std::string(cell));
+        if (it == StringToEventType.end())
+            RAYX_EXIT << "error: unknown event type in csv cell: '" << cell << "'";
+        else
+            dst = it->second;
+    } else {
+        const auto [end, ec] = std::from_chars(cell.data(), cell.data() + cell.size(), dst);
+        if (ec != std::errc() || end != cell.data() + cell.size()) RAYX_EXIT << "error: failed to parse csv cell: '" << cell << "'";
+    }
 
-template <>
-RandCounter readCell<RandCounter>(const std::string& cell) {
-    // check if the usage of std::stoull is correct
-    static_assert(std::is_same_v<RandCounter, uint64_t>);
-    static_assert(sizeof(RandCounter) <= sizeof(decltype(std::stoull(cell))));
-    return std::stoull(cell);
+    return cellEnd == lineEnd ? lineEnd : cellEnd + 1;
 }
 
 std::vector<RayAttrMask> readCsvHeader(const std::string& line) {
@@ -174,7 +207,7 @@ std::vector<RayAttrMask> readCsvHeader(const std::string& line) {
     {
         auto ss = std::istringstream(line);
         std::string item;
-        while (std::getline(ss, item, DELIMITER)) attrStrings.push(trimWhitespaces(item));
+        while (std::getline(ss, item, DELIMITER)) attrStrings.push(std::string(trimWhitespaces(item)));
     }
 
     auto attrs = std::vector<RayAttrMask>();
@@ -208,19 +241,17 @@ std::vector<RayAttrMask> readCsvHeader(const std::string& line) {
     return attrs;
 }
 
-void readCsvBodyLine(Rays& rays, const std::vector<RayAttrMask>& attrs, const std::string& line) {
-    auto ss = std::istringstream(line);
-    std::string item;
+/// parses line i of the body into the pre-sized columns of rays
+void readCsvBodyLine(Rays& rays, const std::vector<RayAttrMask>& attrs, const int i, const char* src, const char* lineEnd) {
     auto consumeCell = [&]<typename T>(std::vector<T>& dst) {
         if constexpr (std::is_same_v<T, complex::Complex>) {
-            std::getline(ss, item, DELIMITER);
-            const auto real = readCell<typename T::value_type>(item);
-            std::getline(ss, item, DELIMITER);
-            const auto imag = readCell<typename T::value_type>(item);
-            dst.emplace_back(real, imag);
+            auto real = typename T::value_type();
+            auto imag = typename T::value_type();
+            src       = readCell(src, lineEnd, real);
+            src       = readCell(src, lineEnd, imag);
+            dst[i]    = T(real, imag);
         } else {
-            std::getline(ss, item, DELIMITER);
-            dst.push_back(readCell<T>(item));
+            src = readCell(src, lineEnd, dst[i]);
         }
     };
 
@@ -238,9 +269,30 @@ void readCsvBodyLine(Rays& rays, const std::vector<RayAttrMask>& attrs, const st
     }
 }
 
+/// splits the body into chunks of whole lines, one chunk per thread
+std::vector<std::string_view> splitIntoChunks(std::string_view body, const int numChunks) {
+    auto chunks          = std::vector<std::string_view>();
+    const auto chunkSize = body.size() / numChunks + 1;
+    while (!body.empty()) {
+        auto end = body.find('\n', std::min(body.size(), chunkSize) - 1);
+        end      = end == std::string_view::npos ? body.size() : end + 1;
+        chunks.push_back(body.substr(0, end));
+        body.remove_prefix(end);
+    }
+    return chunks;
+}
+
+/// number of lines in a chunk. the last line of the file may not be terminated by a line break
+int countLines(const std::string_view chunk) {
+    const auto numLineBreaks = static_cast<int>(std::count(chunk.begin(), chunk.end(), '\n'));
+    return chunk.empty() || chunk.back() == '\n' ? numLineBreaks : numLineBreaks + 1;
+}
+
 }  // namespace
 
 void writeCsv(const fs::path& filepath, const Rays& rays) {
+    RAYX_PROFILE_FUNCTION_STDOUT();
+
     const auto attr      = rays.attrMask();
     const auto cellSizes = calcCellSizes(attr);
 
@@ -249,21 +301,88 @@ void writeCsv(const fs::path& filepath, const Rays& rays) {
     writeCsvHeader(file, attr, cellSizes);
     file << '\n';
 
-    const auto size = rays.size();
-    for (int i = 0; i < size; i++) {
-        writeCsvBodyLine(file, i, attr, rays, cellSizes);
-        file << '\n';
+    const auto size         = rays.size();
+    const auto maxLineSize  = calcMaxLineSize(attr, cellSizes);
+    const auto rowsPerBlock = std::max(1, MAX_BLOCK_SIZE / maxLineSize);
+    const auto numThreads   = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    const auto maxInFlight  = numThreads * BLOCKS_PER_THREAD;
+
+    const auto formatBlock = [&](const int begin, const int end) {
+        auto block = std::string(static_cast<size_t>(end - begin) * maxLineSize, '\0');
+        auto* dst  = block.data();
+        for (int i = begin; i < end; ++i) {
+            dst    = writeCsvBodyLine(dst, i, attr, rays, cellSizes);
+            *dst++ = '\n';
+        }
+        block.resize(static_cast<size_t>(dst - block.data()));
+        return block;
+    };
+
+    // every thread formats a block of rows into its own buffer. the blocks are written in order with one write each. as soon as the oldest block
+    // is written, the next block is formatted, so that the memory of the blocks in flight is bounded
+    auto blocks = std::deque<std::future<std::string>>();
+    for (int begin = 0; begin < size || !blocks.empty();) {
+        while (begin < size && static_cast<int>(blocks.size()) < maxInFlight) {
+            const auto end = begin + std::min(rowsPerBlock, size - begin);
+            blocks.push_back(std::async(std::launch::async, formatBlock, begin, end));
+            begin = end;
+        }
+
+        const auto str = blocks.front().get();
+        blocks.pop_front();
+        file.write(str.data(), static_cast<std::streamsize>(str.size()));
     }
 }
 
 Rays readCsv(const fs::path& filepath) {
-    auto file = std::ifstream(filepath);
-    std::string line;
-    std::getline(file, line);
-    const auto attrs = readCsvHeader(line);
+    RAYX_PROFILE_FUNCTION_STDOUT();
+
+    const auto file = MappedFile(filepath);
+    auto body       = file.view();
+
+    const auto headerEnd = std::min(body.size(), body.find('\n'));
+    const auto attrs     = readCsvHeader(std::string(trimWhitespaces(body.substr(0, headerEnd))));
+    body.remove_prefix(std::min(body.size(), headerEnd + 1));
+
+    // count the lines of every chunk in parallel, to know where each chunk starts in the columns
+    const auto numThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    const auto chunks     = splitIntoChunks(body, numThreads);
+
+    auto lineCounts = std::vector<std::future<int>>();
+    for (const auto chunk : chunks) lineCounts.push_back(std::async(std::launch::async, countLines, chunk));
+
+    auto chunkOffsets = std::vector<int>(chunks.size() + 1, 0);
+    for (size_t i = 0; i < chunks.size(); ++i) chunkOffsets[i + 1] = chunkOffsets[i] + lineCounts[i].get();
+    const auto size = chunkOffsets.back();
 
     Rays rays;
-    while (std::getline(file, line)) readCsvBodyLine(rays, attrs, line);
+    for (const auto attr : attrs) {
+        switch (attr) {
+#define X(type, name, flag)     \
+    case RayAttrMask::flag:     \
+        rays.name.resize(size); \
+        break;
+            RAYX_X_MACRO_RAY_ATTR
+#undef X
+            default:
+                break;
+        }
+    }
+
+    // every thread parses its chunk directly into the columns
+    const auto parseChunk = [&](const std::string_view chunk, int i) {
+        const auto* src = chunk.data();
+        const auto* end = chunk.data() + chunk.size();
+        while (src != end) {
+            const auto* lineEnd = std::find(src, end, '\n');
+            readCsvBodyLine(rays, attrs, i++, src, lineEnd);
+            src = lineEnd == end ? end : lineEnd + 1;
+        }
+    };
+
+    auto parsed = std::vector<std::future<void>>();
+    for (size_t i = 0; i < chunks.size(); ++i) parsed.push_back(std::async(std::launch::async, parseChunk, chunks[i], chunkOffsets[i]));
+    for (auto& p : parsed) p.get();
 
     if (!rays.isValid()) RAYX_EXIT << "error: one or more recorded attributes have different number of items";
     return rays;
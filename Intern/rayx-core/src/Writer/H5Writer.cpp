@@ -2,7 +2,11 @@
 
 #include "H5Writer.h"
 
+#include <algorithm>
 #include <highfive/highfive.hpp>
+#include <mutex>
+#include <optional>
+#include <type_traits>
 
 #include "Debug/Debug.h"
 #include "Debug/Instrumentor.h"
@@ -27,23 +31,104 @@ inline HighFive::DataType highfive_create_type_Complex() {
         {"i", HighFive::AtomicType<double>(), sizeof(double)},
     });
 }
+
+inline HighFive::DataType highfive_create_type_ComplexFloat() {
+    return HighFive::CompoundType({
+        {"r", HighFive::AtomicType<float>(), 0},
+        {"i", HighFive::AtomicType<float>(), sizeof(float)},
+    });
+}
 }  // unnamed namespace
 HIGHFIVE_REGISTER_TYPE(RAYX::EventType, highfive_create_type_EventType);
 HIGHFIVE_REGISTER_TYPE(RAYX::complex::Complex, highfive_create_type_Complex);
+HIGHFIVE_REGISTER_TYPE(RAYX::complex::tcomplex<float>, highfive_create_type_ComplexFloat);
 
 namespace RAYX {
 
+namespace {
+
+using RayAttrMaskUnderlying = std::underlying_type_t<RayAttrMask>;
+
+/// HDF5 is not thread-safe, unless it is built with the thread-safety option. the calls into HDF5 are serialized, so that files are read and
+/// written on several threads, e.g. by the writer threads of H5AppendWriter. recursive, since reading the rays of objects may read all rays
+std::recursive_mutex& h5Mutex() {
+    static std::recursive_mutex mutex;
+    return mutex;
+}
+
+/// the attributes stored in rayx/events. files written before the attribute mask was stored, are checked for the existence of the datasets
+RayAttrMask attrMaskOfFile(const HighFive::File& file) {
+    if (file.exist("rayx/attr_mask")) {
+        auto attr = RayAttrMaskUnderlying{0};
+        file.getDataSet("rayx/attr_mask").read(attr);
+        return static_cast<RayAttrMask>(attr);
+    }
+
+    auto attr = RayAttrMask::None;
+
+#define X(type, name, flag) \
+    if (file.exist("rayx/events/" #name)) attr |= RayAttrMask::flag;
+
+    RAYX_X_MACRO_RAY_ATTR
+#undef X
+
+    return attr;
+}
+
+/// the attributes stored as float32. HDF5 converts them back to double on read, so only appending needs to know the encoding
+RayAttrMask float32MaskOfFile(const HighFive::File& file) {
+    if (!file.exist("rayx/encoding/float32")) return RayAttrMask::None;
+
+    auto attr = RayAttrMaskUnderlying{0};
+    file.getDataSet("rayx/encoding/float32").read(attr);
+    return static_cast<RayAttrMask>(attr);
+}
+
+/// the attributes stored per path in files of the normalized layout
+RayAttrMask pathAttrMaskOfFile(const HighFive::File& file) {
+    if (!file.exist("rayx/paths")) return RayAttrMask::None;
+    return attrMaskOfFile(file) & PATH_RAY_ATTR;
+}
+
+/// reads a path attribute of the events [beginEvent, endEvent) of a normalized file and copies the value of each path to its events
+template <typename T>
+void readPathColumn(const HighFive::DataSet& dataset, std::vector<T>& dst, const std::vector<int64_t>& eventOffsets, const int64_t beginEvent,
+                    const int64_t endEvent) {
+    dst.resize(static_cast<size_t>(endEvent - beginEvent));
+    if (endEvent <= beginEvent) return;
+
+    // the paths overlapping the events
+    const auto beginPath = std::ranges::upper_bound(eventOffsets, beginEvent) - eventOffsets.begin() - 1;
+    const auto endPath   = std::ranges::lower_bound(eventOffsets, endEvent) - eventOffsets.begin();
+
+    auto pathColumn = std::vector<T>();
+    dataset.select({static_cast<size_t>(beginPath)}, {static_cast<size_t>(endPath - beginPath)}).read(pathColumn);
+
+    for (auto path = beginPath; path < endPath; ++path) {
+        const auto begin = std::max(eventOffsets[path], beginEvent) - beginEvent;
+        const auto end   = std::min(eventOffsets[path + 1], endEvent) - beginEvent;
+        std::fill(dst.begin() + begin, dst.begin() + end, pathColumn[path - beginPath]);
+    }
+}
+
+}  // unnamed namespace
+
 // TODO: this function should not require, that attr is known beforehand. Mabye we should use attr only to further exclude attributes? Or provide an
 // extra attr that is repsonsible to check for existence?
 Rays readH5Rays(const std::filesystem::path& filepath, const RayAttrMask attr) {
     RAYX_PROFILE_FUNCTION_STDOUT();
     RAYX_VERB << "reading rays from " << filepath << " with attribute flags: " << to_string(attr);
 
+    std::lock_guard lock(h5Mutex());
     Rays rays;
 
     try {
         auto file = HighFive::File(filepath.string(), HighFive::File::ReadOnly);
 
+        const auto pathAttr = pathAttrMaskOfFile(file);
+        auto eventOffsets   = std::vector<int64_t>();
+        if (!!pathAttr) file.getDataSet("rayx/paths/event_offsets").read(eventOffsets);
+
         auto loadData = [&file](const auto& address, auto& dst) {
             file.getDataSet(address).read(dst);
             _assert(0 < dst.size(),
@@ -52,9 +137,12 @@ Rays readH5Rays(const std::filesystem::path& filepath, const RayAttrMask attr) {
                     address);
         };
 
-#define X(type, name, flag)                                                                \
-    RAYX_VERB << "reading ray attribute: " #name " (" << rays.name.size() << " elements)"; \
-    if (contains(attr, RayAttrMask::flag)) loadData("rayx/events/" #name, rays.name);
+#define X(type, name, flag)                                                                                    \
+    RAYX_VERB << "reading ray attribute: " #name " (" << rays.name.size() << " elements)";                     \
+    if (contains(attr, RayAttrMask::flag) && contains(pathAttr, RayAttrMask::flag))                            \
+        readPathColumn(file.getDataSet("rayx/paths/" #name), rays.name, eventOffsets, 0, eventOffsets.back()); \
+    else if (contains(attr, RayAttrMask::flag))                                                                \
+        loadData("rayx/events/" #name, rays.name);
 
         RAYX_X_MACRO_RAY_ATTR
 #undef X
@@ -63,11 +151,71 @@ Rays readH5Rays(const std::filesystem::path& filepath, const RayAttrMask attr) {
     return rays;
 }
 
+Rays readH5Rays(const std::filesystem::path& filepath, const std::vector<int>& objectIds, const RayAttrMask attr) {
+    RAYX_PROFILE_FUNCTION_STDOUT();
+    RAYX_VERB << "reading rays of " << objectIds.size() << " objects from " << filepath << " with attribute flags: " << to_string(attr);
+
+    auto sortedObjectIds = objectIds;
+    std::ranges::sort(sortedObjectIds);
+    sortedObjectIds.erase(std::unique(sortedObjectIds.begin(), sortedObjectIds.end()), sortedObjectIds.end());
+
+    std::lock_guard lock(h5Mutex());
+    Rays rays;
+    auto fileAttr = RayAttrMask::None;
+    auto hasIndex = false;
+
+    try {
+        auto file = HighFive::File(filepath.string(), HighFive::File::ReadOnly);
+        fileAttr  = attrMaskOfFile(file);
+        hasIndex  = file.exist("rayx/object_index");
+
+        if (hasIndex) {
+            auto offsets = std::vector<int64_t>();
+            auto counts  = std::vector<int64_t>();
+            file.getDataSet("rayx/object_index/offsets").read(offsets);
+            file.getDataSet("rayx/object_index/counts").read(counts);
+
+            // the events of an object are contiguous, so the selected objects are a union of ranges
+            auto slab      = HighFive::HyperSlab();
+            auto numEvents = size_t{0};
+            for (const auto objectId : sortedObjectIds) {
+                if (objectId < 0 || static_cast<int>(counts.size()) <= objectId || counts[objectId] == 0) continue;
+                slab |= HighFive::RegularHyperSlab({static_cast<size_t>(offsets[objectId])}, {static_cast<size_t>(counts[objectId])});
+                numEvents += static_cast<size_t>(counts[objectId]);
+            }
+            if (numEvents == 0) return rays;
+
+#define X(type, name, flag)                                                             \
+    if (contains(attr, RayAttrMask::flag) && contains(fileAttr, RayAttrMask::flag)) {   \
+        RAYX_VERB << "reading ray attribute: " #name " (" << numEvents << " elements)"; \
+        rays.name.resize(numEvents);                                                    \
+        file.getDataSet("rayx/events/" #name).select(slab).read(rays.name);             \
+    }
+
+            RAYX_X_MACRO_RAY_ATTR
+#undef X
+        }
+    } catch (const std::exception& e) { RAYX_EXIT << "exception caught while attempting to read h5 file: " << e.what(); }
+
+    if (hasIndex) return rays;
+
+    // without an index, the whole columns are read and filtered
+    RAYX_VERB << "no object index in " << filepath << ", reading whole columns. Write the rays sorted by object_id to create an index";
+    if (!contains(fileAttr, RayAttrMask::ObjectId))
+        RAYX_EXIT << "Cannot read rays of selected objects from '" << filepath << "' because the file contains neither an object index nor object_id";
+
+    rays = readH5Rays(filepath, (attr & fileAttr) | RayAttrMask::ObjectId);
+    rays = rays.filter([&](const int i) { return std::ranges::binary_search(sortedObjectIds, rays.object_id[i]); });
+    rays.filterByAttrMask(attr & fileAttr);
+    return rays;
+}
+
 std::vector<std::string> readH5ObjectNames(const std::filesystem::path& filepath) {
     RAYX_VERB << "reading element names from " << filepath;
 
     auto object_names = std::vector<std::string>();
 
+    std::lock_guard lock(h5Mutex());
     try {
         auto file = HighFive::File(filepath.string(), HighFive::File::ReadOnly);
 
@@ -77,58 +225,422 @@ std::vector<std::string> readH5ObjectNames(const std::filesystem::path& filepath
     return object_names;
 }
 
+namespace {
+
+class H5RayListReader : public RayListReader {
+  public:
+    /// requires the lock of h5Mutex
+    H5RayListReader(const std::filesystem::path& filepath) : m_file(std::in_place, filepath.string(), HighFive::File::ReadOnly) {
+        m_file->getDataSet("rayx/num_events").read(m_size);
+        m_attrMask = attrMaskOfFile(*m_file);
+        m_pathAttr = pathAttrMaskOfFile(*m_file);
+        if (!!m_pathAttr) m_file->getDataSet("rayx/paths/event_offsets").read(m_eventOffsets);
+    }
+
+    ~H5RayListReader() override {
+        std::lock_guard lock(h5Mutex());
+        m_file.reset();
+    }
+
+    int size() const override { return m_size; }
+    RayAttrMask attrMask() const override { return m_attrMask; }
+
+    Rays read(const int offset, const int count) override {
+        assert(0 <= offset && 0 <= count && offset + count <= m_size);
+
+        std::lock_guard lock(h5Mutex());
+        Rays rays;
+        try {
+#define X(type, name, flag)                                                                                         \
+    if (contains(m_pathAttr, RayAttrMask::flag)) {                                                                  \
+        readPathColumn(m_file->getDataSet("rayx/paths/" #name), rays.name, m_eventOffsets, offset, offset + count); \
+    } else if (contains(m_attrMask, RayAttrMask::flag)) {                                                           \
+        rays.name.resize(count);                                                                                    \
+        const auto dataset = m_file->getDataSet("rayx/events/" #name);                                              \
+        dataset.select({static_cast<size_t>(offset)}, {static_cast<size_t>(count)}).read(rays.name);                \
+    }
+
+            RAYX_X_MACRO_RAY_ATTR
+#undef X
+        } catch (const std::exception& e) { RAYX_EXIT << "exception caught while attempting to read h5 file: " << e.what(); }
+
+        return rays;
+    }
+
+  private:
+    std::optional<HighFive::File> m_file;  // closed under the lock of h5Mutex
+    int m_size             = 0;
+    RayAttrMask m_attrMask = RayAttrMask::None;
+    RayAttrMask m_pathAttr = RayAttrMask::None;
+    std::vector<int64_t> m_eventOffsets;  // of the paths in normalized files
+};
+
+}  // unnamed namespace
+
+std::unique_ptr<RayListReader> createH5RayListReader(const std::filesystem::path& filepath) {
+    RAYX_VERB << "open ray list in " << filepath;
+
+    std::lock_guard lock(h5Mutex());
+    try {
+        return std::make_unique<H5RayListReader>(filepath);
+    } catch (const std::exception& e) { RAYX_EXIT << "exception caught while attempting to read h5 file: " << e.what(); }
+    return nullptr;
+}
+
+namespace {
+
+int effectiveChunkSize(const H5WriteOptions& options) {
+    const bool useFilters = 0 < options.deflateLevel || options.shuffle;
+    return 0 < options.chunkSize ? options.chunkSize : (useFilters ? DEFAULT_H5_CHUNK_SIZE : 0);
+}
+
+HighFive::DataSetCreateProps makeEventsCreateProps(const H5WriteOptions& options) {
+    HighFive::DataSetCreateProps props;
+
+    const auto chunkSize = effectiveChunkSize(options);
+    if (chunkSize == 0) return props;
+
+    props.add(HighFive::Chunking(std::vector<hsize_t>{static_cast<hsize_t>(chunkSize)}));
+    if (options.shuffle) props.add(HighFive::Shuffle());
+    if (0 < options.deflateLevel) props.add(HighFive::Deflate(static_cast<unsigned>(options.deflateLevel)));
+
+    return props;
+}
+
+template <typename T>
+constexpr bool isFloat32Encodable = std::is_same_v<T, double> || std::is_same_v<T, complex::Complex>;
+
+/// type of the dataset of an attribute stored as float32
+template <typename T>
+using Float32Of = std::conditional_t<std::is_same_v<T, complex::Complex>, complex::tcomplex<float>, float>;
+
+template <typename T>
+HighFive::DataSet createEventsDataSet(HighFive::File& file, const std::string& name, const HighFive::DataSpace& space,
+                                      const HighFive::DataSetCreateProps& props, const bool float32) {
+    if constexpr (isFloat32Encodable<T>)
+        if (float32) return file.createDataSet<Float32Of<T>>(name, space, props);
+    return file.createDataSet<T>(name, space, props);
+}
+
+/// writes a column to a dataset or a selection of it. HDF5 would convert double to float as well, but converting explicitly avoids its
+/// conversion buffers and works for the complex compound type
+template <typename T, typename Destination>
+void writeEventsColumn(Destination&& dst, const std::vector<T>& column, const bool float32) {
+    if constexpr (isFloat32Encodable<T>) {
+        if (float32) {
+            const auto converted = std::vector<Float32Of<T>>(column.begin(), column.end());
+            dst.write(converted);
+            return;
+        }
+    }
+    dst.write(column);
+}
+
+/// the normalized layout stores the events of a path contiguously, ordered by path_event_id if recorded
+Rays groupByPath(const Rays& rays) {
+    const auto hasPathEventId = !rays.path_event_id.empty();
+    return rays.sort([&](const int lhs, const int rhs) {
+        if (rays.path_id[lhs] != rays.path_id[rhs]) return rays.path_id[lhs] < rays.path_id[rhs];
+        if (hasPathEventId && rays.path_event_id[lhs] != rays.path_event_id[rhs]) return rays.path_event_id[lhs] < rays.path_event_id[rhs];
+        return lhs < rhs;
+    });
+}
+
+/// path attributes of events grouped by path, see H5Layout::Normalized
+struct PathTable {
+    Rays paths;                         // attributes of pathAttr, one element per path
+    std::vector<int64_t> eventOffsets;  // index of the first event of each path, followed by the index after the last event
+};
+
+/// @param firstEvent index of the first event in the file, which all event offsets are shifted by
+PathTable makePathTable(const std::string& filename, const Rays& events, const RayAttrMask pathAttr, const int64_t firstEvent) {
+    auto table = PathTable{.eventOffsets = {firstEvent}};
+    for (int i = 0; i < events.size(); ++i) {
+        if (i == 0 || events.path_id[i] != events.path_id[i - 1]) {
+            if (i != 0) table.eventOffsets.push_back(firstEvent + i);
+
+#define X(type, name, flag) \
+    if (contains(pathAttr, RayAttrMask::flag)) table.paths.name.push_back(events.name[i]);
+
+            RAYX_X_MACRO_RAY_ATTR
+#undef X
+            continue;
+        }
+
+#define X(type, name, flag)                                                                                                                \
+    if (contains(pathAttr, RayAttrMask::flag) && !(events.name[i] == table.paths.name.back()))                                             \
+        RAYX_EXIT << "Cannot write rays to output file '" << filename << "' in the normalized layout because the ray attribute " #name " " \
+                  << "differs between the events of path " << events.path_id[i];
+
+        RAYX_X_MACRO_RAY_ATTR
+#undef X
+    }
+    if (!events.empty()) table.eventOffsets.push_back(firstEvent + events.size());
+    return table;
+}
+
+/// appends rays to the datasets of an opened file. the datasets must be chunked and the file must store exactly the attributes of attr
+void appendRays(HighFive::File& file, const Rays& rays, const RayAttrMask attr) {
+    if (rays.empty()) return;
+
+    if (!contains(rays.attrMask(), attr))
+        RAYX_EXIT << "Cannot append rays to output file '" << file.getName()
+                  << "' because the rays do not contain all attributes specified in the attribute mask: " << to_string(attr)
+                  << ". The rays contain the following attributes: " << to_string(rays.attrMask());
+
+    const auto fileAttr = attrMaskOfFile(file);
+    if (fileAttr != attr)
+        RAYX_EXIT << "Cannot append rays to output file '" << file.getName() << "' because the attribute mask " << to_string(attr)
+                  << " does not match the attributes stored in the file: " << to_string(fileAttr);
+
+    const auto float32  = float32MaskOfFile(file);
+    const auto pathAttr = pathAttrMaskOfFile(file);
+
+    auto numEventsOld = size_t{0};
+    file.getDataSet("rayx/num_events").read(numEventsOld);
+    const auto numEventsNew = numEventsOld + static_cast<size_t>(rays.size());
+
+    // the paths of the batch are appended as new paths after the paths in the file
+    const auto grouped     = !!pathAttr ? groupByPath(rays) : Rays();
+    const auto& events     = !!pathAttr ? grouped : rays;
+    const auto table       = !!pathAttr ? makePathTable(file.getName(), events, pathAttr, static_cast<int64_t>(numEventsOld)) : PathTable();
+    const auto numPathsOld = !!pathAttr ? file.getDataSet("rayx/paths/event_offsets").getDimensions()[0] - 1 : size_t{0};
+
+    auto appendColumn = [&](const std::string& name, const auto& column, const size_t sizeOld, const bool float32) {
+        RAYX_VERB << "append ray attribute: " << name << " (" << column.size() << " elements)";
+        auto dataset = file.getDataSet(name);
+        if (dataset.getSpace().getMaxDimensions()[0] != HighFive::DataSpace::UNLIMITED)
+            RAYX_EXIT << "Cannot append rays to output file '" << file.getName() << "' because the dataset " << name
+                      << " is not resizable. Write the file with a chunk size to allow appending";
+        dataset.resize({sizeOld + column.size()});
+        writeEventsColumn(dataset.select({sizeOld}, {column.size()}), column, float32);
+    };
+
+#define X(type, name, flag)                                                                                     \
+    if (contains(pathAttr, RayAttrMask::flag))                                                                  \
+        appendColumn("rayx/paths/" #name, table.paths.name, numPathsOld, contains(float32, RayAttrMask::flag)); \
+    else if (contains(attr, RayAttrMask::flag))                                                                 \
+        appendColumn("rayx/events/" #name, events.name, numEventsOld, contains(float32, RayAttrMask::flag));
+
+    RAYX_X_MACRO_RAY_ATTR
+#undef X
+
+    // the first offset of the batch is the end of the paths in the file, which is already stored
+    if (!!pathAttr) {
+        const auto eventOffsets = std::vector<int64_t>(table.eventOffsets.begin() + 1, table.eventOffsets.end());
+        appendColumn("rayx/paths/event_offsets", eventOffsets, numPathsOld + 1, false);
+    }
+
+    file.getDataSet("rayx/num_events").write(numEventsNew);
+
+    // appended events are not sorted by object anymore
+    if (file.exist("rayx/object_index")) file.unlink("rayx/object_index");
+}
+
+}  // unnamed namespace
+
 void writeH5(const std::filesystem::path& filepath, const std::vector<std::string>& object_names, const Rays& rays, const RayAttrMask attr,
-             const bool overwrite) {
+             const bool overwrite, const H5WriteOptions& options) {
     RAYX_PROFILE_FUNCTION_STDOUT();
-    RAYX_VERB << "write rays to " << filepath << " with attribute flags: " << to_string(attr);
+    RAYX_VERB << "write rays to " << filepath << " with attribute flags: " << to_string(attr) << ", chunk size: " << options.chunkSize
+              << ", deflate level: " << options.deflateLevel << ", shuffle: " << options.shuffle
+              << ", float32 attribute flags: " << to_string(options.encoding.float32)
+              << ", normalized: " << (options.layout == H5Layout::Normalized);
+
+    if (options.chunkSize < 0) RAYX_EXIT << "Cannot write rays to output file '" << filepath << "' because the chunk size is negative";
+    if (options.deflateLevel < 0 || 9 < options.deflateLevel)
+        RAYX_EXIT << "Cannot write rays to output file '" << filepath << "' because the deflate level " << options.deflateLevel
+                  << " is not in range [0, 9]";
+    validateOutputEncoding(options.encoding);
+    if (!!(options.encoding.fixed32 | options.encoding.fixed16))
+        RAYX_EXIT << "Cannot write rays to output file '" << filepath
+                  << "' because fixed point encodings are only supported by the .rayx format. Use float32 instead";
+    if (options.layout == H5Layout::Normalized && !contains(attr, RayAttrMask::PathId))
+        RAYX_EXIT << "Cannot write rays to output file '" << filepath << "' in the normalized layout because path_id is not recorded";
 
-    if (!contains(rays.attrMask(), attr))
+    // empty rays create empty datasets for all attributes in attr
+    if (!rays.empty() && !contains(rays.attrMask(), attr))
         RAYX_EXIT << "Cannot write rays to output file '" << filepath
                   << "' because the rays do not contain all attributes specified in the attribute mask: " << to_string(attr)
                   << ". The rays contain the following attributes: " << to_string(rays.attrMask());
 
+    std::lock_guard lock(h5Mutex());
     try {
         const auto flags = HighFive::File::ReadWrite | HighFive::File::Create | (overwrite ? HighFive::File::Truncate : HighFive::File::Excl);
         auto file        = HighFive::File(filepath.string(), flags);
 
-#define X(type, name, flag)                                                              \
-    RAYX_VERB << "write ray attribute: " #name " (" << rays.name.size() << " elements)"; \
-    if (contains(attr, RayAttrMask::flag)) file.createDataSet("rayx/events/" #name, rays.name);
+        // the normalized layout stores the path attributes once per path, the events reference their path by the event offsets of the paths
+        const auto pathAttr = options.layout == H5Layout::Normalized ? attr & PATH_RAY_ATTR : RayAttrMask::None;
+        const auto grouped  = !!pathAttr ? groupByPath(rays) : Rays();
+        const auto& events  = !!pathAttr ? grouped : rays;
+        const auto table    = !!pathAttr ? makePathTable(filepath.string(), events, pathAttr, 0) : PathTable();
+
+        // chunked datasets are created resizable, so that they can be appended to
+        const auto props     = makeEventsCreateProps(options);
+        const auto numEvents = static_cast<size_t>(rays.size());
+        const auto makeSpace = [&options](const size_t size) {
+            return effectiveChunkSize(options) == 0 ? HighFive::DataSpace({size}) : HighFive::DataSpace({size}, {HighFive::DataSpace::UNLIMITED});
+        };
+
+        auto writeColumn = [&]<typename T>(const std::string& name, const std::vector<T>& column, const bool float32) {
+            RAYX_VERB << "write ray attribute: " << name << " (" << column.size() << " elements)";
+            auto dataset = createEventsDataSet<T>(file, name, makeSpace(column.size()), props, float32);
+            if (!column.empty()) writeEventsColumn(dataset, column, float32);
+            RAYX_VERB << "stored ray attribute: " << name << " (" << dataset.getStorageSize() << " of " << column.size() * sizeof(T) << " bytes)";
+        };
+
+#define X(type, name, flag)                                                                                        \
+    if (contains(pathAttr, RayAttrMask::flag))                                                                     \
+        writeColumn("rayx/paths/" #name, table.paths.name, contains(options.encoding.float32, RayAttrMask::flag)); \
+    else if (contains(attr, RayAttrMask::flag))                                                                    \
+        writeColumn("rayx/events/" #name, events.name, contains(options.encoding.float32, RayAttrMask::flag));
 
         RAYX_X_MACRO_RAY_ATTR
 #undef X
 
-        // TODO: store RayAttrMask
-        file.createDataSet("rayx/num_events", rays.size());
+        if (!!pathAttr) writeColumn("rayx/paths/event_offsets", table.eventOffsets, false);
+
+        file.createDataSet("rayx/attr_mask", static_cast<RayAttrMaskUnderlying>(attr));
+        if (!!options.encoding.float32)
+            file.createDataSet("rayx/encoding/float32", static_cast<RayAttrMaskUnderlying>(options.encoding.float32 & attr));
+        file.createDataSet("rayx/num_events", numEvents);
         file.createDataSet("rayx/object_names", object_names);
+
+        // rays sorted by object are indexed, so that the events of single objects can be read without reading whole columns. normalized files are
+        // sorted by path instead
+        if (contains(attr, RayAttrMask::ObjectId) && !pathAttr && !rays.empty() && std::ranges::is_sorted(rays.object_id)) {
+            const auto numObjects = std::max(static_cast<int>(object_names.size()), rays.object_id.back() + 1);
+            auto offsets          = std::vector<int64_t>(numObjects);
+            auto counts           = std::vector<int64_t>(numObjects);
+            for (int objectId = 0; objectId < numObjects; ++objectId) {
+                const auto [begin, end] = std::ranges::equal_range(rays.object_id, objectId);
+                offsets[objectId]       = begin - rays.object_id.begin();
+                counts[objectId]        = end - begin;
+            }
+
+            RAYX_VERB << "write object index for " << numObjects << " objects";
+            file.createDataSet("rayx/object_index/offsets", offsets);
+            file.createDataSet("rayx/object_index/counts", counts);
+        }
     } catch (const std::exception& e) { RAYX_EXIT << "exception caught while attempting to write h5 file: " << e.what(); }
 }
 
 void appendH5(const std::filesystem::path& filepath, const Rays& rays, const RayAttrMask attr) {
-    // TODO: fix this function
-    assert(false && "unimplemented");
-
     RAYX_PROFILE_FUNCTION_STDOUT();
     RAYX_VERB << "append rays to " << filepath << " with attribute flags: " << to_string(attr);
 
     if (!std::filesystem::is_regular_file(filepath))
         RAYX_EXIT << "Cannot append to output file '" << filepath << "' because it does not exist or is not a regular file.";
 
+    std::lock_guard lock(h5Mutex());
     try {
         auto file = HighFive::File(filepath.string(), HighFive::File::ReadWrite);
+        appendRays(file, rays, attr);
+    } catch (const std::exception& e) { RAYX_EXIT << "exception caught while attempting to write h5 file: " << e.what(); }
+}
+
+H5AppendWriter::H5AppendWriter(const std::filesystem::path& filepath, const RayAttrMask attr, const int maxQueueSize)
+    : m_filepath(filepath), m_attr(attr), m_maxQueueSize(maxQueueSize) {
+    if (!std::filesystem::is_regular_file(filepath))
+        RAYX_EXIT << "Cannot append to output file '" << filepath << "' because it does not exist or is not a regular file.";
+    if (maxQueueSize <= 0) RAYX_EXIT << "Cannot append to output file '" << filepath << "' because the queue size is not positive";
 
-#define X(type, name, flag)                                                               \
-    RAYX_VERB << "append ray attribute: " #name " (" << rays.name.size() << " elements)"; \
-    if (contains(attr, RayAttrMask::flag)) {                                              \
-        auto dataset        = file.getDataSet("rayx/events/" #name);                      \
-        const auto old_size = dataset.getSpace().getDimensions()[0];                      \
-        dataset.resize({old_size + rays.name.size()});                                    \
-        dataset.select({old_size}, {rays.name.size()}).write(rays.name);                  \
+    m_thread = std::thread(&H5AppendWriter::run, this);
+}
+
+H5AppendWriter::~H5AppendWriter() {
+    stop();
+
+    // the destructor may run while an exception unwinds, e.g. the error raised by push. raising again would terminate the program
+    std::lock_guard lock(m_mutex);
+    if (m_error && !m_errorRaised) RAYX_WARN << "failed to append rays to h5 file '" << m_filepath << "': " << *m_error;
+}
+
+void H5AppendWriter::push(Rays&& rays) {
+    {
+        std::unique_lock lock(m_mutex);
+        assert(!m_finished && "rays must not be pushed after finish");
+        m_queueNotFull.wait(lock, [this] { return static_cast<int>(m_queue.size()) < m_maxQueueSize || m_error; });
+        if (!m_error) m_queue.push_back(std::move(rays));
     }
+    m_queueNotEmpty.notify_one();
+    raiseError();
+}
 
-        RAYX_X_MACRO_RAY_ATTR
-#undef X
-    } catch (const std::exception& e) { RAYX_EXIT << "exception caught while attempting to write h5 file: " << e.what(); }
+void H5AppendWriter::finish() {
+    stop();
+    raiseError();
+}
+
+void H5AppendWriter::stop() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_finished = true;
+    }
+    m_queueNotEmpty.notify_one();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void H5AppendWriter::raiseError() {
+    std::string error;
+    {
+        std::lock_guard lock(m_mutex);
+        if (!m_error || m_errorRaised) return;
+        m_errorRaised = true;
+        error         = *m_error;
+    }
+    RAYX_EXIT << "exception caught while attempting to write h5 file: " << error;
+}
+
+void H5AppendWriter::run() {
+    RAYX_VERB << "start writer thread, appending rays to " << m_filepath;
+
+    // the file stays open until all rays are written, which saves reopening and reading the metadata for every batch. other threads may use
+    // HDF5 in between the batches
+    auto file = std::optional<HighFive::File>();
+
+    try {
+        {
+            std::lock_guard lock(h5Mutex());
+            file.emplace(m_filepath.string(), HighFive::File::ReadWrite);
+        }
+
+        while (true) {
+            auto rays = Rays{};
+            {
+                std::unique_lock lock(m_mutex);
+                m_queueNotEmpty.wait(lock, [this] { return !m_queue.empty() || m_finished; });
+                if (m_queue.empty()) break;
+                rays = std::move(m_queue.front());
+                m_queue.pop_front();
+            }
+            m_queueNotFull.notify_one();
+
+            std::lock_guard lock(h5Mutex());
+            RAYX_PROFILE_SCOPE_STDOUT("appendH5");
+            appendRays(*file, rays, m_attr);
+        }
+
+        std::lock_guard lock(h5Mutex());
+        file.reset();
+    } catch (const std::exception& e) {
+        // RAYX_EXIT on this thread could neither be caught by the caller, nor stop the caller waiting in push. the error is raised on the
+        // thread of the caller instead, and the queued rays are discarded
+        {
+            std::lock_guard lock(h5Mutex());
+            file.reset();
+        }
+        {
+            std::lock_guard lock(m_mutex);
+            m_error = e.what();
+            m_queue.clear();
+        }
+        m_queueNotFull.notify_all();
+        m_queueNotEmpty.notify_all();
+        return;
+    }
+
+    RAYX_VERB << "stop writer thread, finished appending rays to " << m_filepath;
 }
 
 }  // namespace RAYX
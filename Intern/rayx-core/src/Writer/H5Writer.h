@@ -1,18 +1,95 @@
 #pragma once
 
+#include <condition_variable>
+#include <deque>
 #include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
 
+#include "OutputEncoding.h"
+#include "RayListReader.h"
 #include "Rays.h"
 
 namespace RAYX {
 
+constexpr int DEFAULT_H5_CHUNK_SIZE = 1 << 16;
+
+/// attributes, that are the same for all events of a path
+constexpr RayAttrMask PATH_RAY_ATTR = RayAttrMask::PathId | RayAttrMask::SourceId | RayAttrMask::Energy;
+
+/// arrangement of the rays in an h5 file
+enum class RAYX_API H5Layout {
+    Flat,        // one row per event in rayx/events
+    Normalized,  // attributes of PATH_RAY_ATTR are stored once per path in rayx/paths, the other attributes per event in rayx/events. the events
+                 // are grouped by path and rayx/paths/event_offsets stores the index of the first event of each path, followed by the number
+                 // of events. requires path_id
+};
+
+/// layout of the datasets in rayx/events. HDF5 filters can only be applied to chunked datasets, so enabling deflate or shuffle without a chunk
+/// size uses DEFAULT_H5_CHUNK_SIZE. chunked datasets are resizable, which is required to append to them
+struct RAYX_API H5WriteOptions {
+    int chunkSize           = 0;      // number of elements per chunk. 0 writes contiguous datasets
+    int deflateLevel        = 0;      // gzip compression level in [0, 9]. 0 disables deflate
+    bool shuffle            = false;  // reorder the bytes of the elements before compression. improves the ratio of slowly varying columns
+    OutputEncoding encoding = {};     // only float32 is supported. the fixed point encodings are stored per block and require the .rayx format
+    H5Layout layout         = H5Layout::Flat;
+};
+
 #ifndef NO_H5
 RAYX_API Rays readH5Rays(const std::filesystem::path& filepath, const RayAttrMask attr = RayAttrMask::All);
+/// reads the events of the given objects, in the order stored in the file. attributes of attr, that are not stored in the file, are skipped.
+/// files written sorted by object_id contain an index, so that only the ranges of the selected objects are read. otherwise whole columns are read
+RAYX_API Rays readH5Rays(const std::filesystem::path& filepath, const std::vector<int>& objectIds, const RayAttrMask attr = RayAttrMask::All);
 RAYX_API std::vector<std::string> readH5ObjectNames(const std::filesystem::path& filepath);
+/// creates a reader, that reads slices of the rays in an h5 file. Only the attributes stored in the file are read
+RAYX_API std::unique_ptr<RayListReader> createH5RayListReader(const std::filesystem::path& filepath);
 
+/// rays sorted by object_id are written with an index of the events of each object, see readH5Rays. the normalized layout writes the events
+/// sorted by path_id and path_event_id, so they are read back in this order
 RAYX_API void writeH5(const std::filesystem::path& filepath, const std::vector<std::string>& object_names, const Rays& rays,
-                      const RayAttrMask attr = RayAttrMask::All, const bool overwrite = true);
+                      const RayAttrMask attr = RayAttrMask::All, const bool overwrite = true, const H5WriteOptions& options = H5WriteOptions());
+/// appends rays to a file written by writeH5 with a chunk size, using the encoding and layout of the file. attr must match the attributes stored
+/// in the file
 RAYX_API void appendH5(const std::filesystem::path& filepath, const Rays& rays, const RayAttrMask attr = RayAttrMask::All);
+
+/// appends rays to a file on a dedicated writer thread, so that the caller, e.g. the tracer, continues while HDF5 compresses and writes. push
+/// only blocks, if maxQueueSize pushed batches are waiting to be written. same requirements on the file as for appendH5. an error of the writer
+/// thread is raised with RAYX_EXIT on the thread of the caller, by the next push or by finish
+class RAYX_API H5AppendWriter {
+  public:
+    H5AppendWriter(const std::filesystem::path& filepath, const RayAttrMask attr = RayAttrMask::All, const int maxQueueSize = 2);
+    H5AppendWriter(const H5AppendWriter&)            = delete;
+    H5AppendWriter& operator=(const H5AppendWriter&) = delete;
+    /// stops the writer thread. an error, that was not raised by push or finish, is only reported as a warning
+    ~H5AppendWriter();
+
+    /// rays pushed after an error of the writer thread are discarded
+    void push(Rays&& rays);
+    /// waits until all pushed rays are written and stops the writer thread. rays must not be pushed afterwards
+    void finish();
+
+  private:
+    void run();
+    void stop();
+    /// raises the error of the writer thread with RAYX_EXIT, unless it was raised before. requires m_mutex to be unlocked
+    void raiseError();
+
+    const std::filesystem::path m_filepath;
+    const RayAttrMask m_attr;
+    const int m_maxQueueSize;
+
+    std::deque<Rays> m_queue;
+    std::mutex m_mutex;
+    std::condition_variable m_queueNotEmpty;
+    std::condition_variable m_queueNotFull;
+    bool m_finished = false;
+    std::optional<std::string> m_error;  // message of the exception, that stopped the writer thread
+    bool m_errorRaised = false;
+    std::thread m_thread;
+};
 #endif
 
 }  // namespace RAYX
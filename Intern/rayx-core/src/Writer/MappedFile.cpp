@@ -0,0 +1,65 @@
+#include "MappedFile.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include "Debug/Debug.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace RAYX {
+
+MappedFile::MappedFile(const std::filesystem::path& filepath) {
+#if defined(_WIN32)
+    auto file = CreateFileW(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) RAYX_EXIT << "error: failed to open file: " << filepath;
+    m_file = file;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) RAYX_EXIT << "error: failed to query size of file: " << filepath;
+    m_size = static_cast<size_t>(size.QuadPart);
+    if (m_size == 0) return;
+
+    m_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_mapping == nullptr) RAYX_EXIT << "error: failed to map file: " << filepath;
+    m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (m_data == nullptr) RAYX_EXIT << "error: failed to map file: " << filepath;
+#else
+    m_fd = open(filepath.c_str(), O_RDONLY);
+    if (m_fd == -1) RAYX_EXIT << "error: failed to open file: " << filepath << ": " << std::strerror(errno);
+
+    struct stat st;
+    if (fstat(m_fd, &st) == -1) RAYX_EXIT << "error: failed to query size of file: " << filepath << ": " << std::strerror(errno);
+    m_size = static_cast<size_t>(st.st_size);
+    if (m_size == 0) return;
+
+    auto* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+    if (data == MAP_FAILED)
+        RAYX_EXIT << "error: failed to map file: " << filepath << ": " << std::strerror(errno);
+    else
+        m_data = static_cast<const char*>(data);
+#endif
+}
+
+MappedFile::~MappedFile() {
+#if defined(_WIN32)
+    if (m_data != nullptr) UnmapViewOfFile(m_data);
+    if (m_mapping != nullptr) CloseHandle(m_mapping);
+    if (m_file != nullptr) CloseHandle(m_file);
+#else
+    if (m_data != nullptr) munmap(const_cast<char*>(m_data), m_size);
+    if (m_fd != -1) close(m_fd);
+#endif
+}
+
+}  // namespace RAYX
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+
+namespace RAYX {
+
+/// read-only memory mapping of a whole file. the pages are loaded by the os on first access, so the file is never copied into a buffer. the
+/// data is valid as long as the MappedFile lives. an empty file has no mapping and yields a null data pointer
+class MappedFile {
+  public:
+    explicit MappedFile(const std::filesystem::path& filepath);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    std::string_view view() const { return m_data == nullptr ? std::string_view() : std::string_view(m_data, m_size); }
+
+  private:
+#if defined(_WIN32)
+    void* m_file    = nullptr;  // HANDLE
+    void* m_mapping = nullptr;  // HANDLE
+#else
+    int m_fd = -1;
+#endif
+    const char* m_data = nullptr;
+    size_t m_size      = 0;
+};
+
+}  // namespace RAYX
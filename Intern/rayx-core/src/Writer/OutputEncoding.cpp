@@ -0,0 +1,24 @@
+#include "OutputEncoding.h"
+
+#include "Debug/Debug.h"
+
+namespace RAYX {
+
+ColumnEncoding OutputEncoding::of(const RayAttrMask flag) const {
+    if (contains(float32, flag)) return ColumnEncoding::Float32;
+    if (contains(fixed32, flag)) return ColumnEncoding::Fixed32;
+    if (contains(fixed16, flag)) return ColumnEncoding::Fixed16;
+    return ColumnEncoding::Float64;
+}
+
+void validateOutputEncoding(const OutputEncoding& encoding) {
+    const auto encoded = encoding.float32 | encoding.fixed32 | encoding.fixed16;
+    if (!contains(ENCODABLE_RAY_ATTR, encoded))
+        RAYX_EXIT << "error: only floating point ray attributes can be stored with reduced precision. not encodable: "
+                  << to_string(exclude(encoded, ENCODABLE_RAY_ATTR));
+
+    if (!!(encoding.float32 & encoding.fixed32) || !!(encoding.float32 & encoding.fixed16) || !!(encoding.fixed32 & encoding.fixed16))
+        RAYX_EXIT << "error: every ray attribute can be stored with only one encoding";
+}
+
+}  // namespace RAYX
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+#include "RayAttrMask.h"
+
+namespace RAYX {
+
+/// encoding of a floating point ray attribute in an output file. complex attributes encode the real and imaginary part the same way
+enum class RAYX_API ColumnEncoding : uint8_t {
+    Float64 = 0,  // exact
+    Float32 = 1,  // relative precision of about 6e-8
+    Fixed32 = 2,  // quantized to 32 bit between the minimum and maximum of the events of each object
+    Fixed16 = 3,  // quantized to 16 bit between the minimum and maximum of the events of each object
+};
+
+/// floating point ray attributes, that can be stored with reduced precision
+constexpr RayAttrMask ENCODABLE_RAY_ATTR =
+    RayAttrMask::Position | RayAttrMask::Direction | RayAttrMask::ElectricField | RayAttrMask::OpticalPathLength | RayAttrMask::Energy;
+
+/// selects the attributes, that are stored with reduced precision in output files. the masks must not overlap and contain only attributes of
+/// ENCODABLE_RAY_ATTR. attributes in none of the masks are stored exactly. the fixed point encodings use the bounds of the events of each
+/// object, if object_id is recorded, otherwise the bounds of all events. values that are not finite, are read back as NaN
+struct RAYX_API OutputEncoding {
+    RayAttrMask float32 = RayAttrMask::None;
+    RayAttrMask fixed32 = RayAttrMask::None;
+    RayAttrMask fixed16 = RayAttrMask::None;
+
+    /// encoding of a single attribute
+    ColumnEncoding of(const RayAttrMask flag) const;
+    bool isExact() const { return !(float32 | fixed32 | fixed16); }
+};
+
+RAYX_API void validateOutputEncoding(const OutputEncoding& encoding);
+
+}  // namespace RAYX
@@ -0,0 +1,50 @@
+#include "RayListReader.h"
+
+#include "Debug/Debug.h"
+#include "H5Writer.h"
+#include "RayxWriter.h"
+
+namespace RAYX {
+
+namespace {
+
+class MemoryRayListReader : public RayListReader {
+  public:
+    MemoryRayListReader(std::shared_ptr<Rays> rays) : m_rays(std::move(rays)), m_attrMask(m_rays->attrMask()) {}
+
+    int size() const override { return m_rays->size(); }
+    RayAttrMask attrMask() const override { return m_attrMask; }
+
+    Rays read(const int offset, const int count) override {
+        assert(0 <= offset && 0 <= count && offset + count <= size());
+
+        Rays rays;
+#define X(type, name, flag) \
+    if (contains(m_attrMask, RayAttrMask::flag)) rays.name.assign(m_rays->name.begin() + offset, m_rays->name.begin() + offset + count);
+
+        RAYX_X_MACRO_RAY_ATTR
+#undef X
+
+        return rays;
+    }
+
+  private:
+    std::shared_ptr<Rays> m_rays;
+    RayAttrMask m_attrMask;
+};
+
+}  // unnamed namespace
+
+std::unique_ptr<RayListReader> createRayListReader(std::shared_ptr<Rays> rays) { return std::make_unique<MemoryRayListReader>(std::move(rays)); }
+
+std::unique_ptr<RayListReader> createRayListReader(const std::filesystem::path& filepath) {
+    if (filepath.extension() == ".rayx") return createRayxRayListReader(filepath);
+#ifndef NO_H5
+    if (filepath.extension() == ".h5") return createH5RayListReader(filepath);
+#endif
+
+    RAYX_EXIT << "unsupported file format of ray list: " << filepath;
+    return nullptr;
+}
+
+}  // namespace RAYX
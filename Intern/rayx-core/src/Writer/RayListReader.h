@@ -0,0 +1,32 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+
+#include "Rays.h"
+
+namespace RAYX {
+
+/// reads consecutive slices of a ray list, so that only the rays needed at a time are held in memory. A ray list may contain only some of the
+/// ray attributes
+class RAYX_API RayListReader {
+  public:
+    virtual ~RayListReader() = default;
+
+    /// number of rays in the ray list
+    virtual int size() const = 0;
+
+    /// attributes contained in the ray list
+    virtual RayAttrMask attrMask() const = 0;
+
+    /// reads `count` rays starting at `offset`
+    virtual Rays read(const int offset, const int count) = 0;
+};
+
+/// creates a reader of a ray list held in memory
+RAYX_API std::unique_ptr<RayListReader> createRayListReader(std::shared_ptr<Rays> rays);
+
+/// creates a reader of a ray list stored in a file. The file format is deduced from the file extension
+RAYX_API std::unique_ptr<RayListReader> createRayListReader(const std::filesystem::path& filepath);
+
+}  // namespace RAYX
@@ -0,0 +1,573 @@
+#include "RayxWriter.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#include "Debug/Debug.h"
+#include "Debug/Instrumentor.h"
+#include "MappedFile.h"
+
+namespace RAYX {
+
+namespace {
+
+using RayAttrMaskUnderlying = std::underlying_type_t<RayAttrMask>;
+
+constexpr std::array<char, 8> RAYX_FILE_MAGIC = {'R', 'A', 'Y', 'X', 'R', 'A', 'Y', 'S'};
+constexpr uint32_t RAYX_FILE_VERSION          = 2;
+constexpr uint32_t RAYX_BYTE_ORDER_MARK       = 0x01020304;  // reads differently on a machine with another byte order
+constexpr int64_t MAX_RAYX_FILE_EVENTS        = std::numeric_limits<int>::max();
+
+struct FileHeader {
+    std::array<char, 8> magic;
+    uint32_t version;
+    uint32_t byteOrderMark;
+    RayAttrMaskUnderlying attrMask;
+    uint32_t numObjectNames;  // the object names follow the header, each as uint32_t length and characters
+    int64_t numEvents;
+    int64_t numBlocks;
+    int64_t firstBlockOffset;
+    int64_t endOffset;  // end of the last block. appended blocks start here
+    // attributes stored with reduced precision, see OutputEncoding
+    RayAttrMaskUnderlying float32;
+    RayAttrMaskUnderlying fixed32;
+    RayAttrMaskUnderlying fixed16;
+};
+
+struct BlockHeader {
+    int64_t numEvents;
+    int64_t blockSize;  // number of bytes of the block, including this header and padding
+    // fixed point columns start with the bounds of the objects [minObjectId, minObjectId + numBoundObjects), as pairs of minimum and maximum
+    int32_t minObjectId;
+    int32_t numBoundObjects;
+};
+
+#define X(type, name, flag) static_assert(std::is_trivially_copyable_v<type>, "columns of " #name " are stored as raw bytes");
+RAYX_X_MACRO_RAY_ATTR
+#undef X
+
+constexpr size_t alignUp(const size_t size) { return (size + RAYX_FILE_ALIGNMENT - 1) / RAYX_FILE_ALIGNMENT * RAYX_FILE_ALIGNMENT; }
+
+/// index of the bit of a single attribute
+int columnIndex(const RayAttrMask flag) { return std::countr_zero(static_cast<RayAttrMaskUnderlying>(flag)); }
+
+/// object ids, that the fixed point columns of a block store bounds for. blocks without fixed point columns store no bounds
+struct BoundsRange {
+    int32_t minObjectId = 0;
+    int32_t numObjects  = 0;
+};
+
+template <typename T>
+constexpr bool isEncodable = std::is_same_v<T, double> || std::is_same_v<T, complex::Complex>;
+
+/// number of floating point values per element. complex values are encoded as real and imaginary part
+template <typename T>
+constexpr int numComponents = std::is_same_v<T, complex::Complex> ? 2 : 1;
+
+template <typename T>
+double component(const T& value, const int c) {
+    if constexpr (numComponents<T> == 2)
+        return c == 0 ? value.real() : value.imag();
+    else
+        return value;
+}
+
+template <typename T>
+T fromComponents(const double* values) {
+    if constexpr (numComponents<T> == 2)
+        return T(values[0], values[1]);
+    else
+        return values[0];
+}
+
+template <typename Code>
+constexpr Code NOT_FINITE_CODE = std::numeric_limits<Code>::max();  // marks values, that are not finite. the other codes are quantized values
+
+template <typename Code>
+constexpr double MAX_QUANTIZED_CODE = static_cast<double>(NOT_FINITE_CODE<Code> - 1);
+
+template <typename T>
+size_t calcColumnSize(const ColumnEncoding encoding, const size_t numEvents, const BoundsRange range) {
+    const auto numValues  = numEvents * numComponents<T>;
+    const auto boundsSize = alignUp(2 * static_cast<size_t>(range.numObjects) * sizeof(double));
+
+    switch (encoding) {
+        case ColumnEncoding::Float32:
+            return alignUp(numValues * sizeof(float));
+        case ColumnEncoding::Fixed32:
+            return boundsSize + alignUp(numValues * sizeof(uint32_t));
+        case ColumnEncoding::Fixed16:
+            return boundsSize + alignUp(numValues * sizeof(uint16_t));
+        default:
+            return alignUp(numEvents * sizeof(T));
+    }
+}
+
+size_t calcBlockSize(const RayAttrMask attr, const OutputEncoding& encoding, const size_t numEvents, const BoundsRange range) {
+    auto blockSize = alignUp(sizeof(BlockHeader));
+
+#define X(type, name, flag) \
+    if (contains(attr, RayAttrMask::flag)) blockSize += calcColumnSize<type>(encoding.of(RayAttrMask::flag), numEvents, range);
+
+    RAYX_X_MACRO_RAY_ATTR
+#undef X
+
+    return blockSize;
+}
+
+void writePadding(std::ostream& os, const size_t size) {
+    const char zeros[RAYX_FILE_ALIGNMENT] = {};
+    os.write(zeros, static_cast<std::streamsize>(alignUp(size) - size));
+}
+
+template <typename T>
+void writeRaw(std::ostream& os, const T* data, const size_t count) {
+    os.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(count * sizeof(T)));
+}
+
+template <typename T>
+void writeColumnRaw(std::ostream& os, const std::vector<T>& column) {
+    writeRaw(os, column.data(), column.size());
+    writePadding(os, column.size() * sizeof(T));
+}
+
+void checkRays(const std::filesystem::path& filepath, const Rays& rays, const RayAttrMask attr) {
+    if (!rays.empty() && !contains(rays.attrMask(), attr))
+        RAYX_EXIT << "Cannot write rays to output file '" << filepath
+                  << "' because the rays do not contain all attributes specified in the attribute mask: " << to_string(attr)
+                  << ". The rays contain the following attributes: " << to_string(rays.attrMask());
+    if (!rays.isValid()) RAYX_EXIT << "Cannot write rays to output file '" << filepath << "' because the attributes have different number of items";
+}
+
+/// bounds are stored per object, if object_id is recorded
+BoundsRange calcBoundsRange(const Rays& rays, const RayAttrMask attr, const OutputEncoding& encoding) {
+    if (!(attr & (encoding.fixed32 | encoding.fixed16))) return {};
+    if (!contains(attr, RayAttrMask::ObjectId)) return {.minObjectId = 0, .numObjects = 1};
+
+    const auto [minObjectId, maxObjectId] = std::ranges::minmax(rays.object_id);
+    return {.minObjectId = minObjectId, .numObjects = maxObjectId - minObjectId + 1};
+}
+
+template <typename T>
+void writeFloat32Column(std::ostream& os, const std::vector<T>& column) {
+    auto values = std::vector<float>(column.size() * numComponents<T>);
+    for (size_t i = 0; i < column.size(); ++i) {
+        for (int c = 0; c < numComponents<T>; ++c) values[i * numComponents<T> + c] = static_cast<float>(component(column[i], c));
+    }
+    writeColumnRaw(os, values);
+}
+
+/// quantizes every value between the minimum and maximum of the finite values of its object
+template <typename Code, typename T>
+void writeFixedColumn(std::ostream& os, const std::vector<T>& column, const int32_t* objectIds, const BoundsRange range) {
+    const auto boundsIndex = [&](const size_t i) { return objectIds == nullptr ? 0 : objectIds[i] - range.minObjectId; };
+
+    auto bounds = std::vector<double>(2 * static_cast<size_t>(range.numObjects));
+    for (int32_t b = 0; b < range.numObjects; ++b) {
+        bounds[2 * b]     = std::numeric_limits<double>::infinity();
+        bounds[2 * b + 1] = -std::numeric_limits<double>::infinity();
+    }
+    for (size_t i = 0; i < column.size(); ++i) {
+        const auto b = boundsIndex(i);
+        for (int c = 0; c < numComponents<T>; ++c) {
+            const auto value = component(column[i], c);
+            if (!std::isfinite(value)) continue;
+            bounds[2 * b]     = std::min(bounds[2 * b], value);
+            bounds[2 * b + 1] = std::max(bounds[2 * b + 1], value);
+        }
+    }
+
+    auto codes = std::vector<Code>(column.size() * numComponents<T>);
+    for (size_t i = 0; i < column.size(); ++i) {
+        const auto b     = boundsIndex(i);
+        const auto lower = bounds[2 * b];
+        const auto width = bounds[2 * b + 1] - lower;
+        for (int c = 0; c < numComponents<T>; ++c) {
+            const auto value = component(column[i], c);
+            auto& code       = codes[i * numComponents<T> + c];
+            if (!std::isfinite(value))
+                code = NOT_FINITE_CODE<Code>;
+            else
+                code = width <= 0.0 ? 0 : static_cast<Code>(std::llround((value - lower) / width * MAX_QUANTIZED_CODE<Code>));
+        }
+    }
+
+    writeColumnRaw(os, bounds);
+    writeColumnRaw(os, codes);
+}
+
+template <typename T>
+void writeColumn(std::ostream& os, const std::vector<T>& column, const ColumnEncoding encoding, const int32_t* objectIds, const BoundsRange range) {
+    if constexpr (isEncodable<T>) {
+        switch (encoding) {
+            case ColumnEncoding::Float32:
+                return writeFloat32Column(os, column);
+            case ColumnEncoding::Fixed32:
+                return writeFixedColumn<uint32_t>(os, column, objectIds, range);
+            case ColumnEncoding::Fixed16:
+                return writeFixedColumn<uint16_t>(os, column, objectIds, range);
+            default:
+                break;
+        }
+    }
+    writeColumnRaw(os, column);
+}
+
+/// @returns the number of bytes written
+size_t writeBlock(std::ostream& os, const Rays& rays, const RayAttrMask attr, const OutputEncoding& encoding) {
+    const auto numEvents = static_cast<size_t>(rays.size());
+    const auto range     = calcBoundsRange(rays, attr, encoding);
+    const auto blockSize = calcBlockSize(attr, encoding, numEvents, range);
+    const auto objectIds = contains(attr, RayAttrMask::ObjectId) ? rays.object_id.data() : nullptr;
+
+    const auto header = BlockHeader{
+        .numEvents       = static_cast<int64_t>(numEvents),
+        .blockSize       = static_cast<int64_t>(blockSize),
+        .minObjectId     = range.minObjectId,
+        .numBoundObjects = range.numObjects,
+    };
+    writeRaw(os, &header, 1);
+    writePadding(os, sizeof(header));
+
+#define X(type, name, flag) \
+    if (contains(attr, RayAttrMask::flag)) writeColumn(os, rays.name, encoding.of(RayAttrMask::flag), objectIds, range);
+
+    RAYX_X_MACRO_RAY_ATTR
+#undef X
+
+    return blockSize;
+}
+
+/// appends the events [begin, end) of a column of a block to dst
+template <typename T>
+void readColumn(std::vector<T>& dst, const char* column, const ColumnEncoding encoding, const int32_t* objectIds, const BoundsRange range,
+                const int begin, const int end) {
+    if constexpr (isEncodable<T>) {
+        if (encoding == ColumnEncoding::Float32) {
+            const auto* values = reinterpret_cast<const float*>(column);
+            for (int i = begin; i < end; ++i) {
+                double components[numComponents<T>];
+                for (int c = 0; c < numComponents<T>; ++c) components[c] = values[i * numComponents<T> + c];
+                dst.push_back(fromComponents<T>(components));
+            }
+            return;
+        }
+
+        if (encoding == ColumnEncoding::Fixed32 || encoding == ColumnEncoding::Fixed16) {
+            const auto* bounds     = reinterpret_cast<const double*>(column);
+            const auto* codes      = column + alignUp(2 * static_cast<size_t>(range.numObjects) * sizeof(double));
+            const auto decodeFixed = [&]<typename Code>(const Code* quantized) {
+                for (int i = begin; i < end; ++i) {
+                    const auto b     = objectIds == nullptr ? 0 : objectIds[i] - range.minObjectId;
+                    const auto lower = bounds[2 * b];
+                    const auto width = bounds[2 * b + 1] - lower;
+                    double components[numComponents<T>];
+                    for (int c = 0; c < numComponents<T>; ++c) {
+                        const auto code = quantized[i * numComponents<T> + c];
+                        components[c]   = code == NOT_FINITE_CODE<Code> ? std::numeric_limits<double>::quiet_NaN()
+                                                                        : lower + (width <= 0.0 ? 0.0 : code / MAX_QUANTIZED_CODE<Code> * width);
+                    }
+                    dst.push_back(fromComponents<T>(components));
+                }
+            };
+
+            if (encoding == ColumnEncoding::Fixed32)
+                decodeFixed(reinterpret_cast<const uint32_t*>(codes));
+            else
+                decodeFixed(reinterpret_cast<const uint16_t*>(codes));
+            return;
+        }
+    }
+
+    const auto* values = reinterpret_cast<const T*>(column);
+    dst.insert(dst.end(), values + begin, values + end);
+}
+
+void checkHeader(const std::filesystem::path& filepath, const FileHeader& header, const size_t fileSize) {
+    if (header.magic != RAYX_FILE_MAGIC)
+        RAYX_EXIT << "error: file " << filepath << " is not a rayx file";
+    if (header.version != RAYX_FILE_VERSION)
+        RAYX_EXIT << "error: unsupported version " << header.version << " of rayx file " << filepath
+                  << ". supported version: " << RAYX_FILE_VERSION;
+    if (header.byteOrderMark != RAYX_BYTE_ORDER_MARK)
+        RAYX_EXIT << "error: rayx file " << filepath << " was written on a machine with another byte order";
+    if (header.firstBlockOffset < static_cast<int64_t>(sizeof(FileHeader)) || header.endOffset < header.firstBlockOffset || header.numBlocks < 0 ||
+        header.numEvents < 0)
+        RAYX_EXIT << "error: header of rayx file " << filepath << " is corrupted";
+    if (fileSize < static_cast<size_t>(header.endOffset)) RAYX_EXIT << "error: rayx file " << filepath << " is truncated";
+    // rays are indexed with int
+    if (header.numEvents > MAX_RAYX_FILE_EVENTS)
+        RAYX_EXIT << "error: rayx file " << filepath << " stores " << header.numEvents << " events, but at most " << MAX_RAYX_FILE_EVENTS
+                  << " events are supported";
+}
+
+/// the encoding of a foreign or corrupted file may contain attributes, that are not encodable, which would disagree on the size of their columns
+OutputEncoding encodingOfHeader(const FileHeader& header) {
+    const auto encoding = OutputEncoding{
+        .float32 = static_cast<RayAttrMask>(header.float32),
+        .fixed32 = static_cast<RayAttrMask>(header.fixed32),
+        .fixed16 = static_cast<RayAttrMask>(header.fixed16),
+    };
+    validateOutputEncoding(encoding);
+    return encoding;
+}
+
+/// fixed point columns are decoded with the bounds of the object of every event, thus the bounds of all objects of the block must be stored
+bool containsBoundsOfObjects(const BoundsRange range, const std::span<const int32_t> objectIds) {
+    if (range.numObjects <= 0) return false;
+    const auto endObjectId = static_cast<int64_t>(range.minObjectId) + range.numObjects;
+    return std::ranges::all_of(objectIds, [&](const int32_t objectId) { return range.minObjectId <= objectId && objectId < endObjectId; });
+}
+
+}  // unnamed namespace
+
+RayAttrMask RaysView::attrMask() const {
+    RayAttrMask mask = RayAttrMask::None;
+#define X(type, name, flag) \
+    if (name.size() != 0) mask |= RayAttrMask::flag;
+    RAYX_X_MACRO_RAY_ATTR
+#undef X
+    return mask;
+}
+
+int RaysView::size() const {
+#define X(type, name, flag) \
+    if (name.size() != 0) return static_cast<int>(name.size());
+    RAYX_X_MACRO_RAY_ATTR
+#undef X
+    return 0;
+}
+
+RayxFile::RayxFile(const std::filesystem::path& filepath) : m_file(std::make_unique<MappedFile>(filepath)) {
+    RAYX_PROFILE_FUNCTION_STDOUT();
+    RAYX_VERB << "open rayx file " << filepath;
+
+    const auto* data = m_file->data();
+    const auto size  = m_file->size();
+
+    auto header = FileHeader{};
+    if (size < sizeof(header)) {
+        RAYX_EXIT << "error: file " << filepath << " is not a rayx file";
+        return;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    checkHeader(filepath, header, size);
+    m_attrMask = static_cast<RayAttrMask>(header.attrMask);
+    m_encoding = encodingOfHeader(header);
+
+    auto offset = sizeof(header);
+    for (uint32_t i = 0; i < header.numObjectNames; ++i) {
+        auto length = uint32_t{0};
+        if (static_cast<size_t>(header.firstBlockOffset) < offset + sizeof(length)) break;
+        std::memcpy(&length, data + offset, sizeof(length));
+        offset += sizeof(length);
+        if (static_cast<size_t>(header.firstBlockOffset) < offset + length) break;
+        m_objectNames.emplace_back(data + offset, length);
+        offset += length;
+    }
+    if (m_objectNames.size() != header.numObjectNames) RAYX_EXIT << "error: object names of rayx file " << filepath << " are truncated";
+
+    // the columns are referenced in place. alignment of the mapping is at least a page, so every column is aligned for its type. columns stored
+    // with reduced precision are decoded by read()
+    offset = static_cast<size_t>(header.firstBlockOffset);
+    for (int64_t i = 0; i < header.numBlocks; ++i) {
+        auto blockHeader = BlockHeader{};
+        if (static_cast<size_t>(header.endOffset) < offset + sizeof(blockHeader)) break;
+        std::memcpy(&blockHeader, data + offset, sizeof(blockHeader));
+
+        const auto numEvents = static_cast<size_t>(blockHeader.numEvents);
+        const auto range     = BoundsRange{.minObjectId = blockHeader.minObjectId, .numObjects = blockHeader.numBoundObjects};
+        if (blockHeader.numEvents < 0 || blockHeader.numEvents > header.numEvents - m_blockOffsets.back() || blockHeader.numBoundObjects < 0 ||
+            static_cast<size_t>(blockHeader.blockSize) != calcBlockSize(m_attrMask, m_encoding, numEvents, range) ||
+            static_cast<size_t>(header.endOffset) < offset + static_cast<size_t>(blockHeader.blockSize))
+            break;
+
+        auto block        = RaysView{};
+        auto columns      = BlockColumns{.minObjectId = range.minObjectId, .numBoundObjects = range.numObjects};
+        auto columnOffset = offset + alignUp(sizeof(blockHeader));
+
+#define X(type, name, flag)                                                                                                                         \
+    if (contains(m_attrMask, RayAttrMask::flag)) {                                                                                                  \
+        const auto encoding = m_encoding.of(RayAttrMask::flag);                                                                                     \
+        columns.data[columnIndex(RayAttrMask::flag)] = data + columnOffset;                                                                         \
+        if (encoding == ColumnEncoding::Float64) block.name = std::span<const type>(reinterpret_cast<const type*>(data + columnOffset), numEvents); \
+        columnOffset += calcColumnSize<type>(encoding, numEvents, range);                                                                           \
+    }
+
+        RAYX_X_MACRO_RAY_ATTR
+#undef X
+
+        if (!!(m_attrMask & (m_encoding.fixed32 | m_encoding.fixed16)) && !containsBoundsOfObjects(range, block.object_id)) break;
+
+        m_blocks.push_back(block);
+        m_blockColumns.push_back(columns);
+        m_blockOffsets.push_back(m_blockOffsets.back() + blockHeader.numEvents);
+        offset += static_cast<size_t>(blockHeader.blockSize);
+    }
+    if (static_cast<int64_t>(m_blocks.size()) != header.numBlocks || m_blockOffsets.back() != header.numEvents)
+        RAYX_EXIT << "error: blocks of rayx file " << filepath << " are corrupted";
+}
+
+RayxFile::~RayxFile() = default;
+
+size_t RayxFile::fileSize() const { return m_file->size(); }
+
+Rays RayxFile::read(const int offset, const int count) const {
+    assert(0 <= offset && 0 <= count && offset + count <= size());
+
+    Rays rays;
+#define X(type, name, flag) \
+    if (contains(m_attrMask, RayAttrMask::flag)) rays.name.reserve(count);
+
+    RAYX_X_MACRO_RAY_ATTR
+#undef X
+
+    for (size_t i = 0; i < m_blocks.size(); ++i) {
+        const auto begin = static_cast<int>(std::max<int64_t>(offset, m_blockOffsets[i]) - m_blockOffsets[i]);
+        const auto end   = static_cast<int>(std::min<int64_t>(offset + count, m_blockOffsets[i + 1]) - m_blockOffsets[i]);
+        if (end <= begin) continue;
+
+        // object_id is never encoded, so it is always part of the view
+        const auto& columns   = m_blockColumns[i];
+        const auto range      = BoundsRange{.minObjectId = columns.minObjectId, .numObjects = columns.numBoundObjects};
+        const auto* objectIds = m_blocks[i].object_id.empty() ? nullptr : m_blocks[i].object_id.data();
+
+#define X(type, name, flag)                      \
+    if (contains(m_attrMask, RayAttrMask::flag)) \
+        readColumn(rays.name, columns.data[columnIndex(RayAttrMask::flag)], m_encoding.of(RayAttrMask::flag), objectIds, range, begin, end);
+
+        RAYX_X_MACRO_RAY_ATTR
+#undef X
+    }
+
+    return rays;
+}
+
+namespace {
+
+class RayxRayListReader : public RayListReader {
+  public:
+    RayxRayListReader(const std::filesystem::path& filepath) : m_file(filepath) {}
+
+    int size() const override { return m_file.size(); }
+    RayAttrMask attrMask() const override { return m_file.attrMask(); }
+
+    Rays read(const int offset, const int count) override { return m_file.read(offset, count); }
+
+  private:
+    RayxFile m_file;
+};
+
+}  // unnamed namespace
+
+Rays readRayx(const std::filesystem::path& filepath) {
+    RAYX_PROFILE_FUNCTION_STDOUT();
+
+    const auto file = RayxFile(filepath);
+    return file.read(0, file.size());
+}
+
+std::vector<std::string> readRayxObjectNames(const std::filesystem::path& filepath) { return RayxFile(filepath).objectNames(); }
+
+std::unique_ptr<RayListReader> createRayxRayListReader(const std::filesystem::path& filepath) {
+    RAYX_VERB << "open ray list in " << filepath;
+    return std::make_unique<RayxRayListReader>(filepath);
+}
+
+void writeRayx(const std::filesystem::path& filepath, const std::vector<std::string>& object_names, const Rays& rays, const RayAttrMask attr,
+               const OutputEncoding& encoding) {
+    RAYX_PROFILE_FUNCTION_STDOUT();
+    RAYX_VERB << "write rays to " << filepath << " with attribute flags: " << to_string(attr);
+
+    checkRays(filepath, rays, attr);
+    validateOutputEncoding(encoding);
+
+    auto namesSize = size_t{0};
+    for (const auto& name : object_names) namesSize += sizeof(uint32_t) + name.size();
+
+    const auto firstBlockOffset = alignUp(sizeof(FileHeader) + namesSize);
+
+    auto header = FileHeader{
+        .magic            = RAYX_FILE_MAGIC,
+        .version          = RAYX_FILE_VERSION,
+        .byteOrderMark    = RAYX_BYTE_ORDER_MARK,
+        .attrMask         = static_cast<RayAttrMaskUnderlying>(attr),
+        .numObjectNames   = static_cast<uint32_t>(object_names.size()),
+        .numEvents        = rays.size(),
+        .numBlocks        = rays.empty() ? 0 : 1,
+        .firstBlockOffset = static_cast<int64_t>(firstBlockOffset),
+        .endOffset        = static_cast<int64_t>(firstBlockOffset),
+        .float32          = static_cast<RayAttrMaskUnderlying>(encoding.float32),
+        .fixed32          = static_cast<RayAttrMaskUnderlying>(encoding.fixed32),
+        .fixed16          = static_cast<RayAttrMaskUnderlying>(encoding.fixed16),
+    };
+
+    auto file = std::ofstream(filepath, std::ios::binary | std::ios::trunc);
+    if (!file) RAYX_EXIT << "Cannot write rays to output file '" << filepath << "' because it cannot be opened";
+
+    writeRaw(file, &header, 1);
+    for (const auto& name : object_names) {
+        const auto length = static_cast<uint32_t>(name.size());
+        writeRaw(file, &length, 1);
+        writeRaw(file, name.data(), name.size());
+    }
+    writePadding(file, sizeof(header) + namesSize);
+
+    // the size of the block is known after the bounds of the fixed point columns are computed
+    if (!rays.empty()) {
+        header.endOffset += static_cast<int64_t>(writeBlock(file, rays, attr, encoding));
+        file.seekp(0);
+        writeRaw(file, &header, 1);
+    }
+
+    if (!file) RAYX_EXIT << "Cannot write rays to output file '" << filepath << "'";
+}
+
+void appendRayx(const std::filesystem::path& filepath, const Rays& rays, const RayAttrMask attr) {
+    RAYX_PROFILE_FUNCTION_STDOUT();
+    RAYX_VERB << "append rays to " << filepath << " with attribute flags: " << to_string(attr);
+
+    if (!std::filesystem::is_regular_file(filepath))
+        RAYX_EXIT << "Cannot append to output file '" << filepath << "' because it does not exist or is not a regular file.";
+
+    checkRays(filepath, rays, attr);
+    if (rays.empty()) return;
+
+    auto file   = std::fstream(filepath, std::ios::in | std::ios::out | std::ios::binary);
+    auto header = FileHeader{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file) {
+        RAYX_EXIT << "error: file " << filepath << " is not a rayx file";
+        return;
+    }
+    checkHeader(filepath, header, std::filesystem::file_size(filepath));
+
+    if (static_cast<RayAttrMask>(header.attrMask) != attr)
+        RAYX_EXIT << "Cannot append to output file '" << filepath << "' because it stores the attributes "
+                  << to_string(static_cast<RayAttrMask>(header.attrMask)) << ", but the appended attributes are: " << to_string(attr);
+    if (header.numEvents + rays.size() > MAX_RAYX_FILE_EVENTS)
+        RAYX_EXIT << "Cannot append to output file '" << filepath << "' because it would exceed the maximum of " << MAX_RAYX_FILE_EVENTS
+                  << " events";
+
+    // anything after the end of the last block is left over from an interrupted append and is overwritten
+    file.seekp(header.endOffset);
+    const auto blockSize = writeBlock(file, rays, attr, encodingOfHeader(header));
+    file.flush();
+
+    header.numEvents += rays.size();
+    header.numBlocks += 1;
+    header.endOffset += static_cast<int64_t>(blockSize);
+    file.seekp(0);
+    writeRaw(file, &header, 1);
+
+    if (!file) RAYX_EXIT << "Cannot append to output file '" << filepath << "'";
+}
+
+}  // namespace RAYX
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "OutputEncoding.h"
+#include "RayListReader.h"
+#include "Rays.h"
+
+namespace RAYX {
+
+class MappedFile;
+
+/// the native .rayx file format stores the ray attributes as raw columns, so that a file is memory mapped and used without parsing or copying.
+/// layout:
+/// - header: magic, version, byte order mark, attribute mask, number of events and blocks, followed by the object names
+/// - blocks: one block per write or append. a block stores the number of its events and one column per attribute of the attribute mask, in the
+///   order of RAYX_X_MACRO_RAY_ATTR. columns are stored exactly or with reduced precision, see OutputEncoding
+/// every block and every column starts at a multiple of RAYX_FILE_ALIGNMENT bytes. numbers are stored in native byte order
+constexpr size_t RAYX_FILE_ALIGNMENT = 64;
+
+/// non-owning view of the columns of rays, e.g. of a block in a memory mapped .rayx file. attributes, that are not contained, are empty
+struct RAYX_API RaysView {
+#define X(type, name, flag) std::span<const type> name;
+
+    RAYX_X_MACRO_RAY_ATTR
+#undef X
+
+    RayAttrMask attrMask() const;
+    int size() const;
+};
+
+/// memory mapped .rayx file. opening a file reads only the header, and the object ids of blocks with fixed point columns to validate their
+/// bounds. the pages of the other columns are loaded by the os on first access
+class RAYX_API RayxFile {
+  public:
+    explicit RayxFile(const std::filesystem::path& filepath);
+    RayxFile(const RayxFile&)            = delete;
+    RayxFile& operator=(const RayxFile&) = delete;
+    ~RayxFile();
+
+    RayAttrMask attrMask() const { return m_attrMask; }
+    const OutputEncoding& encoding() const { return m_encoding; }
+    /// number of events in all blocks. files with more than std::numeric_limits<int>::max() events are rejected, since rays are indexed with int
+    int size() const { return static_cast<int>(m_blockOffsets.back()); }
+    size_t fileSize() const;
+    const std::vector<std::string>& objectNames() const { return m_objectNames; }
+
+    /// views of the columns of each block, in the order they were written. valid as long as the RayxFile lives. attributes stored with reduced
+    /// precision are not contained, since they need to be decoded by read()
+    const std::vector<RaysView>& blocks() const { return m_blocks; }
+
+    /// copies `count` rays starting at `offset` across blocks and decodes attributes stored with reduced precision
+    Rays read(const int offset, const int count) const;
+
+  private:
+    /// start of every column of a block and the bounds of its fixed point columns
+    struct BlockColumns {
+        std::array<const char*, static_cast<size_t>(RayAttrMask::RayAttrMaskCount)> data = {};
+        int32_t minObjectId                                                              = 0;
+        int32_t numBoundObjects                                                          = 0;
+    };
+
+    std::unique_ptr<MappedFile> m_file;
+    RayAttrMask m_attrMask = RayAttrMask::None;
+    OutputEncoding m_encoding;
+    std::vector<std::string> m_objectNames;
+    std::vector<RaysView> m_blocks;
+    std::vector<BlockColumns> m_blockColumns;
+    std::vector<int64_t> m_blockOffsets = {0};  // index of the first event of each block, followed by the total number of events
+};
+
+RAYX_API Rays readRayx(const std::filesystem::path& filepath);
+RAYX_API std::vector<std::string> readRayxObjectNames(const std::filesystem::path& filepath);
+/// creates a reader, that copies slices of the rays in a .rayx file
+RAYX_API std::unique_ptr<RayListReader> createRayxRayListReader(const std::filesystem::path& filepath);
+
+/// creates or overwrites the file. empty rays create a file without blocks, that is appended to. the encoding applies to all blocks of the file
+RAYX_API void writeRayx(const std::filesystem::path& filepath, const std::vector<std::string>& object_names, const Rays& rays,
+                        const RayAttrMask attr = RayAttrMask::All, const OutputEncoding& encoding = OutputEncoding());
+/// appends rays as a new block with the encoding of the file. attr must match the attributes stored in the file. the header is updated after
+/// the block is written, so an interrupted append leaves the file as it was before
+RAYX_API void appendRayx(const std::filesystem::path& filepath, const Rays& rays, const RayAttrMask attr = RayAttrMask::All);
+
+}  // namespace RAYX
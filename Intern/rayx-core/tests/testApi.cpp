@@ -142,6 +142,93 @@ TEST_F(TestSuite, testObjectRecordMask) {
     }
 }
 
+TEST_F(TestSuite, testAdaptiveStopping) {
+    auto beamline = loadBeamline(beamlineFilename);
+    beamline.traverse([](BeamlineNode& node) -> bool {
+        if (node.isSource()) static_cast<DesignSource*>(&node)->setNumberOfRays(10000);
+        return false;
+    });
+
+    const auto attrRecordMask = RayAttrMask::PathId | RayAttrMask::EventType;
+    const auto numRaysTraced  = [&](const AdaptiveStoppingConfig& adaptiveStopping) {
+        auto tracerConfig             = TracerConfig();
+        tracerConfig.adaptiveStopping = adaptiveStopping;
+        auto adaptiveTracer           = Tracer(DeviceConfig().enableBestDevice(), tracerConfig);
+        const auto rays               = adaptiveTracer.trace(beamline, Sequential::No, ObjectMask::all(), attrRecordMask, std::nullopt, 1000);
+
+        // object ids are traced internally to estimate the transmission, but must not show up in the output
+        EXPECT_EQ(rays.attrMask(), attrRecordMask) << to_string(rays.attrMask()) << " != " << to_string(attrRecordMask);
+        return rays.count([&](int i) { return rays.event_type[i] == EventType::Emitted; });
+    };
+
+    // any element that was hit at least once, has a relative error below 1, thus tracing stops after the minimal number of batches
+    EXPECT_EQ(numRaysTraced({.enable = true, .maxRelativeError = 1.0, .minBatches = 3}), 3000);
+
+    // the time budget is exceeded after the first batch
+    EXPECT_EQ(numRaysTraced({.enable = true, .maxDuration = 0.0, .minBatches = 2}), 2000);
+
+    // without criteria, all rays are traced
+    EXPECT_EQ(numRaysTraced({.enable = true}), 10000);
+
+    // the transmission to an element, that no ray reaches, is never estimated, thus tracing must not stop early
+    auto* unreachable = beamline.findElementByName("E2");
+    ASSERT_NE(unreachable, nullptr);
+    unreachable->setPosition(unreachable->getPosition() + glm::dvec4(1e6, 0, 0, 0));
+    EXPECT_EQ(numRaysTraced({.enable = true, .maxRelativeError = 1.0, .minBatches = 3}), 10000);
+}
+
+TEST_F(TestSuite, testFusedRayGeneration) {
+    auto beamline = loadBeamline(beamlineFilename);
+    beamline.traverse([](BeamlineNode& node) -> bool {
+        if (node.isSource()) static_cast<DesignSource*>(&node)->setNumberOfRays(1000);
+        return false;
+    });
+
+    auto tracerConfig  = TracerConfig();
+    auto unfusedTracer = Tracer(DeviceConfig().enableBestDevice(), tracerConfig);
+
+    tracerConfig.fuseRayGeneration = true;
+    auto fusedTracer               = Tracer(DeviceConfig().enableBestDevice(), tracerConfig);
+
+    // generating rays in the tracing threads must not change the result
+    for (const auto sequential : {Sequential::No, Sequential::Yes}) {
+        fixSeed(FIXED_SEED);
+        const auto rays = unfusedTracer.trace(beamline, sequential, ObjectMask::all(), RayAttrMask::All, std::nullopt, 300);
+        fixSeed(FIXED_SEED);
+        const auto fusedRays = fusedTracer.trace(beamline, sequential, ObjectMask::all(), RayAttrMask::All, std::nullopt, 300);
+        compare(fusedRays, rays);
+    }
+}
+
+TEST_F(TestSuite, testChainedTracing) {
+    auto first = loadBeamline(beamlineFilename);
+    first.traverse([](BeamlineNode& node) -> bool {
+        if (node.isSource()) static_cast<DesignSource*>(&node)->setNumberOfRays(1000);
+        return false;
+    });
+    const auto exitObjectId = static_cast<int>(first.numSources() + first.numElements()) - 1;
+
+    // reference: record the rays leaving the first beamline at its last element and emit them from a RayListSource in the second beamline
+    fixSeed(FIXED_SEED);
+    const auto exitEvents = tracer->trace(first, Sequential::No, ObjectMask::byIndices({exitObjectId})).filterByLastEventInPath();
+    auto passedOn         = exitEvents.filter([&](const int i) { return exitEvents.event_type[i] == EventType::HitElement; });
+    const auto numPassed  = passedOn.size();
+    EXPECT_GE(numPassed, 1);
+
+    auto rayListSource = std::make_unique<DesignSource>("testChainedTracing");
+    rayListSource->setType(ElementType::RayListSource);
+    rayListSource->setRayList(std::move(passedOn));
+    rayListSource->setNumberOfRays(numPassed);
+    auto second = loadBeamline("NoSource");
+    second.addChild(std::move(rayListSource));
+    const auto expected = tracer->trace(second).sortByPathIdAndPathEventId();
+
+    // passing the rays on the device must not change the result
+    fixSeed(FIXED_SEED);
+    const auto rays = tracer->traceChained(first, second, ChainConfig(), Sequential::No, ObjectMask::all(), RayAttrMask::All, std::nullopt, 300);
+    compare(rays.sortByPathIdAndPathEventId(), expected);
+}
+
 #ifndef NO_H5
 TEST_F(TestSuite, testH5) {
     const auto [beamline, raysOriginal] = loadBeamlineAndTrace(beamlineFilename);
@@ -165,6 +252,109 @@ TEST_F(TestSuite, testH5) {
         const auto partialRaysOriginal = std::move(raysOriginal.copy().filterByAttrMask(attrMask));
         CHECK_EQ(rays, partialRaysOriginal);
     }
+
+    // chunked and compressed write and read. chunk size does not divide the number of events
+    {
+        const auto options = H5WriteOptions{
+            .chunkSize    = 1000,
+            .deflateLevel = 4,
+            .shuffle      = true,
+        };
+        writeH5(h5Filepath, objectNamesOriginal, raysOriginal, RayAttrMask::All, true, options);
+        const auto rays = readH5Rays(h5Filepath);
+        CHECK_EQ(rays, raysOriginal);
+    }
+
+    // float32 encoding, which is kept when appending. HDF5 converts the values back to double on read
+    {
+        const auto options = H5WriteOptions{
+            .chunkSize = 1000,
+            .encoding  = OutputEncoding{.float32 = RayAttrMask::Position | RayAttrMask::ElectricFieldX},
+        };
+        writeH5(h5Filepath, objectNamesOriginal, Rays(), RayAttrMask::All, true, options);
+        appendH5(h5Filepath, raysOriginal);
+        const auto rays = readH5Rays(h5Filepath);
+
+        auto expected = raysOriginal.copy();
+        for (auto* column : {&expected.position_x, &expected.position_y, &expected.position_z}) {
+            for (auto& value : *column) value = static_cast<float>(value);
+        }
+        for (auto& value : expected.electric_field_x) value = complex::Complex(static_cast<float>(value.real()), static_cast<float>(value.imag()));
+        CHECK_EQ(rays, expected);
+    }
+
+    // normalized layout stores the path attributes once per path. the events are read back grouped by path, also when appending
+    {
+        const auto expected = raysOriginal.sortByPathIdAndPathEventId();
+        const auto options  = H5WriteOptions{.chunkSize = 1000, .layout = H5Layout::Normalized};
+        writeH5(h5Filepath, objectNamesOriginal, raysOriginal, RayAttrMask::All, true, options);
+        CHECK_EQ(readH5Rays(h5Filepath), expected);
+
+        auto reader = createRayListReader(h5Filepath);
+        ASSERT_EQ(reader->size(), expected.size());
+        CHECK_EQ(reader->read(10, 20), expected.filter([](const int i) { return 10 <= i && i < 30; }));
+
+        const auto half  = raysOriginal.size() / 2;
+        const auto first = expected.filter([&](const int i) { return i < half; });
+        const auto last  = expected.filter([&](const int i) { return i >= half; });
+        writeH5(h5Filepath, objectNamesOriginal, first, RayAttrMask::All, true, options);
+        appendH5(h5Filepath, last);
+        CHECK_EQ(readH5Rays(h5Filepath), expected);
+    }
+
+    // append batch by batch on the writer thread, while tracing
+    {
+        const auto maxBatchSize = 300;
+        fixSeed(FIXED_SEED);
+        const auto expected = tracer->trace(beamline, Sequential::No, ObjectMask::all(), RayAttrMask::All, std::nullopt, maxBatchSize);
+
+        writeH5(h5Filepath, objectNamesOriginal, Rays(), RayAttrMask::All, true, H5WriteOptions{.chunkSize = 1000});
+        {
+            auto writer = H5AppendWriter(h5Filepath);
+            fixSeed(FIXED_SEED);
+            tracer->traceBatches(
+                beamline, [&writer](Rays&& rays) { writer.push(std::move(rays)); }, Sequential::No, ObjectMask::all(), RayAttrMask::All,
+                std::nullopt, maxBatchSize);
+        }
+        const auto rays = readH5Rays(h5Filepath);
+        CHECK_EQ(rays, expected);
+    }
+
+    // an error of the writer thread is raised on the thread of the caller, and does not block push. rayx --serve throws from error_fn, to fail
+    // only the current job
+    {
+        const auto brokenFilepath = getBeamlineFilepath(beamlineFilename).replace_extension("testH5Broken.h5");
+        std::ofstream(brokenFilepath) << "not an h5 file";
+
+        error_fn    = [] { throw std::runtime_error(getExitMessage()); };
+        auto writer = std::make_unique<H5AppendWriter>(brokenFilepath, RayAttrMask::All, 1);
+        EXPECT_THROW(
+            {
+                for (int i = 0; i < 4; ++i) writer->push(raysOriginal.copy());
+                writer->finish();
+            },
+            std::runtime_error);
+        // the error was raised already, so the destructor only joins the writer thread
+        writer.reset();
+        error_fn = add_failure;
+    }
+
+    // read selected objects, with and without object index
+    {
+        const auto objectIds  = std::vector<int>{static_cast<int>(beamline.numSources()), static_cast<int>(beamline.numSources() + 2)};
+        const auto attrMask   = RayAttrMask::Position | RayAttrMask::ObjectId | RayAttrMask::PathId | RayAttrMask::PathEventId;
+        const auto isSelected = [&](const int i) { return std::ranges::find(objectIds, raysOriginal.object_id[i]) != objectIds.end(); };
+        auto expected         = raysOriginal.filter(isSelected);
+        expected.filterByAttrMask(attrMask);
+        expected = expected.sortByPathIdAndPathEventId();
+        EXPECT_FALSE(expected.empty());
+
+        writeH5(h5Filepath, objectNamesOriginal, raysOriginal.sortByObjectId());
+        CHECK_EQ(readH5Rays(h5Filepath, objectIds, attrMask).sortByPathIdAndPathEventId(), expected);
+
+        writeH5(h5Filepath, objectNamesOriginal, raysOriginal);
+        CHECK_EQ(readH5Rays(h5Filepath, objectIds, attrMask).sortByPathIdAndPathEventId(), expected);
+    }
 }
 #endif
 
@@ -187,6 +377,153 @@ TEST_F(TestSuite, testCsv) {
         const auto rays = readCsv(csvFilepath);
         CHECK_EQ(rays, partialRaysOriginal);
     }
+
+    // cells are right aligned and doubles are written in the shortest representation, that reads back exactly
+    {
+        auto raysCells       = Rays();
+        raysCells.position_x = {0.1, -2.5e-300, 1.7976931348623157e308};
+        raysCells.object_id  = {0, -2147483647, 2147483647};
+        raysCells.event_type = {EventType::Emitted, EventType::HitElement, EventType::BeyondHorizon};
+        writeCsv(csvFilepath, raysCells);
+
+        auto file  = std::ifstream(csvFilepath);
+        auto lines = std::vector<std::string>();
+        for (std::string line; std::getline(file, line);) lines.push_back(line);
+        ASSERT_EQ(lines.size(), 4u);
+        EXPECT_EQ(lines[1], "                     0.1,          0,      Emitted");
+        EXPECT_EQ(lines[3], " 1.7976931348623157e+308, 2147483647,BeyondHorizon");
+
+        const auto rays = readCsv(csvFilepath);
+        CHECK_EQ(rays, raysCells);
+    }
+
+    // windows line breaks and a missing line break after the last line
+    {
+        auto file = std::ofstream(csvFilepath, std::ios::binary);
+        file << "position_x,object_id,event_type\r\n  0.5,  3,Absorbed\r\n-1e-3,-1,  Emitted";
+        file.close();
+
+        const auto rays = readCsv(csvFilepath);
+        ASSERT_EQ(rays.size(), 2);
+        EXPECT_EQ(rays.position_x, (std::vector<double>{0.5, -1e-3}));
+        EXPECT_EQ(rays.object_id, (std::vector<int32_t>{3, -1}));
+        EXPECT_EQ(rays.event_type, (std::vector<EventType>{EventType::Absorbed, EventType::Emitted}));
+    }
+}
+
+TEST_F(TestSuite, testRayx) {
+    const auto [beamline, raysOriginal] = loadBeamlineAndTrace(beamlineFilename);
+    const auto objectNamesOriginal      = beamline.getObjectNames();
+    const auto rayxFilepath             = getBeamlineFilepath(beamlineFilename).replace_extension("testRayx.rayx");
+
+    // full write and read
+    {
+        writeRayx(rayxFilepath, objectNamesOriginal, raysOriginal);
+        const auto rays = readRayx(rayxFilepath);
+        CHECK_EQ(rays, raysOriginal);
+        const auto objectNames = readRayxObjectNames(rayxFilepath);
+        EXPECT_EQ(objectNames, objectNamesOriginal);
+    }
+
+    // partial write and read
+    {
+        const auto attrMask            = RayAttrMask::Position | RayAttrMask::ObjectId | RayAttrMask::ElectricField;  // just an example
+        const auto partialRaysOriginal = std::move(raysOriginal.copy().filterByAttrMask(attrMask));
+        writeRayx(rayxFilepath, objectNamesOriginal, raysOriginal, attrMask);
+        const auto rays = readRayx(rayxFilepath);
+        CHECK_EQ(rays, partialRaysOriginal);
+    }
+
+    // append in blocks and view the columns of the mapped file
+    {
+        const auto half  = raysOriginal.size() / 2;
+        const auto first = raysOriginal.filter([&](const int i) { return i < half; });
+        const auto last  = raysOriginal.filter([&](const int i) { return i >= half; });
+
+        writeRayx(rayxFilepath, objectNamesOriginal, Rays());
+        appendRayx(rayxFilepath, first);
+        appendRayx(rayxFilepath, last);
+
+        const auto file = RayxFile(rayxFilepath);
+        EXPECT_EQ(file.attrMask(), RayAttrMask::All);
+        ASSERT_EQ(file.size(), raysOriginal.size());
+        ASSERT_EQ(file.blocks().size(), 2u);
+        EXPECT_EQ(file.blocks()[1].size(), raysOriginal.size() - half);
+        EXPECT_EQ(file.blocks()[1].position_x[0], raysOriginal.position_x[half]);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(file.blocks()[1].direction_x.data()) % RAYX_FILE_ALIGNMENT, 0u);
+        CHECK_EQ(file.read(0, file.size()), raysOriginal);
+
+        // slices across the block boundary are read by the ray list reader
+        auto reader     = createRayListReader(rayxFilepath);
+        const auto rays = reader->read(half - 10, 20);
+        CHECK_EQ(rays, raysOriginal.filter([&](const int i) { return half - 10 <= i && i < half + 10; }));
+    }
+
+    // reduced precision encodings are decoded by read. the quantization error of the fixed point encodings is bounded by the range of the values
+    {
+        const auto encoding = OutputEncoding{
+            .float32 = RayAttrMask::ElectricField,
+            .fixed32 = RayAttrMask::Energy,
+            .fixed16 = RayAttrMask::Position,
+        };
+        writeRayx(rayxFilepath, objectNamesOriginal, raysOriginal, RayAttrMask::All, encoding);
+
+        const auto file = RayxFile(rayxFilepath);
+        EXPECT_EQ(file.encoding().fixed16, RayAttrMask::Position);
+        ASSERT_EQ(file.blocks().size(), 1u);
+        EXPECT_TRUE(file.blocks()[0].position_x.empty());
+        EXPECT_EQ(file.blocks()[0].direction_x.size(), raysOriginal.direction_x.size());
+
+        const auto rays = file.read(0, file.size());
+        EXPECT_EQ(rays.path_id, raysOriginal.path_id);
+        EXPECT_EQ(rays.direction_x, raysOriginal.direction_x);
+
+        const auto [minPosition, maxPosition] = std::ranges::minmax(raysOriginal.position_x);
+        const auto [minEnergy, maxEnergy]     = std::ranges::minmax(raysOriginal.energy);
+        auto errorPosition                    = 0.0;
+        auto errorEnergy                      = 0.0;
+        for (int i = 0; i < rays.size(); ++i) {
+            errorPosition = std::max(errorPosition, std::abs(rays.position_x[i] - raysOriginal.position_x[i]));
+            errorEnergy   = std::max(errorEnergy, std::abs(rays.energy[i] - raysOriginal.energy[i]));
+            EXPECT_EQ(rays.electric_field_y[i], complex::Complex(static_cast<float>(raysOriginal.electric_field_y[i].real()),
+                                                                 static_cast<float>(raysOriginal.electric_field_y[i].imag())));
+        }
+        EXPECT_LE(errorPosition, (maxPosition - minPosition) / 65534.0 + 1e-9);
+        EXPECT_LE(errorEnergy, (maxEnergy - minEnergy) / 4294967294.0 + 1e-9);
+    }
+
+    // corrupted headers are rejected, instead of reading past the mapping
+    {
+        const auto expectRejected = [&](const OutputEncoding& encoding, const std::streamoff fieldOffset, const auto value) {
+            writeRayx(rayxFilepath, {}, raysOriginal, RayAttrMask::All, encoding);
+            {
+                auto file = std::fstream(rayxFilepath, std::ios::in | std::ios::out | std::ios::binary);
+                file.seekp(fieldOffset);
+                file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+            }
+            error_fn = [] { throw std::runtime_error(getExitMessage()); };
+            EXPECT_THROW(RayxFile{rayxFilepath}, std::runtime_error) << "field at " << fieldOffset << " = " << value;
+            error_fn = add_failure;
+        };
+
+        // offsets of the fields of the file header, and of the header of the first block of a file without object names
+        const auto numEventsOffset        = 24;
+        const auto numBlocksOffset        = 32;
+        const auto firstBlockOffsetOffset = 40;
+        const auto fixed16Offset          = 64;
+        const auto minObjectIdOffset      = 2 * RAYX_FILE_ALIGNMENT + 16;
+        const auto numBoundObjectsOffset  = 2 * RAYX_FILE_ALIGNMENT + 20;
+        expectRejected({}, firstBlockOffsetOffset, int64_t{-1});
+        expectRejected({}, firstBlockOffsetOffset, int64_t{8});
+        expectRejected({}, numBlocksOffset, int64_t{-1});
+        expectRejected({}, numEventsOffset, int64_t{1} << 31);
+
+        // attributes, that are not encodable, and events of objects without bounds
+        const auto encoding = OutputEncoding{.fixed16 = RayAttrMask::Position};
+        expectRejected(encoding, fixed16Offset, static_cast<uint32_t>(RayAttrMask::Position | RayAttrMask::PathId));
+        expectRejected(encoding, minObjectIdOffset, std::ranges::min(raysOriginal.object_id) + 1);
+        expectRejected(encoding, numBoundObjectsOffset, int32_t{0});
+    }
 }
 
 TEST_F(TestSuite, testBeamlineBijectionBetweenObjectAndObjectId) {
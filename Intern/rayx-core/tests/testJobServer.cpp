@@ -0,0 +1,99 @@
+#include <sstream>
+
+#include "JobServer.h"
+#include "setupTests.h"
+
+TEST_F(TestSuite, testParseJob) {
+    // id echo, single and multiple rml files, args
+    {
+        const auto job = parseJob(R"({"id": 7, "rml": "a.rml", "args": ["-n", "100", "--rayx"]})");
+        EXPECT_EQ(job.id, "7");
+        EXPECT_EQ(job.inputPaths, std::vector<std::string>{"a.rml"});
+        EXPECT_EQ(job.args, (std::vector<std::string>{"-n", "100", "--rayx"}));
+        EXPECT_FALSE(job.shutdown);
+    }
+    {
+        const auto job = parseJob(R"(  { "rml" : [ "a.rml" , "dir" ] , "id" : "job-1" }  )");
+        EXPECT_EQ(job.id, R"("job-1")");
+        EXPECT_EQ(job.inputPaths, (std::vector<std::string>{"a.rml", "dir"}));
+        EXPECT_TRUE(job.args.empty());
+    }
+    EXPECT_EQ(parseJob("{}").id, "null");
+    EXPECT_EQ(parseJob(R"({"id": -1.5e3})").id, "-1.5e3");
+    EXPECT_EQ(parseJob(R"({"id": true})").id, "true");
+    EXPECT_TRUE(parseJob(R"({"command": "shutdown"})").shutdown);
+
+    // escapes and utf-16 surrogate pairs
+    {
+        const auto job = parseJob(R"({"rml": ["a\"b\\c\/d\n\t", "é€😀"]})");
+        EXPECT_EQ(job.inputPaths[0], "a\"b\\c/d\n\t");
+        EXPECT_EQ(job.inputPaths[1], "\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80");
+    }
+    // ids are echoed as json text, so a string id is escaped again
+    EXPECT_EQ(parseJob(R"({"id": "a\"bé"})").id, "\"a\\\"b\xc3\xa9\"");
+
+    // malformed input and unknown keys
+    for (const auto line : {
+             "",
+             "[]",
+             "{",
+             R"({"id": 1,})",
+             R"({"id": 1} trailing)",
+             R"({"id": inf})",
+             R"({"id": nan})",
+             R"({"id": [1]})",
+             R"({"rml": "a.rml)",
+             R"({"rml": ["a.rml", 1]})",
+             R"({"rml": "\x"})",
+             R"({"rml": "\u12"})",
+             R"({"rml": "\ud83d"})",
+             R"({"rml": "\ud83dA"})",
+             R"({"command": "restart"})",
+             R"({"foo": 1})",
+             R"({"rml": {"path": "a.rml"}})",
+         }) {
+        EXPECT_THROW(parseJob(line), std::runtime_error) << line;
+    }
+}
+
+TEST_F(TestSuite, testToJsonString) {
+    EXPECT_EQ(toJsonString(""), R"("")");
+    EXPECT_EQ(toJsonString("/path/to/beamline.h5"), R"("/path/to/beamline.h5")");
+    EXPECT_EQ(toJsonString("a\"b\\c\b\f\n\r\t"), R"("a\"b\\c\b\f\n\r\t")");
+    EXPECT_EQ(toJsonString(std::string("\x01\x1f", 2)), R"("\u0001\u001f")");
+    EXPECT_EQ(toJsonString("\xc3\xa9"), "\"\xc3\xa9\"");
+
+    // escaped strings are read back unchanged
+    const auto str = std::string("\"quoted\" \\ \x01 \n \xf0\x9f\x98\x80");
+    EXPECT_EQ(parseJob("{\"rml\": " + toJsonString(str) + "}").inputPaths[0], str);
+}
+
+TEST_F(TestSuite, testServeStdin) {
+    std::istringstream jobs(R"({"id": 1, "rml": "a.rml"}
+
+{"id": "two", "args": ["-n", "10"]}
+not json
+{"id": 4, "rml": "fail.rml"}
+{"id": 5, "command": "shutdown"}
+{"id": 6, "rml": "never.rml"}
+)");
+    const auto cinBuffer = std::cin.rdbuf(jobs.rdbuf());
+
+    const JobRunner runJob = [](const Job& job) -> std::string {
+        if (!job.inputPaths.empty() && job.inputPaths[0] == "fail.rml") throw std::runtime_error("failed");
+        return R"("status": "ok", "num_args": )" + std::to_string(job.args.size());
+    };
+
+    std::ostringstream responses;
+    serveStdin(runJob, responses);
+    std::cin.rdbuf(cinBuffer);
+
+    // one response per job, that repeats its id. jobs after the shutdown are not run
+    const auto expected = std::string(R"({"id": 1, "status": "ok", "num_args": 0}
+{"id": "two", "status": "ok", "num_args": 2}
+{"id": null, "status": "error", "error": "invalid job at character 0: expected '{'"}
+{"id": 4, "status": "error", "error": "failed"}
+{"id": 5, "status": "shutdown"}
+)");
+    EXPECT_EQ(responses.str(), expected);
+}
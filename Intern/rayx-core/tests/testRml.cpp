@@ -1,3 +1,6 @@
+#include <future>
+#include <set>
+
 #include "setupTests.h"
 
 TEST_F(TestSuite, allBeamlineObjects) {
@@ -8,6 +11,39 @@ TEST_F(TestSuite, allBeamlineObjects) {
     CHECK_EQ(bl.numElements(), 12);
 }
 
+TEST_F(TestSuite, importBeamlinesInParallel) {
+    // rayx -j imports the beamlines of multiple files concurrently
+    const auto expected = loadBeamline("allBeamlineObjects").getObjectNames();
+
+    std::vector<std::future<std::vector<std::string>>> objectNames;
+    for (int i = 0; i < 8; ++i)
+        objectNames.push_back(std::async(std::launch::async, [] { return loadBeamline("allBeamlineObjects").getObjectNames(); }));
+    for (auto& names : objectNames) EXPECT_EQ(names.get(), expected);
+
+    // objects without a name get a unique one, also when they are created on multiple threads
+    const auto createUnnamedObjects = [] {
+        std::vector<std::string> names;
+        for (int i = 0; i < 1000; ++i) {
+            names.push_back(DesignSource().getName());
+            names.push_back(DesignElement().getName());
+            names.push_back(Group().getName());
+        }
+        return names;
+    };
+
+    std::vector<std::future<std::vector<std::string>>> unnamed;
+    for (int i = 0; i < 8; ++i) unnamed.push_back(std::async(std::launch::async, createUnnamedObjects));
+
+    std::set<std::string> uniqueNames;
+    size_t numNames = 0;
+    for (auto& names : unnamed) {
+        const auto threadNames = names.get();
+        uniqueNames.insert(threadNames.begin(), threadNames.end());
+        numNames += threadNames.size();
+    }
+    EXPECT_EQ(uniqueNames.size(), numNames);
+}
+
 TEST_F(TestSuite, loadDatFile) {
     const auto rays = traceRml("loadDatFile", RayAttrMask::Energy);
     writeCsvUsingFilename(rays, "loadDatFile.rayx");
@@ -1,10 +1,15 @@
 #include <gtc/matrix_transform.hpp>
 #include <numeric>
+#include <random>
 
 #include "Shader/ApplySlopeError.h"
 #include "Shader/Approx.h"
+#include "Shader/Collision.h"
 #include "Shader/Crystal.h"
+#include "Shader/Cubic.h"
 #include "Shader/LineDensity.h"
+#include "Shader/MultilayerTable.h"
+#include "Shader/Polynomial.h"
 #include "Shader/Rand.h"
 #include "Shader/Refrac.h"
 #include "Shader/SphericalCoords.h"
@@ -57,6 +62,90 @@ TEST_F(TestSuite, testNormalRandom) {
     CHECK(count > int(0.95 * z_scores.size()))
 }
 
+TEST_F(TestSuite, testScrambledSobol) {
+    constexpr int n     = 1024;
+    constexpr auto seed = 1234u;
+
+    // every dimension is stratified: each interval [k / n, (k + 1) / n) contains exactly one of the first n points
+    for (int d = 0; d < SOBOL_NUM_DIMENSIONS; ++d) {
+        auto strata = std::vector<int>(n, 0);
+        for (int i = 0; i < n; ++i) {
+            const auto x = scrambledSobol(i, d, seed);
+            CHECK_IN(x, 0.0, 1.0);
+            ++strata[static_cast<int>(x * n)];
+        }
+        CHECK(std::all_of(strata.begin(), strata.end(), [](int count) { return count == 1; }));
+    }
+
+    // the first two dimensions form a (0, 2)-sequence: each of the n cells of a 32 x 32 grid contains exactly one point
+    auto cells = std::vector<int>(n, 0);
+    for (int i = 0; i < n; ++i) {
+        const auto x = static_cast<int>(scrambledSobol(i, 0, seed) * 32);
+        const auto y = static_cast<int>(scrambledSobol(i, 1, seed) * 32);
+        ++cells[x * 32 + y];
+    }
+    CHECK(std::all_of(cells.begin(), cells.end(), [](int count) { return count == 1; }));
+
+    // different seeds give different points
+    CHECK(scrambledSobol(7, 3, seed) != scrambledSobol(7, 3, seed + 1));
+
+    // Rand returns the quasi random dimensions first, then continues with the pseudo random counter
+    auto rand = Rand(RandCounter(13));
+    rand.beginQuasiRandom(5, seed);
+    for (int d = 0; d < SOBOL_NUM_DIMENSIONS; ++d) { CHECK_EQ(rand.randomDouble(), scrambledSobol(5, d, seed)); }
+    CHECK(!rand.isQuasiRandom());
+    RandCounter ctr = 13;
+    CHECK_EQ(rand.randomDouble(), squaresDoubleRNG(ctr));
+}
+
+TEST_F(TestSuite, testNormalDistributedPairs) {
+    // one Box-Muller transform of two uniform doubles yields two normal distributed doubles
+    RandCounter ctr = 42;
+    const auto u    = squaresDoubleRNG(ctr);
+    const auto v    = squaresDoubleRNG(ctr);
+    double z0, z1;
+    boxMullerPair(u, v, z0, z1);
+
+    auto rand = Rand(RandCounter(42));
+    CHECK_EQ(rand.randomDoubleNormalDistributed(1.0, 2.0), z0 * 2.0 + 1.0);
+    CHECK_EQ(rand.randomDoubleNormalDistributed(-1.0, 0.5), z1 * 0.5 - 1.0);
+    CHECK(rand.counter == RandCounter(44));
+
+    // the bulk variant yields the same values as successive calls, also if a value is cached
+    auto scalar = Rand(RandCounter(7));
+    auto bulk   = Rand(RandCounter(7));
+    double expected[8];
+    for (int i = 0; i < 8; ++i) { expected[i] = scalar.randomDoubleNormalDistributed(0.0, 1.0); }
+    double odd[3];
+    double even[4];
+    double single[1];
+    bulk.randomDoublesNormalDistributed(odd);
+    bulk.randomDoublesNormalDistributed(even);
+    bulk.randomDoublesNormalDistributed(single);
+    for (int i = 0; i < 3; ++i) { CHECK_EQ(odd[i], expected[i]); }
+    for (int i = 0; i < 4; ++i) { CHECK_EQ(even[i], expected[i + 3]); }
+    CHECK_EQ(single[0], expected[7]);
+    CHECK(bulk.counter == scalar.counter);
+
+    // first and second values of the pairs are standard normal distributed and uncorrelated
+    constexpr int n = 100000;
+    auto sum        = glm::dvec2(0.0);
+    auto sumSquares = glm::dvec2(0.0);
+    auto sumProduct = 0.0;
+    for (int i = 0; i < n; ++i) {
+        double values[2];
+        rand.randomDoublesNormalDistributed(values);
+        sum += glm::dvec2(values[0], values[1]);
+        sumSquares += glm::dvec2(values[0] * values[0], values[1] * values[1]);
+        sumProduct += values[0] * values[1];
+    }
+    CHECK_EQ(sum.x / n, 0.0, 0.02);
+    CHECK_EQ(sum.y / n, 0.0, 0.02);
+    CHECK_EQ(sumSquares.x / n, 1.0, 0.02);
+    CHECK_EQ(sumSquares.y / n, 1.0, 0.02);
+    CHECK_EQ(sumProduct / n, 0.0, 0.02);
+}
+
 TEST_F(TestSuite, testSin) {
     std::vector<double> args = {
         -0.5620816275750421, -0.082699735953560394, -0.73692442452247864, -0.93085577907030514, 0.038832744045494971, 0.86938579245347758,
@@ -1309,6 +1398,205 @@ TEST_F(TestSuite, testRefractiveIndex) {
     CHECK_EQ(getRefractiveIndex(25146.2, 29, mat.indices.data(), mat.materials.data()), glm::dvec2(1.0, 1.0328e-7), 1e-5);
 }
 
+TEST_F(TestSuite, testRefractiveIndexTable) {
+    auto mat = createMaterialTables({Material::Cu, Material::Au});
+
+    const auto config = RefractiveIndexTableConfig{.enable = true};
+    const auto table  = createRefractiveIndexTable(mat, config);
+    const auto view   = table.view();
+
+    CHECK_EQ(table.numSamples, config.numSamples);
+    CHECK(table.rows[static_cast<int>(Material::Cu) - 1] >= 0);
+    CHECK(table.rows[static_cast<int>(Material::Au) - 1] >= 0);
+    CHECK_EQ(table.rows[static_cast<int>(Material::Ag) - 1], -1);
+    CHECK(calcRefractiveIndexTableDeviation(mat, table) < config.tolerance);
+
+    // vacuum
+    CHECK_EQ(getRefractiveIndex(42.0, -1, mat.indices.data(), mat.materials.data(), view), glm::dvec2(1.0, 0.0));
+
+    // on the entries of the tables, the resampled table matches the tables
+    CHECK_EQ(getRefractiveIndex(1.0, 29, mat.indices.data(), mat.materials.data(), view), glm::dvec2(0.433, 8.46), 1e-2);
+    CHECK_EQ(getRefractiveIndex(1.8, 29, mat.indices.data(), mat.materials.data(), view), glm::dvec2(0.213, 4.05), 1e-2);
+    CHECK_EQ(getRefractiveIndex(25146.2, 29, mat.indices.data(), mat.materials.data(), view), glm::dvec2(1.0, 1.0328e-7), 1e-5);
+
+    // energies outside of the grid fall back to the tables
+    const auto outOfRange = 1e6;
+    CHECK_EQ(getRefractiveIndex(outOfRange, 29, mat.indices.data(), mat.materials.data(), view),
+             getRefractiveIndex(outOfRange, 29, mat.indices.data(), mat.materials.data()));
+}
+
+TEST_F(TestSuite, testRefractiveIndexCache) {
+    auto mat = createMaterialTables({Material::Cu, Material::Au});
+
+    const auto table = RefractiveIndexTableData{}.view();
+    auto cache       = RefractiveIndexCache{};
+
+    const auto cu = getRefractiveIndex(1.8, 29, mat.indices.data(), mat.materials.data(), table, cache);
+    CHECK_EQ(cu, glm::dvec2(0.213, 4.05));
+    CHECK_EQ(cache.numEntries, 1);
+
+    // vacuum is not cached
+    CHECK_EQ(getRefractiveIndex(1.8, -1, mat.indices.data(), mat.materials.data(), table, cache), glm::dvec2(1.0, 0.0));
+    CHECK_EQ(cache.numEntries, 1);
+
+    // cached materials are not looked up again
+    cache.iors[0] = complex::Complex(42.0, 42.0);
+    CHECK_EQ(getRefractiveIndex(1.8, 29, mat.indices.data(), mat.materials.data(), table, cache), glm::dvec2(42.0, 42.0));
+
+    const auto au = getRefractiveIndex(1.8, 79, mat.indices.data(), mat.materials.data(), table, cache);
+    CHECK_EQ(au, getRefractiveIndex(1.8, 79, mat.indices.data(), mat.materials.data()));
+    CHECK_EQ(cache.numEntries, 2);
+
+    // a different energy invalidates the cache
+    CHECK_EQ(getRefractiveIndex(1.0, 29, mat.indices.data(), mat.materials.data(), table, cache), glm::dvec2(0.433, 8.46));
+    CHECK_EQ(cache.numEntries, 1);
+}
+
+TEST_F(TestSuite, testMultilayerTable) {
+    auto mat = createMaterialTables({Material::Cu, Material::Au});
+
+    const auto refractiveIndexTable = RefractiveIndexTableData{}.view();
+
+    // more layers than the former fixed-size angle array could hold
+    auto coating       = std::make_unique<Coating::MultilayerCoating>();
+    coating->numLayers = 20;
+    for (int i = 0; i < coating->numLayers; ++i) {
+        coating->material[i]  = i % 2 == 0 ? 29 : 79;
+        coating->thickness[i] = 2.0 + i % 3;
+        coating->roughness[i] = 0.0;
+    }
+
+    const auto calc = [&](const double energy, const double angle) {
+        auto cache = RefractiveIndexCache{};
+        return calcMultilayerReflectance(energy, angle, *coating, 29, mat.indices.data(), mat.materials.data(), refractiveIndexTable, cache);
+    };
+
+    constexpr int numEnergies = 3;
+    constexpr int numAngles   = 5;
+    auto samples              = std::vector<ComplexFresnelCoeffs>();
+    for (int i = 0; i < numEnergies; ++i) {
+        for (int j = 0; j < numAngles; ++j) { samples.push_back(calc(100.0 + 50.0 * i, 1.0 + 0.1 * j)); }
+    }
+
+    const auto table = MultilayerTable{
+        .samples       = samples.data(),
+        .numEnergies   = numEnergies,
+        .numAngles     = numAngles,
+        .energyMin     = 100.0,
+        .invEnergyStep = 1.0 / 50.0,
+        .angleMin      = 1.0,
+        .invAngleStep  = 1.0 / 0.1,
+    };
+
+    // the table reproduces the recursion on the grid points
+    for (int i = 0; i < numEnergies; ++i) {
+        for (int j = 0; j < numAngles; ++j) {
+            const auto expected = calc(100.0 + 50.0 * i, 1.0 + 0.1 * j);
+            const auto actual   = lookupMultilayerReflectance(100.0 + 50.0 * i, 1.0 + 0.1 * j, table);
+            CHECK(actual.has_value());
+            CHECK_EQ(actual->s, expected.s, 1e-12);
+            CHECK_EQ(actual->p, expected.p, 1e-12);
+            CHECK(complex::abs(actual->s) <= 1.0);
+        }
+    }
+
+    // interpolation between grid points
+    const auto mid = lookupMultilayerReflectance(125.0, 1.05, table);
+    CHECK(mid.has_value());
+    CHECK_EQ(mid->s, (samples[0].s + samples[1].s + samples[numAngles].s + samples[numAngles + 1].s) / 4.0, 1e-12);
+
+    // rays outside of the table fall back to the recursion
+    CHECK(!lookupMultilayerReflectance(99.0, 1.2, table).has_value());
+    CHECK(!lookupMultilayerReflectance(150.0, 1.5, table).has_value());
+    CHECK(!lookupMultilayerReflectance(150.0, std::nan(""), table).has_value());
+
+    auto disabled        = table;
+    disabled.numEnergies = 0;
+    CHECK(!lookupMultilayerReflectance(150.0, 1.2, disabled).has_value());
+}
+
+TEST_F(TestSuite, testMultilayerTableSharpPeak) {
+    auto mat = createMaterialTables({Material::Cu, Material::Au});
+
+    const auto refractiveIndexTable = RefractiveIndexTableData{}.view();
+
+    // periodic multilayer with a narrow bragg peak at about 81 degrees of incidence
+    auto coating       = std::make_unique<Coating::MultilayerCoating>();
+    coating->numLayers = 100;
+    for (int i = 0; i < coating->numLayers; ++i) {
+        coating->material[i]  = i % 2 == 0 ? 29 : 79;
+        coating->thickness[i] = 2.0;
+        coating->roughness[i] = 0.0;
+    }
+
+    const auto calc = [&](const double energy, const double angle) {
+        auto cache = RefractiveIndexCache{};
+        return calcMultilayerReflectance(energy, angle, *coating, 29, mat.indices.data(), mat.materials.data(), refractiveIndexTable, cache);
+    };
+
+    constexpr double energyMin = 995.0;
+    constexpr double energyMax = 1005.0;
+    constexpr double angleMin  = 1.38;
+    constexpr double angleMax  = 1.45;
+    constexpr double tolerance = 1e-2;
+
+    // refine the table like the tracer does, until the deviation in the center of every cell is within the tolerance
+    auto samples     = std::vector<ComplexFresnelCoeffs>();
+    auto table       = MultilayerTable{};
+    auto numEnergies = 3;
+    auto numAngles   = 9;
+    for (int refinement = 0; refinement <= 6; ++refinement) {
+        samples.clear();
+        for (int i = 0; i < numEnergies; ++i) {
+            for (int j = 0; j < numAngles; ++j) {
+                const auto energy = energyMin + (energyMax - energyMin) * i / (numEnergies - 1);
+                const auto angle  = angleMin + (angleMax - angleMin) * j / (numAngles - 1);
+                samples.push_back(calc(energy, angle));
+            }
+        }
+        table = MultilayerTable{
+            .samples       = samples.data(),
+            .numEnergies   = numEnergies,
+            .numAngles     = numAngles,
+            .energyMin     = energyMin,
+            .invEnergyStep = (numEnergies - 1) / (energyMax - energyMin),
+            .angleMin      = angleMin,
+            .invAngleStep  = (numAngles - 1) / (angleMax - angleMin),
+        };
+
+        auto deviation = 0.0;
+        for (int cell = 0; cell < (numEnergies - 1) * (numAngles - 1); ++cell) {
+            deviation = std::max(deviation, calcMultilayerTableCellDeviation(cell, table, *coating, 29, mat.indices.data(), mat.materials.data(),
+                                                                             refractiveIndexTable));
+        }
+
+        // the initial grid misses the peak
+        if (refinement == 0) CHECK(deviation > tolerance);
+        if (deviation <= tolerance) break;
+
+        numEnergies = 2 * numEnergies - 1;
+        numAngles   = 2 * numAngles - 1;
+    }
+
+    // the interpolated amplitudes are within the tolerance everywhere, not only in the centers of the cells. the error of bilinear interpolation is
+    // largest in the center of a cell, up to higher orders
+    auto rng      = std::mt19937(42);
+    auto uniform  = std::uniform_real_distribution<double>(0.0, 1.0);
+    auto maxError = 0.0;
+    auto maxPeak  = 0.0;
+    for (int k = 0; k < 10000; ++k) {
+        const auto energy   = energyMin + (energyMax - energyMin) * uniform(rng);
+        const auto angle    = angleMin + (angleMax - angleMin) * uniform(rng);
+        const auto expected = calc(energy, angle);
+        const auto actual   = lookupMultilayerReflectance(energy, angle, table);
+        CHECK(actual.has_value());
+        maxError = std::max({maxError, complex::abs(actual->s - expected.s), complex::abs(actual->p - expected.p)});
+        maxPeak  = std::max(maxPeak, complex::abs(expected.s));
+    }
+    CHECK(maxError <= 2.0 * tolerance);
+    CHECK(maxPeak > 5.0 * tolerance);
+}
+
 TEST_F(TestSuite, testSphericalCoords) {
     std::vector<glm::dvec3> directions = {
         {1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}, {0.0, 0.0, 1.0}, {-1.0, 0.0, 0.0}, {0.0, -1.0, 0.0}, {0.0, 0.0, -1.0},
@@ -1441,3 +1729,387 @@ TEST_F(TestSuite, testComputeEta) {
         CHECK_EQ(eta.imag(), tc.expected.imag());
     }
 }
+
+TEST_F(TestSuite, testSolveQuartic) {
+    struct InOutPair {
+        std::vector<double> expected;
+    };
+
+    std::vector<InOutPair> testCases = {
+        {.expected = {-3.0, 0.5, 1.0, 2.0}},
+        {.expected = {-3.0, -3.0, 1.0, 1.0}},  // double roots
+        {.expected = {-2.0, 1e-3, 2.0, 5.0}},  // biquadratic part
+        {.expected = {-1e-4, 1e-4, 1e3, 2e3}},
+    };
+
+    for (const auto& tc : testCases) {
+        // coefficients of (x - r0)(x - r1)(x - r2)(x - r3)
+        const auto& r = tc.expected;
+        const auto a  = -(r[0] + r[1] + r[2] + r[3]);
+        const auto b  = r[0] * r[1] + r[0] * r[2] + r[0] * r[3] + r[1] * r[2] + r[1] * r[3] + r[2] * r[3];
+        const auto c  = -(r[0] * r[1] * r[2] + r[0] * r[1] * r[3] + r[0] * r[2] * r[3] + r[1] * r[2] * r[3]);
+        const auto d  = r[0] * r[1] * r[2] * r[3];
+
+        double roots[4];
+        const auto numRoots = solveQuartic(a, b, c, d, roots);
+        CHECK_EQ(numRoots, 4);
+        std::sort(roots, roots + numRoots);
+        for (int i = 0; i < numRoots; ++i) CHECK_EQ(roots[i], r[i], 1e-6 * glm::max(1.0, glm::abs(r[i])));
+    }
+
+    // no real roots: (x^2 + 1)(x^2 + 4)
+    double roots[4];
+    CHECK_EQ(solveQuartic(0.0, 5.0, 0.0, 4.0, roots), 0);
+}
+
+TEST_F(TestSuite, testToroidCollision) {
+    const auto longRad  = 10470.4917;
+    const auto shortRad = 315.723959;
+
+    const auto toroid = Surface::Toroid{
+        .m_longRadius  = longRad,
+        .m_shortRadius = shortRad,
+        .m_toroidType  = ToroidType::Concave,
+    };
+
+    // analytic surface height at (x, z) of the concave toroid
+    const auto surfaceY = [&](const double x, const double z) {
+        const auto rx = longRad - shortRad + std::sqrt(shortRad * shortRad - x * x);
+        return longRad - std::sqrt(rx * rx - z * z);
+    };
+
+    // ray hitting the surface perpendicularly
+    {
+        const auto col = getToroidCollision(glm::dvec3(1.0, 50.0, 2.0), glm::dvec3(0.0, -1.0, 0.0), toroid, false);
+        CHECK(col.has_value())
+        CHECK_EQ(col->hitpoint, glm::dvec3(1.0, surfaceY(1.0, 2.0), 2.0), 1e-9);
+    }
+
+    // grazing ray
+    {
+        const auto target   = glm::dvec3(3.0, surfaceY(3.0, 40.0), 40.0);
+        const auto position = glm::dvec3(-2.0, 20.0, -10000.0);
+        const auto col      = getToroidCollision(position, target - position, toroid, false);
+        CHECK(col.has_value())
+        CHECK_EQ(col->hitpoint, target, 1e-7);
+        CHECK(glm::dot(col->normal, glm::dvec3(0.0, 1.0, 0.0)) > 0.99)
+    }
+
+    // ray pointing away from the surface
+    {
+        const auto col = getToroidCollision(glm::dvec3(1.0, 50.0, 2.0), glm::dvec3(0.0, 1.0, 0.0), toroid, false);
+        CHECK(!col.has_value())
+    }
+
+    // ray missing the toroid
+    {
+        const auto col = getToroidCollision(glm::dvec3(1000.0, 50.0, 2.0), glm::dvec3(0.0, -1.0, 0.0), toroid, false);
+        CHECK(!col.has_value())
+    }
+}
+
+TEST_F(TestSuite, testQuadricCollision) {
+    const auto radius = 1000.0;
+
+    // sphere with center (0, radius, 0)
+    const auto sphere = Surface::Quadric{
+        .m_icurv = 1,
+        .m_a11   = 1,
+        .m_a12   = 0,
+        .m_a13   = 0,
+        .m_a14   = 0,
+        .m_a22   = 1,
+        .m_a23   = 0,
+        .m_a24   = -radius,
+        .m_a33   = 1,
+        .m_a34   = 0,
+        .m_a44   = 0,
+    };
+
+    const auto surfaceY = [&](const double x, const double z) { return radius - std::sqrt(radius * radius - x * x - z * z); };
+
+    // ray hitting the surface perpendicularly. the result does not depend on the dominant direction of the ray
+    {
+        const auto col = getQuadricCollision(glm::dvec3(1.0, 50.0, 2.0), glm::dvec3(0.0, -1.0, 0.0), sphere);
+        CHECK(col.has_value())
+        CHECK_EQ(col->hitpoint, glm::dvec3(1.0, surfaceY(1.0, 2.0), 2.0));
+        CHECK_EQ(col->normal, glm::normalize(glm::dvec3(1.0, surfaceY(1.0, 2.0) - radius, 2.0)));
+    }
+
+    // grazing ray from a distant source
+    {
+        const auto target   = glm::dvec3(3.0, surfaceY(3.0, 40.0), 40.0);
+        const auto position = glm::dvec3(-2.0, 20.0, -10000.0);
+        const auto col      = getQuadricCollision(position, glm::normalize(target - position), sphere);
+        CHECK(col.has_value())
+        CHECK_EQ(col->hitpoint, target, 1e-9);
+    }
+
+    // ray pointing away from the surface
+    {
+        const auto col = getQuadricCollision(glm::dvec3(1.0, -50.0, 2.0), glm::dvec3(0.0, -1.0, 0.0), sphere);
+        CHECK(!col.has_value())
+    }
+}
+
+TEST_F(TestSuite, testCubicCollision) {
+    const auto radius = 1000.0;
+
+    auto cubic = Surface::Cubic{
+        .m_a11 = 1,
+        .m_a12 = 0,
+        .m_a13 = 0,
+        .m_a14 = 0,
+        .m_a22 = 1,
+        .m_a23 = 0,
+        .m_a24 = -radius,
+        .m_a33 = 1,
+        .m_a34 = 0,
+        .m_a44 = 0,
+        .m_b12 = 0,
+        .m_b13 = 0,
+        .m_b21 = 0,
+        .m_b23 = 0,
+        .m_b31 = 0,
+        .m_b32 = 0,
+        .m_psi = 0,
+    };
+
+    // without cubic terms, the surface is a sphere
+    {
+        const auto col = getCubicCollision(glm::dvec3(0.0, 50.0, 2.0), glm::dvec3(0.0, -1.0, 0.0), cubic);
+        CHECK(col.has_value())
+        CHECK_EQ(col->hitpoint, glm::dvec3(0.0, radius - std::sqrt(radius * radius - 4.0), 2.0));
+    }
+
+    // with cubic terms, the hitpoint has to lie on the surface
+    cubic.m_b23 = 1e-5;
+    cubic.m_b32 = -2e-5;
+    {
+        const auto position = glm::dvec3(0.0, 20.0, -10000.0);
+        const auto col      = getCubicCollision(position, glm::normalize(glm::dvec3(0.0, -20.0, 10030.0)), cubic);
+        CHECK(col.has_value())
+        const auto p = col->hitpoint;
+        const auto f = p.x * p.x + p.y * p.y + p.z * p.z - 2 * radius * p.y + cubic.m_b23 * p.y * p.y * p.z + cubic.m_b32 * p.y * p.z * p.z;
+        CHECK_EQ(f, 0.0, 1e-9);
+    }
+}
+
+TEST_F(TestSuite, testCollisionRegression) {
+    // steep rays, grazing rays from a distant source along z and grazing rays along x. for the cubic surfaces, the rays lie in the yz plane,
+    // because the cubic collision ignores x
+    const auto makeRays = [](const bool onlyYZ) {
+        std::vector<std::pair<glm::dvec3, glm::dvec3>> rays;
+        for (int k = 0; k < 8; ++k) {
+            const auto position  = glm::dvec3(onlyYZ ? 0.0 : -20.0 + 6.0 * k, 50.0, -30.0 + 8.0 * k);
+            const auto direction = glm::dvec3(onlyYZ ? 0.0 : 0.02 * k, -1.0, 0.01 * k - 0.03);
+            rays.emplace_back(position, glm::normalize(direction));
+        }
+        for (int k = 0; k < 8; ++k) {
+            const auto position = glm::dvec3(onlyYZ ? 0.0 : -2.0, 20.0, -10000.0);
+            const auto target   = glm::dvec3(onlyYZ ? 0.0 : -40.0 + 10.0 * k, -0.5 + 0.5 * k, -200.0 + 55.0 * k);
+            rays.emplace_back(position, glm::normalize(target - position));
+        }
+        for (int k = 0; k < 8; ++k) {
+            const auto position = onlyYZ ? glm::dvec3(0.0, 5.0, -20000.0) : glm::dvec3(-10000.0, 20.0, 5.0);
+            const auto target   = onlyYZ ? glm::dvec3(0.0, 0.1 * k, -300.0 + 80.0 * k)
+                                         : glm::dvec3(-200.0 + 55.0 * k, -0.5 + 0.5 * k, -40.0 + 10.0 * k);
+            rays.emplace_back(position, glm::normalize(target - position));
+        }
+        return rays;
+    };
+
+    const auto MISS = std::optional<glm::dvec3>();
+
+    // hitpoints of the former quadric collision, which solved for the dominant coordinate of the ray
+    const auto quadric = [](const int icurv, const double a11, const double a22, const double a24, const double a33) {
+        return Surface::Quadric{
+            .m_icurv = icurv,
+            .m_a11   = a11,
+            .m_a12   = 0,
+            .m_a13   = 0,
+            .m_a14   = 0,
+            .m_a22   = a22,
+            .m_a23   = 0,
+            .m_a24   = a24,
+            .m_a33   = a33,
+            .m_a34   = 0,
+            .m_a44   = 0,
+        };
+    };
+    const auto quadrics = std::vector<Surface::Quadric>{quadric(1, 1, 1, -1000, 1), quadric(-1, 1, 1, -1000, 0.25), quadric(1, 0, 0, -1, 1e-4)};
+    const auto quadricHits = std::vector<std::optional<glm::dvec3>>{
+        glm::dvec3(-20, 0.69570977811278389, -31.479128706656617),
+        glm::dvec3(-13.006979822957982, 0.3489911478990646, -22.99302017704202),
+        glm::dvec3(-6.0049257717542526, 0.12314429385632429, -14.498768557061437),
+        glm::dvec3(0.99889005629320804, 0.018499061779873316, -6),
+        glm::dvec3(7.9971918178339809, 0.035102277075237318, 2.4996489772292478),
+        glm::dvec3(14.98272820040761, 0.17271799592389678, 10.996545640081521),
+        glm::dvec3(21.948300423880003, 0.43082980099996732, 19.48707510597),
+        glm::dvec3(28.886789685547821, 0.80864510322985417, 27.967654195870807),
+        MISS,
+        MISS,
+        glm::dvec3(-20.188154963979969, 0.29616545568836344, 13.589760724527665),
+        glm::dvec3(-10.060326008096888, 0.85672573076988812, 40.143583835686897),
+        glm::dvec3(0.0067082073817984391, 1.4379490817183658, 53.608118982809593),
+        glm::dvec3(9.9854316880284468, 2.021852467957332, 62.768688073881215),
+        glm::dvec3(19.868260872650879, 2.6047924876640733, 69.340119997881786),
+        glm::dvec3(29.65135969262635, 3.1852151632922516, 74.034327168729831),
+        MISS,
+        MISS,
+        glm::dvec3(13.494656001557868, 0.29635259414426468, -20.261086417763771),
+        glm::dvec3(40.130924266682037, 0.85674986843281764, -10.113092209131986),
+        glm::dvec3(53.608116852578171, 1.4379490856514276, -0.016770517391505584),
+        glm::dvec3(62.76737302720236, 2.0218548174203814, 9.9939292173832257),
+        glm::dvec3(69.328392130773238, 2.6048127480465415, 19.910160501674394),
+        glm::dvec3(74.004438229967803, 3.1852650515552843, 29.727551394771641),
+
+        MISS,
+        MISS,
+        MISS,
+        MISS,
+        MISS,
+        MISS,
+        MISS,
+        MISS,
+        MISS,
+        MISS,
+        glm::dvec3(-20.09088248823646, 0.40154397107716516, -39.964141198704397),
+        glm::dvec3(-9.9542199562346987, 1.10872760394259, -92.024767015153785),
+        glm::dvec3(-0.027636739147757008, 1.7556398371167536, -118.46006313026319),
+        glm::dvec3(9.7481447834910657, 2.3777828247634027, -136.45344219396094),
+        glm::dvec3(19.393200127625626, 2.9826817166614319, -149.40375941601764),
+        glm::dvec3(28.920063477586407, 3.5737162775322209, -158.72354627445188),
+        MISS,
+        MISS,
+        glm::dvec3(-25.375149333694491, 0.37283707487457962, -20.163029391186445),
+        glm::dvec3(-44.850874790970387, 1.0187824005046084, -9.9851717890753093),
+        glm::dvec3(-57.295042961116621, 1.6427104086607445, 0.038570380719120556),
+        glm::dvec3(-66.913050315759406, 2.253541926122447, 9.9295716871882078),
+        glm::dvec3(-74.85080061213003, 2.8538883524888718, 19.696667126438111),
+        glm::dvec3(-81.626624913429495, 3.4450321672585495, 29.345540930502136),
+
+        glm::dvec3(-20, 0.04960781168566402, -31.498511765649429),
+        glm::dvec3(-13.000528975641068, 0.026448782053378753, -22.999471024358932),
+        glm::dvec3(-6.0004204938619523, 0.010512346548807729, -14.499894876534512),
+        glm::dvec3(0.99989200000000045, 0.0018000000000000002, -6),
+        glm::dvec3(7.9999749995538423, 0.00031250557697148901, 2.4999968749442303),
+        glm::dvec3(14.999395013383641, 0.0060498661635932632, 10.999879002676728),
+        glm::dvec3(21.997718633496884, 0.019011387525975143, 19.499429658374222),
+        glm::dvec3(28.994512614509556, 0.0391956106460256, 27.998432175574159),
+        MISS,
+        MISS,
+        glm::dvec3(-20.278008822269278, 0.19882377587494501, 63.059301593808506),
+        glm::dvec3(-10.123535119317257, 0.70660409162151461, 118.87843299955755),
+        glm::dvec3(0.027511068712242272, 1.2455226144117604, 157.83045424833318),
+        glm::dvec3(10.136372676266561, 1.7954409856001612, 189.4962261154644),
+        glm::dvec3(20.188503566117696, 2.3500539814972878, 216.7973238532841),
+        glm::dvec3(30.176247236023194, 2.9063686558626793, 241.09619059050596),
+        glm::dvec3(-474.89268472107545, 0.075030615998167183, -38.737737672199138),
+        glm::dvec3(-167.0580961962749, 0.044765289084272852, -29.921660744102521),
+        glm::dvec3(153.30502957957611, 0.021246410009920058, -20.613786653833444),
+        glm::dvec3(486.42351080269543, 0.00581568437017288, -10.7848823544446),
+        glm::dvec3(832.4326542678574, -4.0957638325345158e-07, -0.40540551610172471),
+        glm::dvec3(1191.3369327071387, 0.0055518820120581402, 10.55401336610776),
+        glm::dvec3(1563.1336326606117, 0.024201523044352413, 22.122112980247699),
+        glm::dvec3(1947.7397456544952, 0.057773620409780069, 34.326803499397386),
+    };
+
+    const auto quadricRays = makeRays(false);
+    for (size_t i = 0; i < quadricHits.size(); ++i) {
+        const auto& [position, direction] = quadricRays[i % quadricRays.size()];
+        const auto col                    = getQuadricCollision(position, direction, quadrics[i / quadricRays.size()]);
+        CHECK(col.has_value() == quadricHits[i].has_value())
+        if (col && quadricHits[i]) CHECK_EQ(col->hitpoint, *quadricHits[i], 1e-4);
+    }
+
+    // hitpoints of the former cubic collision, which did up to 1000 newton steps with a tolerance of 1e-3. for rays that do not hit the surface,
+    // it returned points far off the element (|y| > 1e13) instead of a miss. these are stored as misses
+    auto cubic = Surface::Cubic{
+        .m_a11 = 1,
+        .m_a12 = 0,
+        .m_a13 = 0,
+        .m_a14 = 0,
+        .m_a22 = 1,
+        .m_a23 = 0,
+        .m_a24 = -1000,
+        .m_a33 = 1,
+        .m_a34 = 0,
+        .m_a44 = 0,
+        .m_b12 = 0,
+        .m_b13 = 0,
+        .m_b21 = 0,
+        .m_b23 = 1e-5,
+        .m_b31 = 0,
+        .m_b32 = -2e-5,
+        .m_psi = 0,
+    };
+    const auto psis      = std::vector<double>{0.0, 0.01};
+    const auto cubicHits = std::vector<std::optional<glm::dvec3>>{
+        glm::dvec3(0, 0.49565171142610109, -31.485130448657216),
+        glm::dvec3(0, 0.26437697426538853, -22.994712460514691),
+        glm::dvec3(0, 0.10510954065635879, -14.498948904593437),
+        glm::dvec3(0, 0.017999993520002332, -6),
+        glm::dvec3(0, 0.0031249217569419346, 2.4999687507824304),
+        glm::dvec3(0, 0.060486616604596526, 10.998790267667909),
+        glm::dvec3(0, 0.19001312761501876, 19.494299606171548),
+        glm::dvec3(0, 0.39155839934439068, 27.984337664026224),
+        MISS,
+        MISS,
+        glm::dvec3(0, 0.27662611992332359, 23.519751362042765),
+        glm::dvec3(0, 0.85446236285947386, 41.33066074238571),
+        glm::dvec3(0, 1.4379477125003155, 53.608860580910132),
+        glm::dvec3(0, 2.0204784067195884, 63.537780683340522),
+        glm::dvec3(0, 2.6000798663140041, 72.068054527950778),
+        glm::dvec3(0, 3.1758637882606591, 79.636900974424577),
+        MISS,
+        glm::dvec3(0, 0.043197933074658385, 9.2948742414815655),
+        glm::dvec3(0, 0.1618153267653204, 17.989085508488063),
+        glm::dvec3(0, 0.28027733799790699, 23.674442621646602),
+        glm::dvec3(0, 0.39811249140063354, 28.214765686808811),
+        glm::dvec3(0, 0.51520238961389653, 32.095993057930713),
+        glm::dvec3(0, 0.63149912225717109, 35.533571102337945),
+        glm::dvec3(0, 0.74698060681854439, 38.644861827044863),
+
+        glm::dvec3(0, 0.18091093903019884, -31.49457267182909),
+        glm::dvec3(0, 0.034460797914213442, -22.999310784041718),
+        glm::dvec3(0, -0.039877739229842085, -14.500398777392299),
+        glm::dvec3(0, -0.042000386186826853, -5.9999999999999991),
+        glm::dvec3(0, 0.028122864565918813, 2.4997187713543405),
+        glm::dvec3(0, 0.17044772865028401, 10.996591045426994),
+        glm::dvec3(0, 0.38485574310080417, 19.488454327706975),
+        glm::dvec3(0, 0.67115457353084906, 27.973153817058769),
+        MISS,
+        MISS,
+        glm::dvec3(0, 0.291186239716544, 16.120223815840784),
+        glm::dvec3(0, 0.87054024874654923, 32.898232696866998),
+        glm::dvec3(0, 1.4541595271288432, 44.828191252364434),
+        glm::dvec3(0, 2.0365073805973495, 54.566007804543183),
+        glm::dvec3(0, 2.615796608746539, 62.970305908418069),
+        glm::dvec3(0, 3.1911982766531866, 70.449738369837036),
+        MISS,
+        glm::dvec3(0, 0.044570867639227872, 3.7527016523028216),
+        glm::dvec3(0, 0.16358498177827696, 10.667137892300667),
+        glm::dvec3(0, 0.28214006090073585, 15.771741625213275),
+        glm::dvec3(0, 0.40000055156956621, 19.997599473073524),
+        glm::dvec3(0, 0.51708814340716003, 23.672959447675574),
+        glm::dvec3(0, 0.63336776471164868, 26.963297299598569),
+        glm::dvec3(0, 0.74882328451912161, 29.962850149442026),
+    };
+
+    const auto cubicRays = makeRays(true);
+    for (size_t i = 0; i < cubicHits.size(); ++i) {
+        const auto& [position, direction] = cubicRays[i % cubicRays.size()];
+        cubic.m_psi                       = psis[i / cubicRays.size()];
+        const auto col                    = getCubicCollision(position, direction, cubic);
+        CHECK(col.has_value() == cubicHits[i].has_value())
+        if (!col || !cubicHits[i]) continue;
+
+        // the former hitpoints are only accurate up to the tolerance of the former newton steps
+        CHECK_EQ(col->hitpoint, *cubicHits[i], 2e-3);
+
+        const auto p = cubicPosition(col->hitpoint, cubic.m_psi);
+        const auto f = p.y * p.y + p.z * p.z - 2000 * p.y + cubic.m_b23 * p.y * p.y * p.z + cubic.m_b32 * p.y * p.z * p.z;
+        CHECK_EQ(f, 0.0, 1e-9);
+    }
+}
@@ -1,6 +1,10 @@
+#include <filesystem>
 #include <fstream>
+#include <map>
 
 #include "Shader/LightSources/DipoleSource.h"
+#include "Shader/LightSources/EnergyDistributions/EnergyDistribution.h"
+#include "Shader/LightSources/RayListSource.h"
 #include "setupTests.h"
 
 void checkEnergyDistribution(const Rays& rays, double photonEnergy, double energySpread) {
@@ -215,6 +219,80 @@ TEST_F(TestSuite, testSchwingerDipole) {
     }
 }
 
+TEST_F(TestSuite, testDipoleSamplingTables) {
+    // mean energy and mean vertical angle of rays sampled from the tables and by rejection sampling
+    const auto calcMoments = [](const std::string& rmlFile) {
+        const auto beamline = loadBeamline(rmlFile);
+        auto source         = DipoleSource(*beamline.getSources()[0]);
+
+        constexpr int n     = 4000;
+        const auto generate = [&]() {
+            auto moments = glm::dvec2(0.0);
+            for (int i = 0; i < n; ++i) {
+                auto rand      = Rand(i, n, 0.5);
+                const auto ray = source.genRay(i, 0, rand);
+                CHECK(ray.energy > 0.0);
+                moments += glm::dvec2(ray.energy, std::abs(ray.direction.y)) / static_cast<double>(n);
+            }
+            return moments;
+        };
+
+        const auto rejection = generate();
+
+        const auto tables = source.createSamplingTables();
+        for (int k = 1; k < tables.numQuantiles; ++k) { CHECK(tables.energies[k - 1] <= tables.energies[k]); }
+        source.setSamplingTables(tables.view());
+
+        return std::make_pair(rejection, generate());
+    };
+
+    const auto [rejectionPlain, tabulatedPlain] = calcMoments("dipole_plain");
+    CHECK_EQ(tabulatedPlain, rejectionPlain, 0.05 * rejectionPlain.y);
+
+    // rejection sampling of psi is only exact for the photon energy. compare the energies only
+    const auto [rejectionSpread, tabulatedSpread] = calcMoments("dipole_energySpread");
+    CHECK_EQ(tabulatedSpread.x, rejectionSpread.x, 0.05 * rejectionSpread.x);
+}
+
+TEST_F(TestSuite, testEnergyDistributionListAliasTable) {
+    auto datFile         = DatFile{};
+    datFile.m_Lines      = {{10.0, 1.0}, {11.0, 0.0}, {12.0, 3.0}, {13.0, 4.0}};
+    datFile.m_continuous = false;
+
+    // the alias table reproduces the weights of the lines
+    const auto discrete = createEnergyDistributionList(datFile);
+    auto masses         = std::vector<double>(discrete.size, 0.0);
+    for (int i = 0; i < discrete.size; ++i) {
+        CHECK_IN(discrete.probabilities[i], 0.0, 1.0);
+        masses[i] += discrete.probabilities[i];
+        masses[discrete.aliases[i]] += 1.0 - discrete.probabilities[i];
+    }
+    CHECK_EQ(masses, std::vector<double>({0.5, 0.0, 1.5, 2.0}), 1e-12);
+
+    constexpr int n = 10000;
+    auto counts     = std::map<double, int>();
+    for (int i = 0; i < n; ++i) {
+        auto rand = Rand(i, n, 0.5);
+        ++counts[selectEnergy(discrete.view(), rand)];
+    }
+    CHECK_EQ(counts.count(11.0), 0);
+    CHECK_EQ(counts[13.0] / static_cast<double>(n), 0.5, 0.05);
+
+    // continuous distributions interpolate between the lines
+    datFile.m_continuous  = true;
+    const auto continuous = createEnergyDistributionList(datFile);
+    CHECK_EQ(continuous.size, 3);
+    auto mean = 0.0;
+    for (int i = 0; i < n; ++i) {
+        auto rand         = Rand(i, n, 0.5);
+        const auto energy = selectEnergy(continuous.view(), rand);
+        CHECK_IN(energy, 10.0, 13.0);
+        mean += energy / n;
+    }
+    // mean of the piecewise linear density
+    CHECK_EQ(mean, 66.5 / 5.5, 0.05);
+}
+
 TEST_F(TestSuite, testLightsourceGetters) {
     struct RmlInput {
         std::string rmlFile;
@@ -276,3 +354,41 @@ TEST_F(TestSuite, testRayListSource) {
     auto allAttrExceptPathEventId = exclude(RayAttrMask::All, RayAttrMask::PathEventId);
     compare(rays.filterByObjectId(0), inputRays, allAttrExceptPathEventId, DEFAULT_TOLERANCE);
 }
+
+#ifndef NO_H5
+TEST_F(TestSuite, testRayListSourceFromFile) {
+    // write only some attributes of rays generated from some other source
+    auto matrixSourceBeamline = loadBeamline("MatrixSource");
+    const auto numRays        = static_cast<int>(matrixSourceBeamline.numRayPaths());
+    const auto inputRays      = tracer->trace(matrixSourceBeamline);
+    const auto attrMask       = RayListSource::requiredAttrMask;
+    const auto h5Filepath     = std::filesystem::temp_directory_path() / "MatrixSource.testRayListSourceFromFile.h5";
+    writeH5(h5Filepath, matrixSourceBeamline.getObjectNames(), inputRays, attrMask);
+
+    // create a RayListSource, that streams the rays from the file
+    auto rayListSource = std::make_unique<DesignSource>("testRayListSourceFromFile");
+    rayListSource->setType(ElementType::RayListSource);
+    rayListSource->setRayListFile(h5Filepath);
+    rayListSource->setNumberOfRays(numRays);
+    auto beamline = loadBeamline("NoSource");
+    beamline.addChild(std::move(rayListSource));
+
+    // use several batches, so that the rays are streamed in slices
+    const auto rays = tracer->trace(beamline, Sequential::No, ObjectMask::all(), RayAttrMask::All, std::nullopt, numRays / 3 + 1);
+    EXPECT_EQ(rays.filterByObjectId(2).size(), numRays);
+
+    // stored attributes are taken from the file, missing attributes are set to the defaults of a generated ray. the tracer increments
+    // path_event_id before the emission event is recorded, so it is 0
+    const auto sourceRays = rays.filterByObjectId(0).sortByPathIdAndPathEventId();
+    compare(sourceRays, inputRays, attrMask, DEFAULT_TOLERANCE);
+    for (int i = 0; i < sourceRays.size(); ++i) {
+        EXPECT_EQ(sourceRays.path_id[i], i);
+        EXPECT_EQ(sourceRays.path_event_id[i], 0);
+        EXPECT_EQ(sourceRays.order[i], 0);
+        EXPECT_EQ(sourceRays.optical_path_length[i], 0.0);
+        EXPECT_EQ(sourceRays.event_type[i], EventType::Emitted);
+    }
+
+    std::filesystem::remove(h5Filepath);
+}
+#endif
@@ -1,12 +1,14 @@
 #include "CommandParser.h"
 
 #include <CLI/CLI.hpp>
+#include <array>
 
 #include "Debug/Debug.h"
 #include "Debug/Instrumentor.h"
 #include "Random.h"
 #include "TerminalAppConfig.h"
 #include "Tracer/Tracer.h"
+#include "Writer/H5Writer.h"
 
 namespace {
 
@@ -25,11 +27,13 @@ void getVersion() {
               << TERMINALAPP_VERSION_PATCH << "\n \t GIT: " << GIT_REVISION << "\n \t BUILD: " << BUILD_TIMESTAMP << std::endl;
 };
 
-}  // unnamed namespace
-
-CliArgs parseCliArgs(const int argc, char const* const* const argv) {
-    RAYX_PROFILE_FUNCTION_STDOUT();
+// options, that configure the resident tracer of rayx --serve or run other programs than tracing. they are not accepted in the arguments of a job
+constexpr std::array serverOptions = {
+    "--version", "--dump", "--cpu", "--gpu", "--list-devices", "--device-index", "--verbose", "--benchmark",
+    "--ior-table", "--qmc", "--fused", "--target-error", "--time-budget", "--serve", "--socket",
+};
 
+CliArgs parseArgs(const int argc, char const* const* const argv, const bool isJob) {
     CliArgs args;
     CLI::App app{"Terminal Application for RAYX"};
 
@@ -43,14 +47,25 @@ CliArgs parseCliArgs(const int argc, char const* const* const argv) {
 
     // other programs than tracing
     app.add_flag("-v,--version", args.version, "Show version information")->group(groupPrograms);
-    app.add_option("-D,--dump", args.dump, "Dump the meta data of a file (RML or H5)")->group(groupPrograms);
+    app.add_option("-D,--dump", args.dump, "Dump the meta data of a file (RML, H5 or RAYX)")->group(groupPrograms);
+    app.add_flag("--serve", args.serve,
+                 "Keep the tracer resident and run trace jobs, that are read from stdin as JSON lines, e.g. {\"id\": 1, \"rml\": \"beamline.rml\", "
+                 "\"args\": [\"-n\", \"10000\"]}. A JSON line is written to stdout per job, containing the output files and durations. Other "
+                 "output is printed to stderr. Options of the tracer, like --device-index, are given to rayx --serve, the others to each job")
+        ->group(groupPrograms);
+    app.add_option("--socket", args.socketPath,
+                   "Read the jobs of --serve from clients of a Unix domain socket at this path instead of stdin. The response of a job is written "
+                   "to the client, that sent it")
+        ->group(groupPrograms);
 
     // tracing related options
     app.add_option("-i,--input", args.inputPaths, "Input RML files or directories (recursive search for RML files)");
     app.add_option("-o,--output", args.outputPath,
                    "Output filepath. Can only be used if a single input is provided, that directs to an RML file. Default: put the output file "
                    "next to the RML");
-    app.add_flag("-a,--append", args.append, "Append to existing output file. Default: overwrite existing output file");
+    app.add_flag("-a,--append", args.append,
+                 "Append to existing output file, which must store the same attributes and, for .rayx output, the same encoding. Default: "
+                 "overwrite existing output file");
     app.add_flag("-S,--sequential", args.sequential, "Trace sequentially");
     app.add_option("-s,--seed", args.seed, "Specify a seed to be used for tracing");
     app.add_flag("-f,--default-seed", args.defaultSeed, std::format("Use default seed for tracing: {}", RAYX::FIXED_SEED));
@@ -63,13 +78,46 @@ CliArgs parseCliArgs(const int argc, char const* const* const argv) {
                    "Pick device via device index. Available devices are determined by --cpu and --gpu. Default: the best device will be picked "
                    "automatically. Use --list-devices to see the available devices");
     app.add_flag("-c,--csv", args.csv, "Output stored as csv instead of H5 file");
+    app.add_flag("--rayx", args.rayx,
+                 "Output stored in the native .rayx format instead of H5 file. The attributes are stored as raw columns, that are memory mapped "
+                 "when read");
     app.add_flag("-V,--verbose", args.verbose, "Dump more information");
     app.add_option("-m,--maxevents", args.maxEvents,
                    "Maximum number of events per ray. Default: A multiple of the number of objects to record events for");
     app.add_option("-b,--batch-size", args.batchSize, std::format("Batch size for tracing. Default: {}", RAYX::DEFAULT_BATCH_SIZE));
     app.add_option("-n,--number-of-rays", args.numberOfRays, "Override the number of rays for all sources");
     app.add_flag("-B,--benchmark", args.benchmark, "Dump benchmark durations");
+    app.add_option("--h5-chunk-size", args.h5ChunkSize,
+                   std::format("Number of events per chunk of the datasets in the output H5 file. Default: {}", RAYX::DEFAULT_H5_CHUNK_SIZE));
+    app.add_option("--h5-deflate", args.h5Deflate,
+                   "Compress the datasets in the output H5 file with deflate (gzip) at the given level [0, 9]. Default: 0, no compression")
+        ->check(CLI::Range(0, 9));
+    app.add_flag("--h5-shuffle", args.h5Shuffle,
+                 "Apply the shuffle filter to the datasets in the output H5 file. Improves compression of slowly varying attributes, e.g. path_id "
+                 "or object_id. Use together with --h5-deflate");
+    app.add_flag("--h5-normalized", args.h5Normalized,
+                 "Store path_id, source_id and energy once per path in the output H5 file instead of once per event. The events are grouped by "
+                 "path. Shrinks the output of traces with many events per path. Requires path_id to be recorded");
     app.add_flag("-O,--sort-by-object-id", args.sortByObjectId, "Sort rays by object_id before writing to output file");
+    app.add_option("-j,--jobs", args.jobs,
+                   "Number of RML files in flight, when multiple input files or an input directory is specified. While a file is traced, the "
+                   "beamlines of the next files are loaded and the rays of the previous files are exported on worker threads. Files are traced "
+                   "one after another in input order. Default: 1, one file after another")
+        ->check(CLI::PositiveNumber);
+    app.add_flag("--ior-table", args.iorTable,
+                 "Resample the material tables on a uniform log-energy grid for faster refractive index lookups. Interpolates between table "
+                 "entries instead of picking the next lower one");
+    app.add_flag("--qmc", args.quasiRandom,
+                 "Sample the light sources with a scrambled Sobol sequence (quasi Monte Carlo) instead of pseudo random numbers. Reaches the "
+                 "same accuracy of smooth distributions with fewer rays");
+    app.add_flag("--fused", args.fused,
+                 "Generate each ray in the thread that traces it, instead of storing the generated rays of a batch in memory first");
+    app.add_option("--target-error", args.targetError,
+                   "Stop tracing once the relative standard error of the transmission to every recorded element is below this value. The number "
+                   "of rays of the sources is the upper bound");
+    app.add_option("--time-budget", args.timeBudget,
+                   "Stop tracing after the batch, that exceeds this wall clock time in seconds. The number of rays of the sources is the upper "
+                   "bound");
     app.add_option("-R,--record-indices", args.objectRecordIndices,
                    "Record events only for specific sources / elements. Use --dump to list the objects of a beamline");
 
@@ -79,15 +127,33 @@ CliArgs parseCliArgs(const int argc, char const* const* const argv) {
     app.add_option(
         "-A,--attributes", args.attrRecordMask,
         std::format("Record only specific Ray attributes to the output H5 file. Default: record all attributes. Attributes: {}", formatAttrNamesStr));
+    app.add_option("--float32", args.float32Attrs,
+                   "Store the given floating point attributes as 32 bit floats in the output file, e.g. electric_field_x. Halves their size at a "
+                   "relative precision of about 6e-8");
+    app.add_option("--fixed32", args.fixed32Attrs,
+                   "Store the given floating point attributes as 32 bit fixed point numbers between the minimum and maximum of the events of each "
+                   "object. Requires --rayx");
+    app.add_option("--fixed16", args.fixed16Attrs,
+                   "Store the given floating point attributes as 16 bit fixed point numbers between the minimum and maximum of the events of each "
+                   "object, e.g. position_x for histograms. Requires --rayx");
 
     try {
         app.parse(argc, argv);
     } catch (const CLI::ParseError& e) {
+        if (isJob) {
+            RAYX_EXIT << "error: " << e.what();
+            return {};
+        }
         auto exit_code = app.exit(e);
         std::exit(exit_code);
         return {};
     }
 
+    if (isJob) {
+        for (const auto option : serverOptions)
+            if (app.count(option)) RAYX_EXIT << "error: " << option << " is an option of rayx --serve and cannot be given to a job";
+    }
+
     args.inputPaths.insert(args.inputPaths.end(), inputPaths.begin(), inputPaths.end());
 
     if (args.attrRecordMask.empty()) args.attrRecordMask = formatAttrNames;
@@ -97,6 +163,9 @@ CliArgs parseCliArgs(const int argc, char const* const* const argv) {
         std::exit(0);
     }
 
+    if (args.socketPath && !args.serve) RAYX_EXIT << "error: --socket requires --serve";
+    if (args.serve && !args.inputPaths.empty()) RAYX_EXIT << "error: please do not provide input files to --serve. Send them as jobs instead";
+
     if (args.defaultSeed && args.seed) RAYX_EXIT << "Please do not provide '--default-seed' and '--seed' simultaneously'";
 
     const bool isMoreThanOnePath    = args.inputPaths.size() > 1;
@@ -115,7 +184,31 @@ CliArgs parseCliArgs(const int argc, char const* const* const argv) {
         }
     }
 
+    if (args.csv && args.rayx) RAYX_EXIT << "error: please do not provide '--csv' and '--rayx' simultaneously";
     if (args.append && args.csv) RAYX_EXIT << "error: appending to existing output files is not supported for csv output";
+    if ((args.csv || args.rayx) && (args.h5ChunkSize || args.h5Deflate || args.h5Shuffle || args.h5Normalized))
+        RAYX_EXIT << "error: --h5-chunk-size, --h5-deflate, --h5-shuffle and --h5-normalized are only supported for h5 output";
+    if (args.h5ChunkSize && *args.h5ChunkSize <= 0) RAYX_EXIT << "error: --h5-chunk-size must be positive";
+    if (args.h5Normalized && args.sortByObjectId)
+        RAYX_EXIT << "error: please do not provide '--h5-normalized' and '--sort-by-object-id' simultaneously. Normalized output is sorted by path";
+    if (args.csv && (!args.float32Attrs.empty() || !args.fixed32Attrs.empty() || !args.fixed16Attrs.empty()))
+        RAYX_EXIT << "error: --float32, --fixed32 and --fixed16 are not supported for csv output";
+    if (!args.rayx && (!args.fixed32Attrs.empty() || !args.fixed16Attrs.empty()))
+        RAYX_EXIT << "error: --fixed32 and --fixed16 are only supported for .rayx output. Use --rayx or --float32";
 
     return args;
 }
+
+}  // unnamed namespace
+
+CliArgs parseCliArgs(const int argc, char const* const* const argv) {
+    RAYX_PROFILE_FUNCTION_STDOUT();
+    return parseArgs(argc, argv, false);
+}
+
+CliArgs parseJobArgs(const std::vector<std::string>& jobArgs) {
+    // the parser expects the program name as first argument
+    std::vector<const char*> argv = {"rayx"};
+    for (const auto& arg : jobArgs) argv.push_back(arg.c_str());
+    return parseArgs(static_cast<int>(argv.size()), argv.data(), true);
+}
@@ -6,6 +6,7 @@
 
 struct CliArgs {
     bool csv         = false;  // -c --csv
+    bool rayx        = false;  // --rayx
     bool cpu         = false;  // -x --cpu
     bool gpu         = false;  // -X --gpu
     bool listDevices = false;  // -l --list-devices
@@ -18,6 +19,15 @@ struct CliArgs {
     // TODO: maybe we can use this flag to even sort existing h5 files, that are given as input?
     bool sortByObjectId = false;              // -O --sort-by-object-id
     bool append         = false;              // -a --append
+    bool iorTable       = false;              // --ior-table
+    bool quasiRandom    = false;              // --qmc
+    bool fused          = false;              // --fused
+    bool h5Shuffle      = false;              // --h5-shuffle
+    bool h5Normalized   = false;              // --h5-normalized
+    bool serve          = false;              // --serve
+    std::optional<std::string> socketPath;    // --socket
+    std::optional<double> targetError;        // --target-error
+    std::optional<double> timeBudget;         // --time-budget
     std::optional<int> numberOfRays;          // -n --number-of-rays
     std::optional<int> maxEvents;             // -m --maxevents
     std::optional<std::string> dump;          // -D --dump
@@ -26,8 +36,16 @@ struct CliArgs {
     std::optional<int> seed;                  // -s, --seed
     std::optional<int> batchSize;             // -b --batch-size
     std::optional<int> deviceId;              // -d --device
+    std::optional<int> jobs;                  // -j --jobs
+    std::optional<int> h5ChunkSize;           // --h5-chunk-size
+    std::optional<int> h5Deflate;             // --h5-deflate
     std::vector<int> objectRecordIndices;     // -R --record-indices
     std::vector<std::string> attrRecordMask;  // -A --attributes
+    std::vector<std::string> float32Attrs;    // --float32
+    std::vector<std::string> fixed32Attrs;    // --fixed32
+    std::vector<std::string> fixed16Attrs;    // --fixed16
 };
 
 CliArgs parseCliArgs(const int argc, char const* const* const argv);
+/// parses the cli arguments of a job of rayx --serve. errors are raised with RAYX_EXIT, options of the resident tracer are rejected
+CliArgs parseJobArgs(const std::vector<std::string>& jobArgs);
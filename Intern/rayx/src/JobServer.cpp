@@ -0,0 +1,341 @@
+#include "JobServer.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <csignal>
+#endif
+
+#include "Debug/Debug.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/// reads the flat json objects of jobs. nested objects are not supported
+class JsonReader {
+  public:
+    explicit JsonReader(std::string_view text) : m_text(text) {}
+
+    void skipWhitespace() {
+        while (m_pos < m_text.size() && std::isspace(static_cast<unsigned char>(m_text[m_pos]))) ++m_pos;
+    }
+
+    bool peek(const char c) {
+        skipWhitespace();
+        return m_pos < m_text.size() && m_text[m_pos] == c;
+    }
+
+    bool consume(const char c) {
+        if (!peek(c)) return false;
+        ++m_pos;
+        return true;
+    }
+
+    void expect(const char c) {
+        if (!consume(c)) error(std::string("expected '") + c + "'");
+    }
+
+    void expectEnd() {
+        skipWhitespace();
+        if (m_pos != m_text.size()) error("unexpected characters after the job");
+    }
+
+    std::string readString() {
+        expect('"');
+        std::string str;
+        while (m_pos < m_text.size() && m_text[m_pos] != '"') {
+            const char c = m_text[m_pos++];
+            if (c != '\\') {
+                str += c;
+                continue;
+            }
+            if (m_pos == m_text.size()) break;
+            switch (const char escaped = m_text[m_pos++]) {
+                case '"':
+                case '\\':
+                case '/': str += escaped; break;
+                case 'b': str += '\b'; break;
+                case 'f': str += '\f'; break;
+                case 'n': str += '\n'; break;
+                case 'r': str += '\r'; break;
+                case 't': str += '\t'; break;
+                case 'u': appendUtf8(str, readCodePoint()); break;
+                default: error(std::string("invalid escape sequence '\\") + escaped + "'");
+            }
+        }
+        expectChar('"');
+        return str;
+    }
+
+    std::vector<std::string> readStrings() {
+        std::vector<std::string> strs;
+        expect('[');
+        if (consume(']')) return strs;
+        do {
+            strs.push_back(readString());
+        } while (consume(','));
+        expect(']');
+        return strs;
+    }
+
+    /// reads a string, number, true, false or null and returns its json text
+    std::string readScalar() {
+        if (peek('"')) return toJsonString(readString());
+
+        const auto begin = m_pos;
+        while (m_pos < m_text.size() && (std::isalnum(static_cast<unsigned char>(m_text[m_pos])) || std::strchr("+-.", m_text[m_pos]))) ++m_pos;
+        const auto token = m_text.substr(begin, m_pos - begin);
+        if (token == "true" || token == "false" || token == "null") return std::string(token);
+
+        // from_chars accepts inf and nan, which are not valid json numbers
+        double number;
+        const auto [end, ec] = std::from_chars(token.data(), token.data() + token.size(), number);
+        const auto isNumber  = !token.empty() && (std::isdigit(static_cast<unsigned char>(token[0])) || token[0] == '-');
+        if (!isNumber || ec != std::errc() || end != token.data() + token.size()) error("expected a string, number, true, false or null");
+        return std::string(token);
+    }
+
+  private:
+    [[noreturn]] void error(const std::string& message) const {
+        throw std::runtime_error("invalid job at character " + std::to_string(m_pos) + ": " + message);
+    }
+
+    void expectChar(const char c) {
+        if (m_pos == m_text.size() || m_text[m_pos] != c) error(std::string("expected '") + c + "'");
+        ++m_pos;
+    }
+
+    uint32_t readHex4() {
+        if (m_pos + 4 > m_text.size()) error("incomplete unicode escape sequence");
+        uint32_t value;
+        const auto [end, ec] = std::from_chars(m_text.data() + m_pos, m_text.data() + m_pos + 4, value, 16);
+        if (ec != std::errc() || end != m_text.data() + m_pos + 4) error("invalid unicode escape sequence");
+        m_pos += 4;
+        return value;
+    }
+
+    uint32_t readCodePoint() {
+        const auto high = readHex4();
+        if (high < 0xD800 || high > 0xDBFF) return high;
+
+        // utf-16 surrogate pair
+        if (m_text.substr(m_pos, 2) != "\\u") error("expected the low surrogate of a unicode escape sequence");
+        m_pos += 2;
+        const auto low = readHex4();
+        if (low < 0xDC00 || low > 0xDFFF) error("invalid low surrogate of a unicode escape sequence");
+        return 0x10000 + ((high - 0xD800) << 10) + (low - 0xDC00);
+    }
+
+    static void appendUtf8(std::string& str, const uint32_t codePoint) {
+        if (codePoint < 0x80) {
+            str += static_cast<char>(codePoint);
+        } else if (codePoint < 0x800) {
+            str += static_cast<char>(0xC0 | (codePoint >> 6));
+            str += static_cast<char>(0x80 | (codePoint & 0x3F));
+        } else if (codePoint < 0x10000) {
+            str += static_cast<char>(0xE0 | (codePoint >> 12));
+            str += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            str += static_cast<char>(0x80 | (codePoint & 0x3F));
+        } else {
+            str += static_cast<char>(0xF0 | (codePoint >> 18));
+            str += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+            str += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            str += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+    }
+
+    std::string_view m_text;
+    size_t m_pos = 0;
+};
+
+bool isBlank(std::string_view line) {
+    return std::ranges::all_of(line, [](const char c) { return std::isspace(static_cast<unsigned char>(c)); });
+}
+
+/// runs the job of a line and returns the response. parse errors and exceptions of the job are reported in the response
+std::string handleLine(std::string_view line, const JobRunner& runJob, bool& shutdown) {
+    std::string id = "null";
+    try {
+        const auto job = parseJob(line);
+        id             = job.id;
+
+        if (job.shutdown) {
+            shutdown = true;
+            return "{\"id\": " + id + ", \"status\": \"shutdown\"}";
+        }
+
+        return "{\"id\": " + id + ", " + runJob(job) + "}";
+    } catch (const std::exception& e) { return "{\"id\": " + id + ", \"status\": \"error\", \"error\": " + toJsonString(e.what()) + "}"; }
+}
+
+}  // unnamed namespace
+
+Job parseJob(std::string_view line) {
+    auto reader = JsonReader(line);
+    auto job    = Job{};
+
+    reader.expect('{');
+    if (!reader.consume('}')) {
+        do {
+            const auto key = reader.readString();
+            reader.expect(':');
+
+            if (key == "id") {
+                job.id = reader.readScalar();
+            } else if (key == "rml") {
+                job.inputPaths = reader.peek('[') ? reader.readStrings() : std::vector<std::string>{reader.readString()};
+            } else if (key == "args") {
+                job.args = reader.readStrings();
+            } else if (key == "command") {
+                const auto command = reader.readString();
+                if (command != "shutdown") throw std::runtime_error("unknown command: '" + command + "'. supported commands are: shutdown");
+                job.shutdown = true;
+            } else {
+                throw std::runtime_error("unknown key: '" + key + "'. supported keys are: id, rml, args, command");
+            }
+        } while (reader.consume(','));
+        reader.expect('}');
+    }
+    reader.expectEnd();
+
+    return job;
+}
+
+std::string toJsonString(std::string_view str) {
+    std::string json = "\"";
+    for (const char c : str) {
+        switch (c) {
+            case '"': json += "\\\""; break;
+            case '\\': json += "\\\\"; break;
+            case '\b': json += "\\b"; break;
+            case '\f': json += "\\f"; break;
+            case '\n': json += "\\n"; break;
+            case '\r': json += "\\r"; break;
+            case '\t': json += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[7];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                    json += escaped;
+                } else {
+                    json += c;
+                }
+        }
+    }
+    return json + "\"";
+}
+
+void serveStdin(const JobRunner& runJob, std::ostream& out) {
+    auto shutdown = false;
+    std::string line;
+    while (!shutdown && std::getline(std::cin, line)) {
+        if (isBlank(line)) continue;
+        out << handleLine(line, runJob, shutdown) << std::endl;
+    }
+}
+
+#ifdef _WIN32
+void serveUnixSocket(const fs::path&, const JobRunner&) { RAYX_EXIT << "error: --socket is not supported on windows. Use --serve with stdin"; }
+#else
+void serveUnixSocket(const fs::path& socketPath, const JobRunner& runJob) {
+    auto address        = sockaddr_un{};
+    address.sun_family  = AF_UNIX;
+    const auto pathname = socketPath.string();
+    if (pathname.size() >= sizeof(address.sun_path)) RAYX_EXIT << "error: the socket path is too long: " << socketPath;
+    std::copy(pathname.begin(), pathname.end(), address.sun_path);
+
+    // remove the socket of a previous server, that was not shut down
+    if (fs::is_socket(socketPath)) fs::remove(socketPath);
+
+    const int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) RAYX_EXIT << "error: failed to create socket: " << std::strerror(errno);
+    if (bind(listenFd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0)
+        RAYX_EXIT << "error: failed to bind socket to " << socketPath << ": " << std::strerror(errno);
+    if (listen(listenFd, SOMAXCONN) < 0) RAYX_EXIT << "error: failed to listen on socket " << socketPath << ": " << std::strerror(errno);
+
+    // a client, that disconnects before receiving its response, must not terminate the server
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::cout << "Serving jobs on socket: " << fs::absolute(socketPath) << std::endl;
+
+    struct Client {
+        int fd;
+        std::string received;  // the beginning of the next line
+        bool closed = false;
+    };
+
+    const auto send = [](Client& client, const std::string& response) {
+        for (size_t sent = 0; sent < response.size() && !client.closed;) {
+            const auto n = write(client.fd, response.data() + sent, response.size() - sent);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) client.closed = true;
+            sent += n > 0 ? n : 0;
+        }
+    };
+
+    std::vector<Client> clients;
+    auto shutdown = false;
+    while (!shutdown) {
+        std::vector<pollfd> fds = {pollfd{.fd = listenFd, .events = POLLIN, .revents = 0}};
+        for (const auto& client : clients) fds.push_back(pollfd{.fd = client.fd, .events = POLLIN, .revents = 0});
+
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            RAYX_EXIT << "error: failed to poll socket " << socketPath << ": " << std::strerror(errno);
+        }
+
+        for (size_t i = 0; i < clients.size() && !shutdown; ++i) {
+            auto& client = clients[i];
+            if (!fds[i + 1].revents) continue;
+
+            char buffer[4096];
+            const auto n = read(client.fd, buffer, sizeof(buffer));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                client.closed = true;
+                continue;
+            }
+            client.received.append(buffer, n);
+
+            for (auto end = client.received.find('\n'); end != std::string::npos && !shutdown && !client.closed;
+                 end      = client.received.find('\n')) {
+                const auto line = client.received.substr(0, end);
+                client.received.erase(0, end + 1);
+                if (!isBlank(line)) send(client, handleLine(line, runJob, shutdown) + "\n");
+            }
+
+            if (client.received.size() > MAX_JOB_LINE_SIZE) {
+                const auto error = "the job exceeds " + std::to_string(MAX_JOB_LINE_SIZE) + " bytes without a line break";
+                send(client, "{\"id\": null, \"status\": \"error\", \"error\": " + toJsonString(error) + "}\n");
+                client.closed = true;
+            }
+        }
+
+        if (fds[0].revents & POLLIN) {
+            const int fd = accept(listenFd, nullptr, nullptr);
+            if (fd >= 0) clients.push_back(Client{.fd = fd, .received = {}});
+        }
+
+        for (const auto& client : clients)
+            if (client.closed) close(client.fd);
+        std::erase_if(clients, [](const Client& client) { return client.closed; });
+    }
+
+    for (const auto& client : clients) close(client.fd);
+    close(listenFd);
+    fs::remove(socketPath);
+}
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// a trace job of rayx --serve. jobs are sent as flat json objects, one per line, e.g.
+/// {"id": 7, "rml": "beamline.rml", "args": ["-n", "10000", "--rayx"]}
+/// - id: string or number, that is repeated in the response, so that clients can match responses and jobs. optional
+/// - rml: an rml file or directory, or an array of them. same as --input
+/// - args: array of cli arguments, as given to rayx. options of the resident tracer, e.g. --device-index, are given to rayx --serve instead
+/// - command: "shutdown" stops the server, after the jobs received before are finished
+struct Job {
+    std::string id = "null";  // json text of the id
+    std::vector<std::string> inputPaths;
+    std::vector<std::string> args;
+    bool shutdown = false;
+};
+
+/// maximum length of a job sent to the unix domain socket. a client, that sends a longer line, is disconnected, so that it cannot grow the
+/// memory of the server without bound
+constexpr size_t MAX_JOB_LINE_SIZE = 1 << 20;
+
+/// parses a line. throws std::runtime_error, if the line is not a valid job
+Job parseJob(std::string_view line);
+
+/// quotes and escapes a string for json output
+std::string toJsonString(std::string_view str);
+
+/// runs a job and returns the members of the response, e.g. "status": "ok", "results": [...]. the server adds the id of the job. exceptions
+/// are turned into a response with "status": "error" and the message in "error"
+using JobRunner = std::function<std::string(const Job& job)>;
+
+/// reads jobs from stdin and writes the response of each job as a line to out, until stdin is closed or a shutdown command is received
+void serveStdin(const JobRunner& runJob, std::ostream& out);
+
+/// listens on a unix domain socket. each client sends jobs and receives the responses of its jobs on its connection. the jobs of all clients
+/// are run one after another on the calling thread, in the order they are received, since they share the tracer
+void serveUnixSocket(const std::filesystem::path& socketPath, const JobRunner& runJob);
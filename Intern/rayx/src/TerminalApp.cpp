@@ -6,7 +6,10 @@
 #endif
 
 #include <algorithm>
+#include <deque>
 #include <filesystem>
+#include <format>
+#include <future>
 #include <memory>
 #include <stdexcept>
 #include <vector>
@@ -19,6 +22,7 @@
 #include "Tracer/Tracer.h"
 #include "Writer/CsvWriter.h"
 #include "Writer/H5Writer.h"
+#include "Writer/RayxWriter.h"
 
 namespace fs = std::filesystem;
 
@@ -95,11 +99,97 @@ void dumpH5File(const fs::path& filepath) {
 }
 #endif
 
+void dumpRayxFile(const fs::path& filepath) {
+    std::cout << "reading rayx meta data from: " << filepath << std::endl;
+    const auto file = RAYX::RayxFile(filepath);
+    std::cout << "\tfilesize: " << file.fileSize() << std::endl;
+    std::cout << "\tattributes: " << RAYX::to_string(file.attrMask()) << std::endl;
+    if (!file.encoding().isExact()) {
+        std::cout << "\tfloat32 attributes: " << RAYX::to_string(file.encoding().float32) << std::endl;
+        std::cout << "\tfixed32 attributes: " << RAYX::to_string(file.encoding().fixed32) << std::endl;
+        std::cout << "\tfixed16 attributes: " << RAYX::to_string(file.encoding().fixed16) << std::endl;
+    }
+    std::cout << "\tnumber of events: " << file.size() << std::endl;
+    std::cout << "\tnumber of blocks: " << file.blocks().size() << std::endl;
+
+    const auto& objectNames = file.objectNames();
+    std::cout << "\tobjects (" << objectNames.size() << "):" << std::endl;
+    for (size_t i = 0; i < objectNames.size(); ++i) std::cout << "\t- [" << i << "] '" << objectNames[i] << "'" << std::endl;
+}
+
+RAYX::EventTypeMask collectEventTypes(const RAYX::Rays& rays) {
+    return std::ranges::fold_left(rays.event_type.begin(), rays.event_type.end(), RAYX::EventTypeMask::None,
+                                  [](RAYX::EventTypeMask acc, const RAYX::EventType eventType) { return acc | RAYX::eventTypeToMask(eventType); });
+}
+
+RAYX::OutputEncoding toOutputEncoding(const CliArgs& args) {
+    const auto encoding = RAYX::OutputEncoding{
+        .float32 = RAYX::rayAttrStringsToRayAttrMask(args.float32Attrs),
+        .fixed32 = RAYX::rayAttrStringsToRayAttrMask(args.fixed32Attrs),
+        .fixed16 = RAYX::rayAttrStringsToRayAttrMask(args.fixed16Attrs),
+    };
+    RAYX::validateOutputEncoding(encoding);
+    return encoding;
+}
+
+/// appends keep the encoding of the file, so a different encoding requested on the command line is an error instead of being ignored
+void checkAppendEncoding(const fs::path& filepath, const RAYX::OutputEncoding& encoding) {
+    const auto fileEncoding = RAYX::RayxFile(filepath).encoding();
+    if (fileEncoding.float32 == encoding.float32 && fileEncoding.fixed32 == encoding.fixed32 && fileEncoding.fixed16 == encoding.fixed16) return;
+    RAYX_EXIT << "error: cannot append to rayx file " << filepath << ", because its encoding differs from --float32, --fixed32 and --fixed16. "
+              << "The file stores float32 attributes: " << RAYX::to_string(fileEncoding.float32)
+              << ", fixed32 attributes: " << RAYX::to_string(fileEncoding.fixed32)
+              << ", fixed16 attributes: " << RAYX::to_string(fileEncoding.fixed16);
+}
+
+RAYX::H5WriteOptions toH5WriteOptions(const CliArgs& args) {
+    return RAYX::H5WriteOptions{
+        .chunkSize    = args.h5ChunkSize.value_or(RAYX::DEFAULT_H5_CHUNK_SIZE),
+        .deflateLevel = args.h5Deflate.value_or(0),
+        .shuffle      = args.h5Shuffle,
+        .encoding     = toOutputEncoding(args),
+        .layout       = args.h5Normalized ? RAYX::H5Layout::Normalized : RAYX::H5Layout::Flat,
+    };
+}
+
+void printFinished(const std::chrono::milliseconds elapsed_time, const fs::path& outputFilepath) {
+    using namespace std::chrono;
+    using namespace std::chrono_literals;
+    const auto mins   = duration_cast<minutes>(elapsed_time);
+    const auto secs   = duration_cast<seconds>(elapsed_time % 1min);
+    const auto millis = duration_cast<milliseconds>(elapsed_time % 1s);
+
+    std::cout << "Finished in ";
+    if (mins > 0min) std::cout << mins.count() << "m ";
+    if (secs > 0s) std::cout << secs.count() << "s ";
+    std::cout << millis.count() << "ms.";
+
+    if (outputFilepath.empty())
+        std::cout << " No rays were exported." << std::endl;
+    else
+        std::cout << " Exported rays to: " << fs::absolute(outputFilepath) << std::endl;
+}
+
+void seedRandom(const CliArgs& args) {
+    if (args.defaultSeed) {
+        RAYX::fixSeed(RAYX::FIXED_SEED);
+    } else if (args.seed) {
+        RAYX::fixSeed(*args.seed);
+    } else {
+        RAYX::randomSeed();
+    }
+}
+
 }  // unnamed namespace
 
 TerminalApp::TerminalApp(int argc, char** argv) {
     RAYX_VERB << "TerminalApp created!";
 
+    m_cliArgs = parseCliArgs(argc, argv);
+
+    // --serve writes the responses to stdout. everything else, that is printed to std::cout, goes to stderr
+    if (m_cliArgs.serve && !m_cliArgs.socketPath) m_responses = std::cout.rdbuf(std::cerr.rdbuf());
+
 // This should not be a RAYX_VERB, as it helps a lot to see the git hash
 // if someone opens an issue.
 // This uses std::cout instead of RAYX_LOG to not add the debugging thing [TerminalApp.cpp:..],
@@ -119,63 +209,124 @@ TerminalApp::TerminalApp(int argc, char** argv) {
                      "will make this program run out of memory for larger ray "
                      "numbers!";
     }
-
-    m_cliArgs = parseCliArgs(argc, argv);
 }
 
-TerminalApp::~TerminalApp() { RAYX_VERB << "TerminalApp deleted!"; }
+TerminalApp::~TerminalApp() {
+    RAYX_VERB << "TerminalApp deleted!";
+    if (m_responses) std::cout.rdbuf(m_responses);
+}
 
-int TerminalApp::tracePath(const fs::path& path) {
+void TerminalApp::collectRmlFiles(const fs::path& path, std::vector<fs::path>& rmlFilepaths) {
     if (!fs::exists(path)) { RAYX_EXIT << "Trying to access file or directory " << path << " but it was not found!"; }
 
-    auto rmlCounter = 0;
-
     if (fs::is_directory(path)) {
-        for (const auto& p : fs::directory_iterator(path)) { rmlCounter += tracePath(p.path()); }
+        for (const auto& p : fs::directory_iterator(path)) { collectRmlFiles(p.path(), rmlFilepaths); }
     } else if (path.extension() == ".rml") {
-        traceRmlAndExportRays(path);
-        rmlCounter += 1;
+        rmlFilepaths.push_back(path);
     } else {
         RAYX_VERB << "ignoring non-rml file: '" << path << "'";
     }
-
-    return rmlCounter;
 }
 
-void TerminalApp::traceRmlAndExportRays(const fs::path& inputFilepath) {
-    using namespace std::chrono;
-    const auto start_time = steady_clock::now();
+std::vector<TerminalApp::ProcessedRml> TerminalApp::traceRmlFilesAndExportRays(const std::vector<fs::path>& rmlFilepaths) {
+    using clock = std::chrono::steady_clock;
 
-    std::cout << "Processing: " << inputFilepath << std::endl;
+    struct LoadedBeamline {
+        RAYX::Beamline beamline;
+        clock::time_point startTime;
+    };
 
-    // record mask for attributes. determine which ray attributes should be recorded
-    const auto attrRecordMask = RAYX::rayAttrStringsToRayAttrMask(m_cliArgs.attrRecordMask);
+    struct PendingExport {
+        fs::path inputFilepath;
+        clock::time_point startTime;
+        fs::path outputFilepath;
+        std::future<fs::path> exported;
+    };
 
-    const auto beamline = loadBeamline(inputFilepath);
+    // the tracer occupies the device, so files are traced one after another in input order, which keeps the traces reproducible for a fixed
+    // seed. the beamlines of up to `jobs` next files are loaded, and the rays of up to `jobs - 1` previous files are exported concurrently.
+    // with a single job, the futures are deferred and every file is loaded, traced and exported on this thread
+    const auto jobs   = static_cast<size_t>(m_cliArgs.jobs.value_or(1));
+    const auto policy = jobs > 1 ? std::launch::async : std::launch::deferred;
+
+    std::deque<std::future<LoadedBeamline>> loads;
+    std::deque<PendingExport> exports;
+    std::vector<ProcessedRml> processed;
+    size_t numLaunchedLoads = 0;
+
+    const auto launchLoads = [&] {
+        while (numLaunchedLoads < rmlFilepaths.size() && loads.size() < jobs) {
+            loads.push_back(std::async(policy, [this, filepath = rmlFilepaths[numLaunchedLoads]] {
+                const auto startTime = clock::now();
+                auto beamline        = loadBeamline(filepath);
+                // reads the material tables into the per process cache, so that the tracer does not wait for the files
+                beamline.calcMinimalMaterialTables();
+                return LoadedBeamline{std::move(beamline), startTime};
+            }));
+            ++numLaunchedLoads;
+        }
+    };
 
-    const auto rays = traceBeamline(beamline, attrRecordMask);
+    const auto finishExport = [&] {
+        auto pending = std::move(exports.front());
+        exports.pop_front();
+
+        const auto outputFilepath = pending.exported.get();
+        const auto elapsedTime    = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - pending.startTime);
+        printFinished(elapsedTime, outputFilepath);
+        processed.push_back(ProcessedRml{
+            .inputFilepath  = pending.inputFilepath,
+            .outputFilepath = outputFilepath,
+            .elapsedTime    = elapsedTime,
+        });
+    };
 
-    const auto objectNames    = beamline.getObjectNames();
-    const auto outputFilepath = exportRays(inputFilepath, objectNames, rays, attrRecordMask);
+    for (const auto& inputFilepath : rmlFilepaths) {
+        std::cout << "Processing: " << inputFilepath << std::endl;
 
-    // print elapsed time and output filepath
+        launchLoads();
+        auto loaded = loads.front().get();
+        loads.pop_front();
+        launchLoads();
 
-    using namespace std::chrono_literals;
-    const auto end_time     = steady_clock::now();
-    const auto elapsed_time = duration_cast<milliseconds>(end_time - start_time);
-    const auto mins         = duration_cast<minutes>(elapsed_time);
-    const auto secs         = duration_cast<seconds>(elapsed_time % 1min);
-    const auto millis       = duration_cast<milliseconds>(elapsed_time % 1s);
+        // input files of the same name in different directories share an output file, which is written in input order
+        const auto outputFilepath = getOutputFilepath(inputFilepath);
+        while (std::ranges::any_of(exports, [&](const PendingExport& pending) { return pending.outputFilepath == outputFilepath; })) finishExport();
 
-    std::cout << "Finished in ";
-    if (mins > 0min) std::cout << mins.count() << "m ";
-    if (secs > 0s) std::cout << secs.count() << "s ";
-    std::cout << millis.count() << "ms.";
+        exports.push_back(PendingExport{
+            .inputFilepath  = inputFilepath,
+            .startTime      = loaded.startTime,
+            .outputFilepath = outputFilepath,
+            .exported       = traceAndExportRays(inputFilepath, loaded.beamline, policy),
+        });
 
-    if (outputFilepath.empty())
-        std::cout << " No rays were exported." << std::endl;
-    else
-        std::cout << " Exported rays to: " << fs::absolute(outputFilepath) << std::endl;
+        while (exports.size() >= jobs) finishExport();
+    }
+
+    while (!exports.empty()) finishExport();
+    return processed;
+}
+
+std::future<fs::path> TerminalApp::traceAndExportRays(const fs::path& inputFilepath, const RAYX::Beamline& beamline, const std::launch policy) {
+    // record mask for attributes. determine which ray attributes should be recorded
+    const auto attrRecordMask = RAYX::rayAttrStringsToRayAttrMask(m_cliArgs.attrRecordMask);
+
+    // h5 and rayx output is written batch by batch while tracing. sorting by object_id requires all events, so they are exported at once
+    const auto writeBatches = !m_cliArgs.csv && !m_cliArgs.sortByObjectId;
+
+    if (writeBatches && m_cliArgs.rayx) {
+        auto written = std::promise<fs::path>();
+        written.set_value(traceBeamlineAndWriteRayx(inputFilepath, beamline, attrRecordMask));
+        return written.get_future();
+    }
+
+    if (writeBatches) return traceBeamlineAndWriteH5(inputFilepath, beamline, attrRecordMask, policy);
+
+    // the rays are moved to the export, so that the next file is traced while they are written
+    auto rays = traceBeamline(beamline, attrRecordMask);
+    return std::async(policy, [this, inputFilepath, objectNames = beamline.getObjectNames(), rays = std::move(rays), attrRecordMask] {
+        return exportRays(inputFilepath, objectNames, rays, attrRecordMask);
+    });
 }
 
 RAYX::Beamline TerminalApp::loadBeamline(const fs::path& filepath) {
@@ -197,7 +348,7 @@ RAYX::Beamline TerminalApp::loadBeamline(const fs::path& filepath) {
     return beamline;
 }
 
-RAYX::Rays TerminalApp::traceBeamline(const RAYX::Beamline& beamline, const RAYX::RayAttrMask attrRecordMask) {
+RAYX::Rays TerminalApp::traceBeamline(const RAYX::Beamline& beamline, const RAYX::RayAttrMask attrRecordMask, const RAYX::BatchCallback& onBatch) {
     RAYX_PROFILE_FUNCTION_STDOUT();
 
     // dump beamline objects
@@ -234,6 +385,21 @@ RAYX::Rays TerminalApp::traceBeamline(const RAYX::Beamline& beamline, const RAYX
     // in order to validate the events later, we always want to get the event types
     const auto attrRecordMaskTrace = attrRecordMask | RAYX::RayAttrMask::EventType;
 
+    if (onBatch) {
+        // validate and pass on the events of each batch. sorting is not possible here, since it requires the events of all batches
+        auto eventTypes = RAYX::EventTypeMask::None;
+
+        const auto validateAndPass = [&](RAYX::Rays&& rays) {
+            eventTypes |= collectEventTypes(rays);
+            rays.filterByAttrMask(attrRecordMask);
+            onBatch(std::move(rays));
+        };
+
+        m_tracer->traceBatches(beamline, validateAndPass, sequential, objectRecordMask, attrRecordMaskTrace, maxEvents, maxBatchSize);
+        validateEvents(eventTypes);
+        return {};
+    }
+
     // do the trace
     auto rays = m_tracer->trace(beamline, sequential, objectRecordMask, attrRecordMaskTrace, maxEvents, maxBatchSize);
 
@@ -245,7 +411,7 @@ RAYX::Rays TerminalApp::traceBeamline(const RAYX::Beamline& beamline, const RAYX
     }
 
     // validate using recorded attribute: event type
-    validateEvents(rays);
+    validateEvents(collectEventTypes(rays));
 
     // return to the user-specified attribute record mask
     rays.filterByAttrMask(attrRecordMask);
@@ -253,13 +419,7 @@ RAYX::Rays TerminalApp::traceBeamline(const RAYX::Beamline& beamline, const RAYX
     return rays;
 }
 
-void TerminalApp::validateEvents(const RAYX::Rays& rays) {
-    RAYX_PROFILE_FUNCTION_STDOUT();
-
-    const auto eventTypes =
-        std::ranges::fold_left(rays.event_type.begin(), rays.event_type.end(), RAYX::EventTypeMask::None,
-                               [](RAYX::EventTypeMask acc, const RAYX::EventType eventType) { return acc | RAYX::eventTypeToMask(eventType); });
-
+void TerminalApp::validateEvents(const RAYX::EventTypeMask eventTypes) {
     if (!!(eventTypes & RAYX::EventTypeMask::Uninitialized)) std::cout << "warning: one or more events in output are uninitialized" << std::endl;
     if (!!(eventTypes & RAYX::EventTypeMask::FatalError)) std::cout << "warning: fatal error detected for one or more events" << std::endl;
     if (!!(eventTypes & RAYX::EventTypeMask::BeyondHorizon))
@@ -284,21 +444,17 @@ void TerminalApp::run() {
 #else
             RAYX_EXIT << "error: unable to dump h5 file due to hdf5 was disabled during build.";
 #endif
+        else if (filetype == ".rayx")
+            dumpRayxFile(filepath);
         else
-            RAYX_EXIT << "error: unable to dump file '" << filename << "', unknown filetype. supported filetypes are h5 and rml";
+            RAYX_EXIT << "error: unable to dump file '" << filename << "', unknown filetype. supported filetypes are h5, rayx and rml";
 
         return;
     }
 
     if (m_cliArgs.verbose) { RAYX::setDebugVerbose(true); }
 
-    if (m_cliArgs.defaultSeed) {
-        RAYX::fixSeed(RAYX::FIXED_SEED);
-    } else if (m_cliArgs.seed) {
-        RAYX::fixSeed(*m_cliArgs.seed);
-    } else {
-        RAYX::randomSeed();
-    }
+    seedRandom(m_cliArgs);
 
     if (m_cliArgs.benchmark) {
         RAYX_VERB << "Starting in Benchmark Mode.\n";
@@ -326,23 +482,81 @@ void TerminalApp::run() {
             return RAYX::DeviceConfig(deviceType).enableBestDevice();
         }
     };
-    m_tracer = std::make_unique<RAYX::Tracer>(getDevice());
+    auto tracerConfig                              = RAYX::TracerConfig();
+    tracerConfig.refractiveIndexTable.enable       = m_cliArgs.iorTable;
+    tracerConfig.sourceSampling                    = m_cliArgs.quasiRandom ? RAYX::SamplingMode::QuasiRandom : RAYX::SamplingMode::PseudoRandom;
+    tracerConfig.adaptiveStopping.enable           = m_cliArgs.targetError || m_cliArgs.timeBudget;
+    tracerConfig.adaptiveStopping.maxRelativeError = m_cliArgs.targetError;
+    tracerConfig.adaptiveStopping.maxDuration      = m_cliArgs.timeBudget;
+    tracerConfig.fuseRayGeneration                 = m_cliArgs.fused;
+
+    m_tracer = std::make_unique<RAYX::Tracer>(getDevice(), tracerConfig);
+
+    if (m_cliArgs.serve) {
+        serve();
+        return;
+    }
 
     if (!m_cliArgs.inputPaths.size()) RAYX_EXIT << "Please provide an input RML file or directory. Use --help for more information";
 
     // trace and export
-    auto rmlCounter = 0;
-    for (const auto path : m_cliArgs.inputPaths) rmlCounter += tracePath(path);
+    std::vector<fs::path> rmlFilepaths;
+    for (const auto& path : m_cliArgs.inputPaths) collectRmlFiles(path, rmlFilepaths);
+    traceRmlFilesAndExportRays(rmlFilepaths);
 
-    std::cout << "Done. Processed " << rmlCounter << " RML file(s)" << std::endl;
+    std::cout << "Done. Processed " << rmlFilepaths.size() << " RML file(s)" << std::endl;
 }
 
-fs::path TerminalApp::exportRays(const fs::path& inputFilepath, const std::vector<std::string>& objectNames, const RAYX::Rays& rays,
-                                 const RAYX::RayAttrMask attrRecordMask) {
-    RAYX_PROFILE_FUNCTION_STDOUT();
+void TerminalApp::serve() {
+    // a fatal error fails the current job, instead of terminating the server
+    RAYX::error_fn = [] { throw std::runtime_error(RAYX::getExitMessage()); };
 
-    if (rays.empty()) return {};
+    const JobRunner runner = [this](const Job& job) { return runJob(job); };
+
+    if (m_cliArgs.socketPath) {
+        serveUnixSocket(*m_cliArgs.socketPath, runner);
+    } else {
+        std::cout << "Serving jobs from stdin" << std::endl;
+        std::ostream responses(m_responses);
+        serveStdin(runner, responses);
+    }
+
+    std::cout << "Done. Server shut down" << std::endl;
+}
 
+std::string TerminalApp::runJob(const Job& job) {
+    const auto startTime = std::chrono::steady_clock::now();
+
+    // the rml files of the job are passed as --input, so that they are validated together with the other arguments
+    std::vector<std::string> jobArgs;
+    for (const auto& inputPath : job.inputPaths) {
+        jobArgs.push_back("--input");
+        jobArgs.push_back(inputPath);
+    }
+    jobArgs.insert(jobArgs.end(), job.args.begin(), job.args.end());
+
+    // the tracer is configured by the arguments of the server. the arguments of the job apply to everything else, until the next job
+    m_cliArgs = parseJobArgs(jobArgs);
+    if (m_cliArgs.inputPaths.empty()) RAYX_EXIT << "error: please provide an input RML file or directory in \"rml\"";
+    seedRandom(m_cliArgs);
+
+    std::vector<fs::path> rmlFilepaths;
+    for (const auto& path : m_cliArgs.inputPaths) collectRmlFiles(path, rmlFilepaths);
+    const auto processed = traceRmlFilesAndExportRays(rmlFilepaths);
+
+    std::string results;
+    for (const auto& rml : processed) {
+        const auto output      = rml.outputFilepath.empty() ? "null" : toJsonString(fs::absolute(rml.outputFilepath).string());
+        const auto outputBytes = rml.outputFilepath.empty() ? 0 : fs::file_size(rml.outputFilepath);
+        results += std::format(R"({}{{"rml": {}, "output": {}, "output_bytes": {}, "elapsed_ms": {}}})", results.empty() ? "" : ", ",
+                               toJsonString(fs::absolute(rml.inputFilepath).string()), output, outputBytes, rml.elapsedTime.count());
+    }
+
+    const auto elapsedTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+    return std::format(R"("status": "ok", "elapsed_ms": {}, "results": [{}])", elapsedTime.count(), results);
+}
+
+fs::path TerminalApp::getOutputFilepath(const fs::path& inputFilepath) {
     fs::path outputFilepath;
     if (m_cliArgs.outputPath) {
         outputFilepath = *m_cliArgs.outputPath;
@@ -350,7 +564,7 @@ fs::path TerminalApp::exportRays(const fs::path& inputFilepath, const std::vecto
     } else {
         outputFilepath = inputFilepath;
     }
-    outputFilepath.replace_extension(m_cliArgs.csv ? ".csv" : ".h5");
+    outputFilepath.replace_extension(m_cliArgs.csv ? ".csv" : m_cliArgs.rayx ? ".rayx" : ".h5");
 
     // Error handling in case provided path does not exist
     auto parent = outputFilepath.parent_path();
@@ -358,20 +572,96 @@ fs::path TerminalApp::exportRays(const fs::path& inputFilepath, const std::vecto
         RAYX_EXIT << "Output directory '" << parent.string() << "' does not exist. Create it first or use a different output path.";
     }
 
+    return outputFilepath;
+}
+
+fs::path TerminalApp::exportRays(const fs::path& inputFilepath, const std::vector<std::string>& objectNames, const RAYX::Rays& rays,
+                                 const RAYX::RayAttrMask attrRecordMask) {
+    RAYX_PROFILE_FUNCTION_STDOUT();
+
+    if (rays.empty()) return {};
+
+    const auto outputFilepath = getOutputFilepath(inputFilepath);
+
     if (m_cliArgs.csv) {
         RAYX::writeCsv(outputFilepath, rays);
         const auto rays2 = RAYX::readCsv(outputFilepath);
         std::cout << (rays == rays2) << std::endl;
+    } else if (m_cliArgs.rayx) {
+        if (m_cliArgs.append && fs::exists(outputFilepath)) {
+            checkAppendEncoding(outputFilepath, toOutputEncoding(m_cliArgs));
+            RAYX::appendRayx(outputFilepath, rays, attrRecordMask);
+        } else {
+            RAYX::writeRayx(outputFilepath, objectNames, rays, attrRecordMask, toOutputEncoding(m_cliArgs));
+        }
     } else {
 #ifdef NO_H5
         RAYX_EXIT << "writeH5 called during NO_H5 (HDF5 disabled during build)";
 #else
-        if (m_cliArgs.append)
+        if (m_cliArgs.append && fs::exists(outputFilepath))
             RAYX::appendH5(outputFilepath, rays, attrRecordMask);
         else
-            RAYX::writeH5(outputFilepath, objectNames, rays, attrRecordMask);
+            RAYX::writeH5(outputFilepath, objectNames, rays, attrRecordMask, true, toH5WriteOptions(m_cliArgs));
 #endif
     }
 
     return outputFilepath;
 }
+
+std::future<fs::path> TerminalApp::traceBeamlineAndWriteH5(const fs::path& inputFilepath, const RAYX::Beamline& beamline,
+                                                           const RAYX::RayAttrMask attrRecordMask, const std::launch policy) {
+    RAYX_PROFILE_FUNCTION_STDOUT();
+
+#ifdef NO_H5
+    RAYX_EXIT << "writeH5 called during NO_H5 (HDF5 disabled during build)";
+    return {};
+#else
+    const auto outputFilepath = getOutputFilepath(inputFilepath);
+
+    // create the file with empty resizable datasets, unless we append to an existing one
+    const auto createFile = !m_cliArgs.append || !fs::exists(outputFilepath);
+    if (createFile) RAYX::writeH5(outputFilepath, beamline.getObjectNames(), RAYX::Rays{}, attrRecordMask, true, toH5WriteOptions(m_cliArgs));
+
+    // the writer thread appends the events of a batch, while the next batch is traced
+    auto writer    = std::make_unique<RAYX::H5AppendWriter>(outputFilepath, attrRecordMask);
+    auto numEvents = int64_t{0};
+    traceBeamline(beamline, attrRecordMask, [&writer, &numEvents](RAYX::Rays&& rays) {
+        numEvents += rays.size();
+        writer->push(std::move(rays));
+    });
+
+    // the last batches are written, while the next file is traced. as in exportRays, nothing is exported if no events were recorded
+    return std::async(policy, [outputFilepath, createFile, numEvents, writer = std::move(writer)] {
+        writer->finish();
+        if (numEvents > 0) return outputFilepath;
+        if (createFile) fs::remove(outputFilepath);
+        return fs::path();
+    });
+#endif
+}
+
+fs::path TerminalApp::traceBeamlineAndWriteRayx(const fs::path& inputFilepath, const RAYX::Beamline& beamline,
+                                                const RAYX::RayAttrMask attrRecordMask) {
+    RAYX_PROFILE_FUNCTION_STDOUT();
+
+    const auto outputFilepath = getOutputFilepath(inputFilepath);
+
+    // create the file without blocks, unless we append to an existing one, whose encoding has to match the command line
+    const auto createFile = !m_cliArgs.append || !fs::exists(outputFilepath);
+    if (createFile)
+        RAYX::writeRayx(outputFilepath, beamline.getObjectNames(), RAYX::Rays{}, attrRecordMask, toOutputEncoding(m_cliArgs));
+    else
+        checkAppendEncoding(outputFilepath, toOutputEncoding(m_cliArgs));
+
+    // every batch is appended directly as a new block, that is encoded with the encoding of the file
+    auto numEvents = int64_t{0};
+    traceBeamline(beamline, attrRecordMask, [&](RAYX::Rays&& rays) {
+        numEvents += rays.size();
+        RAYX::appendRayx(outputFilepath, rays, attrRecordMask);
+    });
+
+    // as in exportRays, nothing is exported if no events were recorded
+    if (numEvents > 0) return outputFilepath;
+    if (createFile) fs::remove(outputFilepath);
+    return {};
+}
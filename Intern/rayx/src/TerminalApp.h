@@ -2,10 +2,14 @@
 
 #include <chrono>
 #include <filesystem>
+#include <future>
+#include <streambuf>
+#include <vector>
 
 #include "Beamline/Beamline.h"
 #include "CommandParser.h"
 #include "Debug/Instrumentor.h"
+#include "JobServer.h"
 #include "Rays.h"
 #include "TerminalAppConfig.h"
 #include "Tracer/Tracer.h"
@@ -18,17 +22,52 @@ class TerminalApp {
     void run();
 
   private:
-    int tracePath(const std::filesystem::path& path);
-    void traceRmlAndExportRays(const std::filesystem::path& path);
+    /// the output file of a processed rml file and the time it took, from loading the beamline until the rays are exported
+    struct ProcessedRml {
+        std::filesystem::path inputFilepath;
+        std::filesystem::path outputFilepath;  // empty, if no rays were exported
+        std::chrono::milliseconds elapsedTime;
+    };
+
+    /// keeps the tracer resident and runs the jobs of --serve, until stdin is closed or a shutdown command is received
+    void serve();
+    /// runs a job of --serve with the tracer of the server
+    /// @returns the members of the json response of the job
+    std::string runJob(const Job& job);
+
+    /// collects the rml files in path, recursively if path is a directory
+    void collectRmlFiles(const std::filesystem::path& path, std::vector<std::filesystem::path>& rmlFilepaths);
+    /// processes the rml files in a pipeline. while a file is traced, the beamlines of the next files are loaded and the rays of the previous
+    /// files are exported on worker threads. --jobs limits the number of files in each stage
+    std::vector<ProcessedRml> traceRmlFilesAndExportRays(const std::vector<std::filesystem::path>& rmlFilepaths);
+    /// traces the beamline and launches the export of its rays with the given policy
+    /// @returns the output filename, once the rays are exported
+    std::future<std::filesystem::path> traceAndExportRays(const std::filesystem::path& inputFilepath, const RAYX::Beamline& beamline,
+                                                          const std::launch policy);
     RAYX::Beamline loadBeamline(const std::filesystem::path& filepath);
-    RAYX::Rays traceBeamline(const RAYX::Beamline& beamline, const RAYX::RayAttrMask attr);
-    void validateEvents(const RAYX::Rays& rays);
+    /// if onBatch is set, the events are passed to it batch by batch and the returned rays are empty
+    RAYX::Rays traceBeamline(const RAYX::Beamline& beamline, const RAYX::RayAttrMask attr, const RAYX::BatchCallback& onBatch = {});
+    void validateEvents(const RAYX::EventTypeMask eventTypes);
+
+    std::filesystem::path getOutputFilepath(const std::filesystem::path& inputFilepath);
 
     /// write rays to file
-    /// @returns the output filename (either .csv or .h5)
+    /// @returns the output filename (either .csv, .rayx or .h5)
     std::filesystem::path exportRays(const std::filesystem::path& filepath, const std::vector<std::string>& objectNames, const RAYX::Rays& rays,
                                      const RAYX::RayAttrMask attr);
 
+    /// trace beamline and write the events of each batch to an h5 file on a writer thread, while the next batch is traced. writing the last
+    /// batches is launched with the given policy
+    /// @returns the output filename, once all batches are written
+    std::future<std::filesystem::path> traceBeamlineAndWriteH5(const std::filesystem::path& filepath, const RAYX::Beamline& beamline,
+                                                               const RAYX::RayAttrMask attr, const std::launch policy);
+
+    /// trace beamline and append the events of each batch as a block to a .rayx file
+    /// @returns the output filename
+    std::filesystem::path traceBeamlineAndWriteRayx(const std::filesystem::path& filepath, const RAYX::Beamline& beamline,
+                                                    const RAYX::RayAttrMask attr);
+
     std::unique_ptr<RAYX::Tracer> m_tracer;
     CliArgs m_cliArgs;
+    std::streambuf* m_responses = nullptr;  // stdout, while --serve writes responses to it and std::cout is redirected to stderr
 };
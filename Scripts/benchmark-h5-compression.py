@@ -0,0 +1,131 @@
+######################################################################
+######################################################################
+# HOW TO USE:
+
+# Install all necessary python modules:
+# python -m pip install h5py numpy pandas
+
+# Compile RAYX in Release mode
+# Run this script from the rayx root directory
+# Optionally pass RML files as arguments. Default: Scripts/benchmark-inputs/MatrixSource.rml
+# A csv file will be created in the benchmark-outputs folder, containing for each
+# combination of H5 output options and each ray attribute:
+# - the write throughput of the whole file (uncompressed MB per second spent in writeH5 and appendH5)
+# - the compression ratio of the attribute (uncompressed size / stored size)
+
+######################################################################
+######################################################################
+
+import sys
+import os
+import subprocess
+import tempfile
+import re
+import platform
+import h5py
+import numpy as np
+import pandas as pd
+from datetime import datetime
+
+
+numberOfRuns = 3
+default_rml_files = ["Scripts/benchmark-inputs/MatrixSource.rml"]
+
+# (name, extra cli arguments)
+h5_options = [
+    ("chunked", ["--h5-chunk-size", "65536"]),
+    ("deflate1", ["--h5-chunk-size", "65536", "--h5-deflate", "1"]),
+    ("deflate4", ["--h5-chunk-size", "65536", "--h5-deflate", "4"]),
+    ("deflate9", ["--h5-chunk-size", "65536", "--h5-deflate", "9"]),
+    ("shuffle+deflate1", ["--h5-chunk-size", "65536", "--h5-shuffle", "--h5-deflate", "1"]),
+    ("shuffle+deflate4", ["--h5-chunk-size", "65536", "--h5-shuffle", "--h5-deflate", "4"]),
+    ("shuffle+deflate9", ["--h5-chunk-size", "65536", "--h5-shuffle", "--h5-deflate", "9"]),
+    ("shuffle+deflate4-chunk1M", ["--h5-chunk-size", "1048576", "--h5-shuffle", "--h5-deflate", "4"]),
+    ("normalized+shuffle+deflate4", ["--h5-chunk-size", "65536", "--h5-normalized", "--h5-shuffle", "--h5-deflate", "4"]),
+]
+
+
+def parse_write_time(result_string):
+    # the file is created by writeH5 and the batches are written by appendH5 on the writer thread
+    # Making \r optional to support both Windows and Linux
+    matches = re.findall(r"BENCH: (?:writeH5|appendH5): \r?\n([\de\-\.]+)s", result_string)
+    return sum(float(time) for time in matches) if matches else np.nan
+
+
+def find_terminal():
+    TerminalApp_Path = "build/bin/release/rayx"
+    if platform.system() == "Windows":
+        TerminalApp_Path += ".exe"
+    path = os.path.join(os.getcwd(), TerminalApp_Path)
+    return os.path.exists(path), path
+
+
+def attribute_sizes(h5_filepath):
+    sizes = {}
+    with h5py.File(h5_filepath, "r") as file:
+        # normalized files store the path attributes and the event offsets of the paths in rayx/paths
+        groups = [group for group in ["rayx/events", "rayx/paths"] if group in file]
+        for group in groups:
+            for name, dataset in file[group].items():
+                uncompressed = dataset.size * dataset.dtype.itemsize
+                stored = dataset.id.get_storage_size()
+                sizes[name] = (uncompressed, stored)
+    return sizes
+
+
+def benchmark(path, rml_file, option_args, output_dir):
+    output_filepath = os.path.join(output_dir, "benchmark.h5")
+    write_times = []
+    for _ in range(numberOfRuns):
+        result = subprocess.run(
+            [path, "-i", rml_file, "-o", output_filepath, "--benchmark", "-f"] + option_args,
+            stdout=subprocess.PIPE,
+            check=True,
+        )
+        write_times.append(parse_write_time(result.stdout.decode("utf-8")))
+    return np.mean(write_times), np.std(write_times), attribute_sizes(output_filepath)
+
+
+def main():
+    exists, path = find_terminal()
+    if not exists:
+        print("Check for build!")
+        return
+
+    rml_files = sys.argv[1:] if len(sys.argv) > 1 else default_rml_files
+
+    rows = []
+    with tempfile.TemporaryDirectory() as output_dir:
+        for rml_file in rml_files:
+            for option_name, option_args in h5_options:
+                print(f"Benchmarking {rml_file} with {option_name}")
+                mean, std_dev, sizes = benchmark(path, rml_file, option_args, output_dir)
+
+                total_uncompressed = sum(uncompressed for uncompressed, _ in sizes.values())
+                throughput = total_uncompressed / (1024**2) / mean
+                for attr, (uncompressed, stored) in sizes.items():
+                    rows.append(
+                        {
+                            "File": os.path.basename(rml_file),
+                            "Options": option_name,
+                            "Attribute": attr,
+                            "Write time mean [s]": mean,
+                            "Write time std_dev [s]": std_dev,
+                            "Write throughput [MB/s]": throughput,
+                            "Uncompressed size [B]": uncompressed,
+                            "Stored size [B]": stored,
+                            "Compression ratio": uncompressed / stored if stored else np.nan,
+                        }
+                    )
+
+    df = pd.DataFrame(rows)
+    print(df.pivot_table(index="Attribute", columns="Options", values="Compression ratio").to_string(float_format="%.2f"))
+    print(df.groupby("Options")["Write throughput [MB/s]"].mean().to_string(float_format="%.1f"))
+
+    now = datetime.now().strftime("%Y%m%d_%H%M%S")
+    df.to_csv(f"Scripts/benchmark-outputs/h5_compression_{now}.csv", index=False)
+
+
+# main
+if __name__ == "__main__":
+    main()